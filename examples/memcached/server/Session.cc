@@ -259,7 +259,8 @@ bool Session::processRequest(StringPiece request)
     }
     outputBuf_.append("END\r\n");
 
-    if (conn_->outputBuffer()->writableBytes() > 65536 + outputBuf_.readableBytes())
+    if (conn_->outputBuffer()->internalCapacity()
+        > 65536 + conn_->outputBuffer()->readableBytes() + outputBuf_.readableBytes())
     {
       LOG_DEBUG << "shrink output buffer from " << conn_->outputBuffer()->internalCapacity();
       conn_->outputBuffer()->shrink(65536 + outputBuf_.readableBytes());
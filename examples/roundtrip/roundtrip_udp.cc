@@ -1,89 +1,58 @@
 #include "muduo/base/Logging.h"
-#include "muduo/net/Channel.h"
 #include "muduo/net/EventLoop.h"
-#include "muduo/net/Socket.h"
-#include "muduo/net/SocketsOps.h"
-#include "muduo/net/TcpClient.h"
-#include "muduo/net/TcpServer.h"
+#include "muduo/net/UdpClient.h"
+#include "muduo/net/UdpServer.h"
 
 #include <stdio.h>
+#include <string.h>
 
 using namespace muduo;
 using namespace muduo::net;
 
 const size_t frameLen = 2*sizeof(int64_t);
 
-int createNonblockingUDP()
-{
-  int sockfd = ::socket(AF_INET, SOCK_DGRAM | SOCK_NONBLOCK | SOCK_CLOEXEC, IPPROTO_UDP);
-  if (sockfd < 0)
-  {
-    LOG_SYSFATAL << "::socket";
-  }
-  return sockfd;
-}
-
 /////////////////////////////// Server ///////////////////////////////
 
-void serverReadCallback(int sockfd, muduo::Timestamp receiveTime)
+void serverMessageCallback(const UdpSocketPtr& sock,
+                           const InetAddress& peer,
+                           StringPiece datagram,
+                           muduo::Timestamp receiveTime)
 {
-  int64_t message[2];
-  struct sockaddr peerAddr;
-  memZero(&peerAddr, sizeof peerAddr);
-  socklen_t addrLen = sizeof peerAddr;
-  ssize_t nr = ::recvfrom(sockfd, message, sizeof message, 0, &peerAddr, &addrLen);
-
-  char addrStr[64];
-  sockets::toIpPort(addrStr, sizeof addrStr, &peerAddr);
-  LOG_DEBUG << "received " << nr << " bytes from " << addrStr;
+  LOG_DEBUG << "received " << datagram.size() << " bytes from " << peer.toIpPort();
 
-  if (nr < 0)
-  {
-    LOG_SYSERR << "::recvfrom";
-  }
-  else if (implicit_cast<size_t>(nr) == frameLen)
+  if (implicit_cast<size_t>(datagram.size()) == frameLen)
   {
+    int64_t message[2];
+    memcpy(message, datagram.data(), sizeof message);
     message[1] = receiveTime.microSecondsSinceEpoch();
-    ssize_t nw = ::sendto(sockfd, message, sizeof message, 0, &peerAddr, addrLen);
-    if (nw < 0)
-    {
-      LOG_SYSERR << "::sendto";
-    }
-    else if (implicit_cast<size_t>(nw) != frameLen)
-    {
-      LOG_ERROR << "Expect " << frameLen << " bytes, wrote " << nw << " bytes.";
-    }
+    sock->send(peer, StringPiece(reinterpret_cast<const char*>(message), sizeof message));
   }
   else
   {
-    LOG_ERROR << "Expect " << frameLen << " bytes, received " << nr << " bytes.";
+    LOG_ERROR << "Expect " << frameLen << " bytes, received " << datagram.size() << " bytes.";
   }
 }
 
 void runServer(uint16_t port)
 {
-  Socket sock(createNonblockingUDP());
-  sock.bindAddress(InetAddress(port));
   EventLoop loop;
-  Channel channel(&loop, sock.fd());
-  channel.setReadCallback(std::bind(&serverReadCallback, sock.fd(), _1));
-  channel.enableReading();
+  UdpServer server(&loop, InetAddress(port), "RoundTripUdp");
+  server.setMessageCallback(serverMessageCallback);
+  server.start();
   loop.loop();
 }
 
 /////////////////////////////// Client ///////////////////////////////
 
-void clientReadCallback(int sockfd, muduo::Timestamp receiveTime)
+void clientMessageCallback(const UdpSocketPtr&,
+                           const InetAddress&,
+                           StringPiece datagram,
+                           muduo::Timestamp receiveTime)
 {
-  int64_t message[2];
-  ssize_t nr = sockets::read(sockfd, message, sizeof message);
-
-  if (nr < 0)
-  {
-    LOG_SYSERR << "::read";
-  }
-  else if (implicit_cast<size_t>(nr) == frameLen)
+  if (implicit_cast<size_t>(datagram.size()) == frameLen)
   {
+    int64_t message[2];
+    memcpy(message, datagram.data(), sizeof message);
     int64_t send = message[0];
     int64_t their = message[1];
     int64_t back = receiveTime.microSecondsSinceEpoch();
@@ -93,39 +62,27 @@ void clientReadCallback(int sockfd, muduo::Timestamp receiveTime)
   }
   else
   {
-    LOG_ERROR << "Expect " << frameLen << " bytes, received " << nr << " bytes.";
+    LOG_ERROR << "Expect " << frameLen << " bytes, received " << datagram.size() << " bytes.";
   }
 }
 
-void sendMyTime(int sockfd)
+void sendMyTime(UdpClient* client)
 {
   int64_t message[2] = { 0, 0 };
   message[0] = Timestamp::now().microSecondsSinceEpoch();
-  ssize_t nw = sockets::write(sockfd, message, sizeof message);
-  if (nw < 0)
-  {
-    LOG_SYSERR << "::write";
-  }
-  else if (implicit_cast<size_t>(nw) != frameLen)
-  {
-    LOG_ERROR << "Expect " << frameLen << " bytes, wrote " << nw << " bytes.";
-  }
+  client->send(StringPiece(reinterpret_cast<const char*>(message), sizeof message));
 }
 
 void runClient(const char* ip, uint16_t port)
 {
-  Socket sock(createNonblockingUDP());
-  InetAddress serverAddr(ip, port);
-  int ret = sockets::connect(sock.fd(), serverAddr.getSockAddr());
-  if (ret < 0)
+  EventLoop loop;
+  UdpClient client(&loop, InetAddress(ip, port), "RoundTripUdp");
+  client.setMessageCallback(clientMessageCallback);
+  if (!client.connect())
   {
-    LOG_SYSFATAL << "::connect";
+    LOG_FATAL << "connect";
   }
-  EventLoop loop;
-  Channel channel(&loop, sock.fd());
-  channel.setReadCallback(std::bind(&clientReadCallback, sock.fd(), _1));
-  channel.enableReading();
-  loop.runEvery(0.2, std::bind(sendMyTime, sock.fd()));
+  loop.runEvery(0.2, std::bind(sendMyTime, &client));
   loop.loop();
 }
 
@@ -148,4 +105,3 @@ int main(int argc, char* argv[])
     printf("Usage:\n%s -s port\n%s ip port\n", argv[0], argv[0]);
   }
 }
-
@@ -8,6 +8,8 @@
 
 #include "muduo/base/Types.h"
 
+#include <vector>
+
 namespace muduo
 {
 namespace CurrentThread
@@ -47,6 +49,9 @@ namespace CurrentThread
 
   void sleepUsec(int64_t usec);  // for testing
 
+  /// Pins the calling thread to these CPUs, returns false on failure.
+  bool setCpuAffinity(const std::vector<int>& cpus);
+
   string stackTrace(bool demangle);
 }  // namespace CurrentThread
 }  // namespace muduo
@@ -0,0 +1,110 @@
+// Use of this source code is governed by a BSD-style license
+// that can be found in the License file.
+
+#ifndef MUDUO_BASE_HISTOGRAM_H
+#define MUDUO_BASE_HISTOGRAM_H
+
+#include "muduo/base/noncopyable.h"
+
+#include <atomic>
+
+#include <stdint.h>
+
+namespace muduo
+{
+
+///
+/// Counts non-negative values in power of 2 buckets, eg. latencies in
+/// microseconds. Bucket 0 is for 0, bucket i for [2^(i-1), 2^i).
+///
+/// One thread adds, so add() is a few plain loads and stores, other
+/// threads may read at any time, and see a recent state.
+///
+class Histogram : noncopyable
+{
+ public:
+  static const int kBuckets = 32;
+
+  Histogram()
+    : count_(0), sum_(0), max_(0)
+  {
+    for (int i = 0; i < kBuckets; ++i)
+    {
+      buckets_[i] = 0;
+    }
+  }
+
+  /// Writer thread only.
+  void add(int64_t value)
+  {
+    if (value < 0)
+    {
+      value = 0;
+    }
+    inc(&buckets_[bucketOf(value)], 1);
+    inc(&count_, 1);
+    inc(&sum_, value);
+    if (value > max_.load(std::memory_order_relaxed))
+    {
+      max_.store(value, std::memory_order_relaxed);
+    }
+  }
+
+  int64_t count() const { return count_.load(std::memory_order_relaxed); }
+  int64_t sum() const { return sum_.load(std::memory_order_relaxed); }
+  int64_t max() const { return max_.load(std::memory_order_relaxed); }
+  double average() const
+  {
+    int64_t n = count();
+    return n > 0 ? static_cast<double>(sum()) / static_cast<double>(n) : 0.0;
+  }
+
+  int64_t bucketCount(int i) const
+  { return buckets_[i].load(std::memory_order_relaxed); }
+
+  /// Largest value of bucket @c i.
+  static int64_t bucketLimit(int i)
+  { return i == 0 ? 0 : (i == kBuckets-1 ? INT64_MAX : (int64_t(1) << i) - 1); }
+
+  static int bucketOf(int64_t value)
+  {
+    int i = value == 0 ? 0 : 64 - __builtin_clzll(static_cast<uint64_t>(value));
+    return i < kBuckets ? i : kBuckets-1;
+  }
+
+  /// Upper bound of @c p (0.0 to 1.0) of values, by bucket, and no more than max().
+  int64_t percentile(double p) const
+  {
+    int64_t n = count();
+    if (n == 0)
+    {
+      return 0;
+    }
+    int64_t rank = static_cast<int64_t>(p * static_cast<double>(n));
+    int64_t seen = 0;
+    for (int i = 0; i < kBuckets; ++i)
+    {
+      seen += bucketCount(i);
+      if (seen > rank)
+      {
+        return bucketLimit(i) < max() ? bucketLimit(i) : max();
+      }
+    }
+    return max();
+  }
+
+ private:
+  static void inc(std::atomic<int64_t>* x, int64_t delta)
+  {
+    x->store(x->load(std::memory_order_relaxed) + delta, std::memory_order_relaxed);
+  }
+
+  std::atomic<int64_t> buckets_[kBuckets];
+  std::atomic<int64_t> count_;
+  std::atomic<int64_t> sum_;
+  std::atomic<int64_t> max_;
+};
+
+}  // namespace muduo
+
+#endif  // MUDUO_BASE_HISTOGRAM_H
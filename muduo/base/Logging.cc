@@ -107,6 +107,7 @@ void defaultFlush()
 
 Logger::OutputFunc g_output = defaultOutput;
 Logger::FlushFunc g_flush = defaultFlush;
+Logger::ClockFunc g_clock = Timestamp::now;
 TimeZone g_logTimeZone;
 
 }  // namespace muduo
@@ -114,7 +115,7 @@ TimeZone g_logTimeZone;
 using namespace muduo;
 
 Logger::Impl::Impl(LogLevel level, int savedErrno, const SourceFile& file, int line)
-  : time_(Timestamp::now()),
+  : time_(g_clock()),
     stream_(),
     level_(level),
     line_(line),
@@ -220,6 +221,11 @@ void Logger::setFlush(FlushFunc flush)
   g_flush = flush;
 }
 
+void Logger::setClock(ClockFunc clock)
+{
+  g_clock = clock;
+}
+
 void Logger::setTimeZone(const TimeZone& tz)
 {
   g_logTimeZone = tz;
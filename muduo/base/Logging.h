@@ -73,8 +73,12 @@ class Logger
 
   typedef void (*OutputFunc)(const char* msg, int len);
   typedef void (*FlushFunc)();
+  typedef Timestamp (*ClockFunc)();
   static void setOutput(OutputFunc);
   static void setFlush(FlushFunc);
+  /// Time of log lines, Timestamp::now() by default.
+  /// EventLoop::cachedNow() saves a clock read per line.
+  static void setClock(ClockFunc);
   static void setTimeZone(const TimeZone& tz);
 
  private:
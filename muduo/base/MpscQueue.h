@@ -0,0 +1,167 @@
+// Use of this source code is governed by a BSD-style license
+// that can be found in the License file.
+
+#ifndef MUDUO_BASE_MPSCQUEUE_H
+#define MUDUO_BASE_MPSCQUEUE_H
+
+#include "muduo/base/noncopyable.h"
+
+#include <atomic>
+#include <utility>
+
+#include <stddef.h>
+
+namespace muduo
+{
+
+///
+/// Unbounded lock-free queue, many producers and one consumer.
+///
+/// Dmitry Vyukov's node based queue: push() is one atomic exchange and
+/// never waits. pop() may miss an element whose push() is half done,
+/// the producer is expected to notify the consumer afterwards.
+///
+/// Popped nodes are kept in a free list, up to kMaxFreeNodes, for later
+/// pushes, so a queue in steady use does not allocate.
+///
+template<typename T>
+class MpscQueue : noncopyable
+{
+ public:
+  static const size_t kMaxFreeNodes = 1024;
+
+  MpscQueue()
+    : head_(new Node),
+      tail_(head_.load()),
+      size_(0),
+      freeList_(NULL),
+      freeNodes_(0)
+  {
+    freeListLocked_.clear();
+  }
+
+  ~MpscQueue()
+  {
+    T x;
+    while (pop(&x))
+    {
+    }
+    delete tail_;
+    Node* node = freeList_.load();
+    while (node)
+    {
+      Node* next = node->next.load(std::memory_order_relaxed);
+      delete node;
+      node = next;
+    }
+  }
+
+  /// Thread safe.
+  void push(T x)
+  {
+    Node* node = takeFreeNode();
+    if (node)
+    {
+      node->value = std::move(x);
+      node->next.store(NULL, std::memory_order_relaxed);
+    }
+    else
+    {
+      node = new Node(std::move(x));
+    }
+    size_.fetch_add(1, std::memory_order_relaxed);
+    Node* prev = head_.exchange(node);
+    prev->next.store(node, std::memory_order_release);
+  }
+
+  /// Consumer thread only.
+  bool pop(T* x)
+  {
+    Node* tail = tail_;
+    Node* next = tail->next.load(std::memory_order_acquire);
+    if (next == NULL)
+    {
+      return false;
+    }
+    *x = std::move(next->value);
+    tail_ = next;  // becomes the dummy node
+    size_.fetch_sub(1, std::memory_order_relaxed);
+    recycle(tail);
+    return true;
+  }
+
+  /// Consumer thread only, includes pushes in progress.
+  bool empty() const
+  {
+    return head_.load() == tail_;
+  }
+
+  /// Thread safe, approximate.
+  size_t size() const
+  {
+    return size_.load(std::memory_order_relaxed);
+  }
+
+ private:
+  struct Node
+  {
+    Node() : value(), next(NULL) {}
+    explicit Node(T&& x) : value(std::move(x)), next(NULL) {}
+
+    T value;
+    std::atomic<Node*> next;  // in the queue, or in the free list
+  };
+
+  // Producers take nodes one at a time, under freeListLocked_, or the
+  // next one could be taken and given back in between, the ABA problem.
+  // A producer which finds it held allocates instead of waiting.
+  Node* takeFreeNode()
+  {
+    if (freeListLocked_.test_and_set(std::memory_order_acquire))
+    {
+      return NULL;
+    }
+    Node* node = freeList_.load(std::memory_order_acquire);
+    while (node &&
+           !freeList_.compare_exchange_weak(node,
+                                            node->next.load(std::memory_order_relaxed),
+                                            std::memory_order_acquire))
+    {
+    }
+    freeListLocked_.clear(std::memory_order_release);
+    if (node)
+    {
+      freeNodes_.fetch_sub(1, std::memory_order_relaxed);
+    }
+    return node;
+  }
+
+  // Consumer thread only, pushes without the lock, which only guards takes.
+  void recycle(Node* node)
+  {
+    if (freeNodes_.load(std::memory_order_relaxed) >= kMaxFreeNodes)
+    {
+      delete node;
+      return;
+    }
+    node->value = T();  // frees what the moved-from value still holds
+    freeNodes_.fetch_add(1, std::memory_order_relaxed);
+    Node* top = freeList_.load(std::memory_order_relaxed);
+    do
+    {
+      node->next.store(top, std::memory_order_relaxed);
+    } while (!freeList_.compare_exchange_weak(top, node, std::memory_order_release,
+                                              std::memory_order_relaxed));
+  }
+
+  std::atomic<Node*> head_;  // last pushed
+  Node* tail_;  // dummy, its next is the first one
+  std::atomic<size_t> size_;
+  std::atomic<Node*> freeList_;
+  std::atomic_flag freeListLocked_;
+  std::atomic<size_t> freeNodes_;  // approximate
+};
+
+}  // namespace muduo
+
+#endif  // MUDUO_BASE_MPSCQUEUE_H
@@ -12,8 +12,10 @@
 #include <assert.h>
 #include <dirent.h>
 #include <pwd.h>
+#include <sched.h>
 #include <stdio.h> // snprintf
 #include <stdlib.h>
+#include <string.h>
 #include <unistd.h>
 #include <sys/resource.h>
 #include <sys/times.h>
@@ -42,6 +44,16 @@ int taskDirFilter(const struct dirent* d)
   return 0;
 }
 
+__thread int t_numaNode = -1;
+int cpuDirFilter(const struct dirent* d)
+{
+  if (::strncmp(d->d_name, "node", 4) == 0 && ::isdigit(d->d_name[4]))
+  {
+    t_numaNode = atoi(d->d_name + 4);
+  }
+  return 0;
+}
+
 int scanDir(const char *dirpath, int (*filter)(const struct dirent *))
 {
   struct dirent** namelist = NULL;
@@ -244,3 +256,61 @@ std::vector<pid_t> ProcessInfo::threads()
   return result;
 }
 
+std::vector<int> ProcessInfo::cpuAffinity(pid_t tid)
+{
+  std::vector<int> result;
+  cpu_set_t set;
+  CPU_ZERO(&set);
+  if (::sched_getaffinity(tid, sizeof set, &set) == 0)
+  {
+    for (int cpu = 0; cpu < CPU_SETSIZE; ++cpu)
+    {
+      if (CPU_ISSET(cpu, &set))
+      {
+        result.push_back(cpu);
+      }
+    }
+  }
+  return result;
+}
+
+int ProcessInfo::numaNodeOfCpu(int cpu)
+{
+  char path[64];
+  snprintf(path, sizeof path, "/sys/devices/system/cpu/cpu%d", cpu);
+  t_numaNode = -1;
+  scanDir(path, cpuDirFilter);
+  return t_numaNode;
+}
+
+std::vector<int> ProcessInfo::cpusOfNumaNode(int node)
+{
+  char path[64];
+  snprintf(path, sizeof path, "/sys/devices/system/node/node%d/cpulist", node);
+  string cpulist;
+  FileUtil::readFile(path, 4096, &cpulist);
+  return parseCpuList(cpulist);
+}
+
+std::vector<int> ProcessInfo::parseCpuList(const string& cpulist)
+{
+  std::vector<int> result;
+  const char* p = cpulist.c_str();
+  while (::isdigit(*p))
+  {
+    char* end = NULL;
+    long first = ::strtol(p, &end, 10);
+    long last = first;
+    if (*end == '-')
+    {
+      last = ::strtol(end + 1, &end, 10);
+    }
+    for (long cpu = first; cpu <= last; ++cpu)
+    {
+      result.push_back(static_cast<int>(cpu));
+    }
+    p = *end == ',' ? end + 1 : end;
+  }
+  return result;
+}
+
@@ -61,6 +61,15 @@ namespace ProcessInfo
 
   int numThreads();
   std::vector<pid_t> threads();
+
+  /// CPUs the thread may run on, empty on failure.
+  std::vector<int> cpuAffinity(pid_t tid);
+  /// NUMA node of the CPU, -1 if unknown.
+  int numaNodeOfCpu(int cpu);
+  /// CPUs of the NUMA node, empty if unknown.
+  std::vector<int> cpusOfNumaNode(int node);
+  /// CPUs of a cpulist of sysfs, eg. "0-3,8-11".
+  std::vector<int> parseCpuList(const string& cpulist);
 }  // namespace ProcessInfo
 
 }  // namespace muduo
@@ -0,0 +1,237 @@
+// Use of this source code is governed by a BSD-style license
+// that can be found in the License file.
+
+#ifndef MUDUO_BASE_TASK_H
+#define MUDUO_BASE_TASK_H
+
+#include <cstddef>
+#include <functional>
+#include <new>
+#include <type_traits>
+#include <typeinfo>
+#include <utility>
+
+namespace muduo
+{
+
+///
+/// A move-only void() callable, like std::function<void()> but it
+/// holds callables up to kInlineSize bytes without allocating, eg.
+/// std::bind of a member function, a shared_ptr and two more words.
+/// Larger ones are kept on the heap.
+///
+/// Being move-only, it also holds move-only state,
+/// eg. std::bind(f, std::unique_ptr<T>(p)).
+///
+class Task
+{
+ public:
+  /// sizeof(Task) is one cache line.
+  static const size_t kInlineSize = 64 - sizeof(void*);
+
+  Task() noexcept
+    : ops_(NULL)
+  {
+  }
+
+  Task(std::nullptr_t) noexcept  // NOLINT, like std::function
+    : ops_(NULL)
+  {
+  }
+
+  template<typename F,
+           typename = typename std::enable_if<
+               !std::is_same<typename std::decay<F>::type, Task>::value>::type>
+  Task(F&& f)  // NOLINT, implicit like std::function
+    : ops_(NULL)
+  {
+    typedef typename std::decay<F>::type Callable;
+    if (!isNull(static_cast<const Callable&>(f)))
+    {
+      construct<Callable>(std::forward<F>(f),
+                          std::integral_constant<bool, storedInline<Callable>()>());
+    }
+  }
+
+  Task(Task&& rhs) noexcept
+    : ops_(rhs.ops_)
+  {
+    if (ops_)
+    {
+      ops_->move(&storage_, &rhs.storage_);
+      rhs.ops_ = NULL;
+    }
+  }
+
+  Task& operator=(Task&& rhs) noexcept
+  {
+    if (this != &rhs)
+    {
+      reset();
+      if (rhs.ops_)
+      {
+        rhs.ops_->move(&storage_, &rhs.storage_);
+        ops_ = rhs.ops_;
+        rhs.ops_ = NULL;
+      }
+    }
+    return *this;
+  }
+
+  Task& operator=(std::nullptr_t) noexcept
+  {
+    reset();
+    return *this;
+  }
+
+  Task(const Task&) = delete;
+  Task& operator=(const Task&) = delete;
+
+  ~Task()
+  {
+    reset();
+  }
+
+  void swap(Task& rhs) noexcept
+  {
+    Task tmp(std::move(rhs));
+    rhs = std::move(*this);
+    *this = std::move(tmp);
+  }
+
+  explicit operator bool() const noexcept
+  { return ops_ != NULL; }
+
+  /// Must not be empty.
+  void operator()() const
+  {
+    ops_->invoke(&storage_);
+  }
+
+  /// Type of the callable, typeid(void) if empty, eg. for logging.
+  const std::type_info& targetType() const
+  { return ops_ ? ops_->type() : typeid(void); }
+
+  /// True if a callable of type F is held without allocating.
+  template<typename F>
+  static constexpr bool storedInline()
+  {
+    return sizeof(F) <= kInlineSize
+        && alignof(F) <= alignof(Storage)
+        && std::is_nothrow_move_constructible<F>::value;
+  }
+
+ private:
+  typedef typename std::aligned_storage<kInlineSize, alignof(void*)>::type Storage;
+
+  struct Ops
+  {
+    void (*invoke)(void* storage);
+    // move constructs dst from src, destroys src
+    void (*move)(void* dst, void* src);
+    void (*destroy)(void* storage);
+    const std::type_info& (*type)();
+  };
+
+  template<typename F>
+  static const std::type_info& typeOf()
+  { return typeid(F); }
+
+  template<typename F>
+  struct InlineOps
+  {
+    static void invoke(void* storage)
+    { (*static_cast<F*>(storage))(); }
+
+    static void move(void* dst, void* src)
+    {
+      F* f = static_cast<F*>(src);
+      new (dst) F(std::move(*f));
+      f->~F();
+    }
+
+    static void destroy(void* storage)
+    { static_cast<F*>(storage)->~F(); }
+
+    static const Ops ops;
+  };
+
+  template<typename F>
+  struct HeapOps
+  {
+    static F* get(void* storage)
+    { return *static_cast<F**>(storage); }
+
+    static void invoke(void* storage)
+    { (*get(storage))(); }
+
+    static void move(void* dst, void* src)
+    { *static_cast<F**>(dst) = get(src); }
+
+    static void destroy(void* storage)
+    { delete get(storage); }
+
+    static const Ops ops;
+  };
+
+  template<typename Callable, typename F>
+  void construct(F&& f, std::true_type /* inline */)
+  {
+    new (&storage_) Callable(std::forward<F>(f));
+    ops_ = &InlineOps<Callable>::ops;
+  }
+
+  template<typename Callable, typename F>
+  void construct(F&& f, std::false_type /* inline */)
+  {
+    *reinterpret_cast<Callable**>(&storage_) = new Callable(std::forward<F>(f));
+    ops_ = &HeapOps<Callable>::ops;
+  }
+
+  // empty std::function or NULL function pointer makes an empty Task
+  template<typename F>
+  static bool isNull(const F&)
+  { return false; }
+
+  template<typename R, typename... Args>
+  static bool isNull(R (*const& f)(Args...))
+  { return f == NULL; }
+
+  template<typename R, typename... Args>
+  static bool isNull(const std::function<R(Args...)>& f)
+  { return !f; }
+
+  void reset() noexcept
+  {
+    if (ops_)
+    {
+      ops_->destroy(&storage_);
+      ops_ = NULL;
+    }
+  }
+
+  mutable Storage storage_;
+  const Ops* ops_;
+};
+
+template<typename F>
+const Task::Ops Task::InlineOps<F>::ops =
+{
+  &Task::InlineOps<F>::invoke,
+  &Task::InlineOps<F>::move,
+  &Task::InlineOps<F>::destroy,
+  &Task::typeOf<F>,
+};
+
+template<typename F>
+const Task::Ops Task::HeapOps<F>::ops =
+{
+  &Task::HeapOps<F>::invoke,
+  &Task::HeapOps<F>::move,
+  &Task::HeapOps<F>::destroy,
+  &Task::typeOf<F>,
+};
+
+}  // namespace muduo
+
+#endif  // MUDUO_BASE_TASK_H
@@ -11,6 +11,7 @@
 #include <type_traits>
 
 #include <errno.h>
+#include <sched.h>
 #include <stdio.h>
 #include <unistd.h>
 #include <sys/prctl.h>
@@ -54,15 +55,18 @@ struct ThreadData
   typedef muduo::Thread::ThreadFunc ThreadFunc;
   ThreadFunc func_;
   string name_;
+  std::vector<int> cpus_;
   pid_t* tid_;
   CountDownLatch* latch_;
 
   ThreadData(ThreadFunc func,
              const string& name,
+             const std::vector<int>& cpus,
              pid_t* tid,
              CountDownLatch* latch)
     : func_(std::move(func)),
       name_(name),
+      cpus_(cpus),
       tid_(tid),
       latch_(latch)
   { }
@@ -71,6 +75,10 @@ struct ThreadData
   {
     *tid_ = muduo::CurrentThread::tid();
     tid_ = NULL;
+    if (!cpus_.empty())
+    {
+      muduo::CurrentThread::setCpuAffinity(cpus_);
+    }
     latch_->countDown();
     latch_ = NULL;
 
@@ -137,6 +145,29 @@ void CurrentThread::sleepUsec(int64_t usec)
   ::nanosleep(&ts, NULL);
 }
 
+bool CurrentThread::setCpuAffinity(const std::vector<int>& cpus)
+{
+  cpu_set_t set;
+  CPU_ZERO(&set);
+  for (int cpu : cpus)
+  {
+    if (cpu < 0 || cpu >= CPU_SETSIZE)
+    {
+      LOG_ERROR << "CurrentThread::setCpuAffinity - invalid cpu " << cpu;
+      return false;
+    }
+    CPU_SET(cpu, &set);
+  }
+  int err = ::pthread_setaffinity_np(::pthread_self(), sizeof set, &set);
+  if (err != 0)
+  {
+    errno = err;
+    LOG_SYSERR << "CurrentThread::setCpuAffinity";
+    return false;
+  }
+  return true;
+}
+
 AtomicInt32 Thread::numCreated_;
 
 Thread::Thread(ThreadFunc func, const string& n)
@@ -175,7 +206,7 @@ void Thread::start()
   assert(!started_);
   started_ = true;
   // FIXME: move(func_)
-  detail::ThreadData* data = new detail::ThreadData(func_, name_, &tid_, &latch_);
+  detail::ThreadData* data = new detail::ThreadData(func_, name_, cpus_, &tid_, &latch_);
   if (pthread_create(&pthreadId_, NULL, &detail::startThread, data))
   {
     started_ = false;
@@ -12,6 +12,7 @@
 
 #include <functional>
 #include <memory>
+#include <vector>
 #include <pthread.h>
 
 namespace muduo
@@ -29,6 +30,12 @@ class Thread : noncopyable
   void start();
   int join(); // return pthread_join()
 
+  /// Pins the thread to these CPUs before running func, so that memory
+  /// it touches first comes from the local NUMA node.
+  /// Must be called before start().
+  void setCpuAffinity(const std::vector<int>& cpus) { cpus_ = cpus; }
+  const std::vector<int>& cpuAffinity() const { return cpus_; }
+
   bool started() const { return started_; }
   // pthread_t pthreadId() const { return pthreadId_; }
   pid_t tid() const { return tid_; }
@@ -45,6 +52,7 @@ class Thread : noncopyable
   pid_t      tid_;
   ThreadFunc func_;
   string     name_;
+  std::vector<int> cpus_;
   CountDownLatch latch_;
 
   static AtomicInt32 numCreated_;
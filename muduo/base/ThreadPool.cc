@@ -41,6 +41,10 @@ void ThreadPool::start(int numThreads)
     snprintf(id, sizeof id, "%d", i+1);
     threads_.emplace_back(new muduo::Thread(
           std::bind(&ThreadPool::runInThread, this), name_+id));
+    if (!cpus_.empty())
+    {
+      threads_[i]->setCpuAffinity(std::vector<int>(1, cpus_[static_cast<size_t>(i) % cpus_.size()]));
+    }
     threads_[i]->start();
   }
   if (numThreads == 0 && threadInitCallback_)
@@ -101,7 +105,7 @@ ThreadPool::Task ThreadPool::take()
   Task task;
   if (!queue_.empty())
   {
-    task = queue_.front();
+    task = std::move(queue_.front());
     queue_.pop_front();
     if (maxQueueSize_ > 0)
     {
@@ -8,6 +8,7 @@
 
 #include "muduo/base/Condition.h"
 #include "muduo/base/Mutex.h"
+#include "muduo/base/Task.h"
 #include "muduo/base/Thread.h"
 #include "muduo/base/Types.h"
 
@@ -20,15 +21,18 @@ namespace muduo
 class ThreadPool : noncopyable
 {
  public:
-  typedef std::function<void ()> Task;
+  typedef muduo::Task Task;  // move-only
 
   explicit ThreadPool(const string& nameArg = string("ThreadPool"));
   ~ThreadPool();
 
   // Must be called before start().
   void setMaxQueueSize(int maxSize) { maxQueueSize_ = maxSize; }
-  void setThreadInitCallback(const Task& cb)
-  { threadInitCallback_ = cb; }
+  void setThreadInitCallback(Task cb)
+  { threadInitCallback_ = std::move(cb); }
+  /// Pins thread i to cpus[i % cpus.size()].
+  void setCpuAffinity(const std::vector<int>& cpus)
+  { cpus_ = cpus; }
 
   void start(int numThreads);
   void stop();
@@ -40,10 +44,7 @@ class ThreadPool : noncopyable
 
   // Could block if maxQueueSize > 0
   // Call after stop() will return immediately.
-  // There is no move-only version of std::function in C++ as of C++14.
-  // So we don't need to overload a const& and an && versions
-  // as we do in (Bounded)BlockingQueue.
-  // https://stackoverflow.com/a/25408989
+  // Task is move-only, and small ones are queued without allocating.
   void run(Task f);
 
  private:
@@ -56,6 +57,7 @@ class ThreadPool : noncopyable
   Condition notFull_ GUARDED_BY(mutex_);
   string name_;
   Task threadInitCallback_;
+  std::vector<int> cpus_;
   std::vector<std::unique_ptr<muduo::Thread>> threads_;
   std::deque<Task> queue_ GUARDED_BY(mutex_);
   size_t maxQueueSize_;
@@ -0,0 +1,76 @@
+#include "muduo/base/ProcessInfo.h"
+
+#include "muduo/base/CurrentThread.h"
+#include "muduo/base/Thread.h"
+
+#include <algorithm>
+#include <vector>
+
+#include <sched.h>
+
+//#define BOOST_TEST_MODULE CpuAffinityTest
+#define BOOST_TEST_MAIN
+#define BOOST_TEST_DYN_LINK
+#include <boost/test/unit_test.hpp>
+
+using muduo::Thread;
+namespace CurrentThread = muduo::CurrentThread;
+namespace ProcessInfo = muduo::ProcessInfo;
+
+BOOST_AUTO_TEST_CASE(testParseCpuList)
+{
+  std::vector<int> expected = { 0, 1, 2, 3, 8, 10, 11 };
+  std::vector<int> cpus = ProcessInfo::parseCpuList("0-3,8,10-11\n");
+  BOOST_CHECK_EQUAL_COLLECTIONS(cpus.begin(), cpus.end(), expected.begin(), expected.end());
+
+  BOOST_CHECK(ProcessInfo::parseCpuList("").empty());
+  BOOST_CHECK_EQUAL(ProcessInfo::parseCpuList("5").size(), 1u);
+  BOOST_CHECK_EQUAL(ProcessInfo::parseCpuList("5").front(), 5);
+}
+
+BOOST_AUTO_TEST_CASE(testThreadAffinity)
+{
+  const std::vector<int> allowed = ProcessInfo::cpuAffinity(CurrentThread::tid());
+  BOOST_REQUIRE(!allowed.empty());
+  // the last one, so that it is not the default cpu 0
+  const int cpu = allowed.back();
+
+  // checked here, as Boost.Test is not thread safe
+  pid_t tid = 0;
+  std::vector<int> affinity;
+  int running = -1;
+  Thread thread([&] {
+    tid = CurrentThread::tid();
+    affinity = ProcessInfo::cpuAffinity(CurrentThread::tid());
+    running = ::sched_getcpu();
+  }, "Pinned");
+  thread.setCpuAffinity(std::vector<int>(1, cpu));
+  thread.start();
+  thread.join();
+
+  BOOST_CHECK_EQUAL(tid, thread.tid());
+  BOOST_REQUIRE_EQUAL(affinity.size(), 1u);
+  BOOST_CHECK_EQUAL(affinity.front(), cpu);
+  BOOST_CHECK_EQUAL(running, cpu);
+
+  // only that thread is pinned
+  std::vector<int> after = ProcessInfo::cpuAffinity(CurrentThread::tid());
+  BOOST_CHECK_EQUAL_COLLECTIONS(after.begin(), after.end(), allowed.begin(), allowed.end());
+
+  BOOST_CHECK(!CurrentThread::setCpuAffinity(std::vector<int>(1, -1)));
+}
+
+BOOST_AUTO_TEST_CASE(testNumaNodes)
+{
+  for (int cpu : ProcessInfo::cpuAffinity(CurrentThread::tid()))
+  {
+    const int node = ProcessInfo::numaNodeOfCpu(cpu);
+    if (node < 0)
+    {
+      BOOST_TEST_MESSAGE("no NUMA node for cpu " << cpu << ", skipped");
+      continue;
+    }
+    std::vector<int> cpus = ProcessInfo::cpusOfNumaNode(node);
+    BOOST_CHECK(std::find(cpus.begin(), cpus.end(), cpu) != cpus.end());
+  }
+}
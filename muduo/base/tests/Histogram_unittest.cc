@@ -0,0 +1,56 @@
+#include "muduo/base/Histogram.h"
+
+//#define BOOST_TEST_MODULE HistogramTest
+#define BOOST_TEST_MAIN
+#define BOOST_TEST_DYN_LINK
+#include <boost/test/unit_test.hpp>
+
+using muduo::Histogram;
+
+BOOST_AUTO_TEST_CASE(testBuckets)
+{
+  BOOST_CHECK_EQUAL(Histogram::bucketOf(0), 0);
+  BOOST_CHECK_EQUAL(Histogram::bucketOf(1), 1);
+  BOOST_CHECK_EQUAL(Histogram::bucketOf(2), 2);
+  BOOST_CHECK_EQUAL(Histogram::bucketOf(3), 2);
+  BOOST_CHECK_EQUAL(Histogram::bucketOf(4), 3);
+  BOOST_CHECK_EQUAL(Histogram::bucketOf(1023), 10);
+  BOOST_CHECK_EQUAL(Histogram::bucketOf(1024), 11);
+  BOOST_CHECK_EQUAL(Histogram::bucketOf(INT64_MAX), Histogram::kBuckets-1);
+  for (int i = 0; i < Histogram::kBuckets-1; ++i)
+  {
+    BOOST_CHECK_EQUAL(Histogram::bucketOf(Histogram::bucketLimit(i)), i);
+    BOOST_CHECK_EQUAL(Histogram::bucketOf(Histogram::bucketLimit(i)+1), i+1);
+  }
+}
+
+BOOST_AUTO_TEST_CASE(testEmpty)
+{
+  Histogram h;
+  BOOST_CHECK_EQUAL(h.count(), 0);
+  BOOST_CHECK_EQUAL(h.average(), 0.0);
+  BOOST_CHECK_EQUAL(h.percentile(0.99), 0);
+  BOOST_CHECK_EQUAL(h.max(), 0);
+}
+
+BOOST_AUTO_TEST_CASE(testPercentile)
+{
+  Histogram h;
+  for (int i = 0; i < 990; ++i)
+  {
+    h.add(10);
+  }
+  for (int i = 0; i < 10; ++i)
+  {
+    h.add(5000);
+  }
+  h.add(-1);  // as 0
+  BOOST_CHECK_EQUAL(h.count(), 1001);
+  BOOST_CHECK_EQUAL(h.sum(), 990*10 + 10*5000);
+  BOOST_CHECK_EQUAL(h.max(), 5000);
+  BOOST_CHECK_EQUAL(h.bucketCount(0), 1);
+  BOOST_CHECK_EQUAL(h.bucketCount(Histogram::bucketOf(10)), 990);
+  BOOST_CHECK_EQUAL(h.percentile(0.5), 15);
+  BOOST_CHECK_EQUAL(h.percentile(0.999), 5000);
+  BOOST_CHECK_EQUAL(h.percentile(1.0), 5000);
+}
@@ -0,0 +1,113 @@
+#include "muduo/base/MpscQueue.h"
+
+#include "muduo/base/Thread.h"
+
+#include <memory>
+#include <vector>
+
+//#define BOOST_TEST_MODULE MpscQueueTest
+#define BOOST_TEST_MAIN
+#define BOOST_TEST_DYN_LINK
+#include <boost/test/unit_test.hpp>
+
+using muduo::MpscQueue;
+using muduo::Thread;
+
+BOOST_AUTO_TEST_CASE(testMpscQueueFifo)
+{
+  MpscQueue<int> queue;
+  BOOST_CHECK(queue.empty());
+  int x = 0;
+  BOOST_CHECK(!queue.pop(&x));
+
+  for (int i = 0; i < 10; ++i)
+  {
+    queue.push(i);
+  }
+  BOOST_CHECK(!queue.empty());
+  BOOST_CHECK_EQUAL(queue.size(), 10u);
+  for (int i = 0; i < 10; ++i)
+  {
+    BOOST_CHECK(queue.pop(&x));
+    BOOST_CHECK_EQUAL(x, i);
+  }
+  BOOST_CHECK(!queue.pop(&x));
+  BOOST_CHECK(queue.empty());
+  BOOST_CHECK_EQUAL(queue.size(), 0u);
+}
+
+BOOST_AUTO_TEST_CASE(testMpscQueueMoveOnly)
+{
+  MpscQueue<std::unique_ptr<int>> queue;
+  queue.push(std::unique_ptr<int>(new int(42)));
+  // left in the queue, freed by destructor
+  queue.push(std::unique_ptr<int>(new int(43)));
+  std::unique_ptr<int> p;
+  BOOST_CHECK(queue.pop(&p));
+  BOOST_CHECK_EQUAL(*p, 42);
+}
+
+BOOST_AUTO_TEST_CASE(testMpscQueueReusesNodes)
+{
+  MpscQueue<std::shared_ptr<int>> queue;
+  std::weak_ptr<int> last;
+  // more than kMaxFreeNodes in the first round, from the free list after
+  for (int round = 0; round < 3; ++round)
+  {
+    const int n = round == 0 ? 2000 : 100;
+    for (int i = 0; i < n; ++i)
+    {
+      std::shared_ptr<int> p(new int(round * 10000 + i));
+      last = p;
+      queue.push(std::move(p));
+    }
+    std::shared_ptr<int> p;
+    for (int i = 0; i < n; ++i)
+    {
+      BOOST_REQUIRE(queue.pop(&p));
+      BOOST_CHECK_EQUAL(*p, round * 10000 + i);
+    }
+    BOOST_CHECK(!queue.pop(&p));
+    p.reset();
+    // no copy is left in a recycled node
+    BOOST_CHECK(last.expired());
+  }
+}
+
+BOOST_AUTO_TEST_CASE(testMpscQueueProducers)
+{
+  const int kThreads = 4;
+  const int kPerThread = 100000;
+  MpscQueue<int> queue;
+  std::vector<std::unique_ptr<Thread>> threads;
+  for (int t = 0; t < kThreads; ++t)
+  {
+    threads.emplace_back(new Thread([&queue, t, kPerThread] {
+      for (int i = 0; i < kPerThread; ++i)
+      {
+        queue.push(t * kPerThread + i);
+      }
+    }));
+    threads.back()->start();
+  }
+
+  // order is kept for each producer
+  std::vector<int> last(kThreads, -1);
+  int received = 0;
+  while (received < kThreads * kPerThread)
+  {
+    int x = 0;
+    if (queue.pop(&x))
+    {
+      const int t = x / kPerThread;
+      BOOST_REQUIRE_GT(x % kPerThread, last[t]);
+      last[t] = x % kPerThread;
+      ++received;
+    }
+  }
+  for (auto& thr : threads)
+  {
+    thr->join();
+  }
+  BOOST_CHECK(queue.empty());
+}
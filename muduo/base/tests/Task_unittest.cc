@@ -0,0 +1,112 @@
+#include "muduo/base/Task.h"
+
+#include <memory>
+#include <string>
+
+//#define BOOST_TEST_MODULE TaskTest
+#define BOOST_TEST_MAIN
+#define BOOST_TEST_DYN_LINK
+#include <boost/test/unit_test.hpp>
+
+using muduo::Task;
+
+namespace
+{
+
+int g_calls = 0;
+
+void freeFunction()
+{
+  ++g_calls;
+}
+
+struct Counter
+{
+  void add(int x, int y) { sum += x + y; }
+  int sum = 0;
+};
+
+struct Big
+{
+  void operator()() { ++g_calls; }
+  char data[128];
+};
+
+void takeOwnership(const std::unique_ptr<int>& p, int* out)
+{
+  *out = *p;
+}
+
+}  // namespace
+
+BOOST_AUTO_TEST_CASE(testTaskEmpty)
+{
+  Task t;
+  BOOST_CHECK(!t);
+  Task n(nullptr);
+  BOOST_CHECK(!n);
+  Task f(std::function<void()>{});
+  BOOST_CHECK(!f);
+  void (*fp)() = NULL;
+  Task p(fp);
+  BOOST_CHECK(!p);
+}
+
+BOOST_AUTO_TEST_CASE(testTaskInline)
+{
+  auto counter = std::make_shared<Counter>();
+  auto bound = std::bind(&Counter::add, counter, 1, 2);
+  BOOST_CHECK(Task::storedInline<decltype(bound)>());
+  BOOST_CHECK_EQUAL(sizeof(Task), 64u);
+
+  Task t(bound);
+  BOOST_REQUIRE(t);
+  t();
+  t();
+  BOOST_CHECK_EQUAL(counter->sum, 6);
+
+  Task moved(std::move(t));
+  BOOST_CHECK(!t);
+  moved();
+  BOOST_CHECK_EQUAL(counter->sum, 9);
+  BOOST_CHECK_EQUAL(counter.use_count(), 3);  // bound and moved
+  moved = nullptr;
+  BOOST_CHECK_EQUAL(counter.use_count(), 2);
+}
+
+BOOST_AUTO_TEST_CASE(testTaskHeap)
+{
+  BOOST_CHECK(!Task::storedInline<Big>());
+  g_calls = 0;
+  Task t{Big()};
+  Task u(freeFunction);
+  t.swap(u);
+  t();
+  u();
+  BOOST_CHECK_EQUAL(g_calls, 2);
+
+  Task v;
+  v = std::move(u);
+  BOOST_CHECK(!u);
+  v();
+  BOOST_CHECK_EQUAL(g_calls, 3);
+}
+
+BOOST_AUTO_TEST_CASE(testTaskMoveOnly)
+{
+  int result = 0;
+  Task t(std::bind(takeOwnership, std::unique_ptr<int>(new int(42)), &result));
+  Task u(std::move(t));
+  u();
+  BOOST_CHECK_EQUAL(result, 42);
+}
+
+BOOST_AUTO_TEST_CASE(testTaskTargetType)
+{
+  Task t;
+  BOOST_CHECK(t.targetType() == typeid(void));
+  Task f(freeFunction);
+  BOOST_CHECK(f.targetType() == typeid(void (*)()));
+  Task b{Big()};
+  BOOST_CHECK(b.targetType() == typeid(Big));
+}
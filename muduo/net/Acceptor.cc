@@ -12,6 +12,7 @@
 #include "muduo/net/EventLoop.h"
 #include "muduo/net/InetAddress.h"
 #include "muduo/net/SocketsOps.h"
+#include "muduo/net/poller/IoUringPoller.h"
 
 #include <errno.h>
 #include <fcntl.h>
@@ -33,6 +34,11 @@ Acceptor::Acceptor(EventLoop* loop, const InetAddress& listenAddr, bool reusepor
   acceptSocket_.setReuseAddr(true);
   acceptSocket_.setReusePort(reuseport);
   acceptSocket_.bindAddress(listenAddr);
+  if (listenAddr.family() == AF_UNIX && listenAddr.unixPath()[0] == '/')
+  {
+    // we made the file by binding
+    unixPath_ = listenAddr.unixPath();
+  }
   acceptChannel_.setReadCallback(
       std::bind(&Acceptor::handleRead, this));
 }
@@ -42,6 +48,15 @@ Acceptor::~Acceptor()
   acceptChannel_.disableAll();
   acceptChannel_.remove();
   ::close(idleFd_);
+  if (!unixPath_.empty())
+  {
+    ::unlink(unixPath_.c_str());
+  }
+}
+
+InetAddress Acceptor::listenAddress() const
+{
+  return InetAddress::localAddressOf(acceptSocket_.fd());
 }
 
 void Acceptor::listen()
@@ -49,12 +64,34 @@ void Acceptor::listen()
   loop_->assertInLoopThread();
   listening_ = true;
   acceptSocket_.listen();
+  if (IoUringPoller* uring = loop_->ioUring())
+  {
+    // multishot accept, no poll
+    uring->setAccepting(&acceptChannel_);
+  }
   acceptChannel_.enableReading();
 }
 
 void Acceptor::handleRead()
 {
   loop_->assertInLoopThread();
+  if (IoUringPoller* uring = loop_->ioUring())
+  {
+    // accepted by the kernel already, take them all
+    int savedErrno = 0;
+    int connfd;
+    while ((connfd = uring->takeAccepted(&acceptChannel_, &savedErrno)) >= 0)
+    {
+      newConnection(connfd, InetAddress::peerAddressOf(connfd));
+    }
+    if (savedErrno != EAGAIN)
+    {
+      errno = savedErrno;
+      handleAcceptError();
+    }
+    return;
+  }
+
   InetAddress peerAddr;
   //FIXME loop until no more
   int connfd = acceptSocket_.accept(&peerAddr);
@@ -62,28 +99,38 @@ void Acceptor::handleRead()
   {
     // string hostport = peerAddr.toIpPort();
     // LOG_TRACE << "Accepts of " << hostport;
-    if (newConnectionCallback_)
-    {
-      newConnectionCallback_(connfd, peerAddr);
-    }
-    else
-    {
-      sockets::close(connfd);
-    }
+    newConnection(connfd, peerAddr);
   }
   else
   {
-    LOG_SYSERR << "in Acceptor::handleRead";
-    // Read the section named "The special problem of
-    // accept()ing when you can't" in libev's doc.
-    // By Marc Lehmann, author of libev.
-    if (errno == EMFILE)
-    {
-      ::close(idleFd_);
-      idleFd_ = ::accept(acceptSocket_.fd(), NULL, NULL);
-      ::close(idleFd_);
-      idleFd_ = ::open("/dev/null", O_RDONLY | O_CLOEXEC);
-    }
+    handleAcceptError();
+  }
+}
+
+void Acceptor::newConnection(int connfd, const InetAddress& peerAddr)
+{
+  if (newConnectionCallback_)
+  {
+    newConnectionCallback_(connfd, peerAddr);
+  }
+  else
+  {
+    sockets::close(connfd);
+  }
+}
+
+void Acceptor::handleAcceptError()
+{
+  LOG_SYSERR << "in Acceptor::handleRead";
+  // Read the section named "The special problem of
+  // accept()ing when you can't" in libev's doc.
+  // By Marc Lehmann, author of libev.
+  if (errno == EMFILE)
+  {
+    ::close(idleFd_);
+    idleFd_ = ::accept(acceptSocket_.fd(), NULL, NULL);
+    ::close(idleFd_);
+    idleFd_ = ::open("/dev/null", O_RDONLY | O_CLOEXEC);
   }
 }
 
@@ -25,7 +25,10 @@ class EventLoop;
 class InetAddress;
 
 ///
-/// Acceptor of incoming TCP connections.
+/// Acceptor of incoming TCP or AF_UNIX stream connections.
+///
+/// The socket file of a unix path is removed when the acceptor is gone,
+/// but a stale one, eg. after a crash, must be removed before binding.
 ///
 class Acceptor : noncopyable
 {
@@ -42,12 +45,21 @@ class Acceptor : noncopyable
 
   bool listening() const { return listening_; }
 
+  /// Bound address, with the port chosen by the kernel if it was 0.
+  InetAddress listenAddress() const;
+
+  /// See Socket::setReusePortCpuSteering().
+  bool setCpuSteering(int numAcceptors)
+  { return acceptSocket_.setReusePortCpuSteering(numAcceptors); }
+
   // Deprecated, use the correct spelling one above.
   // Leave the wrong spelling here in case one needs to grep it for error messages.
   // bool listenning() const { return listening(); }
 
  private:
   void handleRead();
+  void newConnection(int connfd, const InetAddress& peerAddr);
+  void handleAcceptError();
 
   EventLoop* loop_;
   Socket acceptSocket_;
@@ -55,6 +67,7 @@ class Acceptor : noncopyable
   NewConnectionCallback newConnectionCallback_;
   bool listening_;
   int idleFd_;
+  string unixPath_;  // unlinked in dtor
 };
 
 }  // namespace net
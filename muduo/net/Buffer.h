@@ -15,6 +15,7 @@
 #include "muduo/base/StringPiece.h"
 #include "muduo/base/Types.h"
 
+#include "muduo/net/BufferPool.h"
 #include "muduo/net/Endian.h"
 
 #include <algorithm>
@@ -45,6 +46,10 @@ class Buffer : public muduo::copyable
   static const size_t kCheapPrepend = 8;
   static const size_t kInitialSize = 1024;
 
+  typedef PoolAllocator<char> Allocator;
+  static_assert(kCheapPrepend + kInitialSize == BufferPool::kMinBlockSize,
+                "default Buffer should fit the smallest block of BufferPool");
+
   explicit Buffer(size_t initialSize = kInitialSize)
     : buffer_(kCheapPrepend + initialSize),
       readerIndex_(kCheapPrepend),
@@ -55,6 +60,17 @@ class Buffer : public muduo::copyable
     assert(prependableBytes() == kCheapPrepend);
   }
 
+  /// Takes memory from @c alloc, eg. the BufferPool of an EventLoop.
+  Buffer(size_t initialSize, const Allocator& alloc)
+    : buffer_(kCheapPrepend + initialSize, alloc),
+      readerIndex_(kCheapPrepend),
+      writerIndex_(kCheapPrepend)
+  {
+    assert(readableBytes() == 0);
+    assert(writableBytes() == initialSize);
+    assert(prependableBytes() == kCheapPrepend);
+  }
+
   // implicit copy-ctor, move-ctor, dtor and assignment are fine
   // NOTE: implicit move-ctor is added in g++ 4.6
 
@@ -362,17 +378,30 @@ class Buffer : public muduo::copyable
   void shrink(size_t reserve)
   {
     // FIXME: use vector::shrink_to_fit() in C++ 11 if possible.
-    Buffer other;
+    Buffer other(kInitialSize, buffer_.get_allocator());
     other.ensureWritableBytes(readableBytes()+reserve);
     other.append(toStringPiece());
     swap(other);
   }
 
+  /// Frees the storage of an empty buffer, it grows again on next append.
+  void release()
+  {
+    assert(readableBytes() == 0);
+    Buffer other(0, buffer_.get_allocator());
+    swap(other);
+  }
+
   size_t internalCapacity() const
   {
     return buffer_.capacity();
   }
 
+  Allocator allocator() const
+  {
+    return buffer_.get_allocator();
+  }
+
   /// Read data directly into buffer.
   ///
   /// It may implement with readv(2)
@@ -392,7 +421,13 @@ class Buffer : public muduo::copyable
     if (writableBytes() + prependableBytes() < len + kCheapPrepend)
     {
       // FIXME: move readable data
-      buffer_.resize(writerIndex_+len);
+      const size_t size = writerIndex_+len;
+      if (size > buffer_.capacity() && buffer_.get_allocator().pool())
+      {
+        // grow to a whole block of the pool
+        buffer_.reserve(BufferPool::goodSize(std::max(size, 2*buffer_.size())));
+      }
+      buffer_.resize(size);
     }
     else
     {
@@ -409,7 +444,7 @@ class Buffer : public muduo::copyable
   }
 
  private:
-  std::vector<char> buffer_;
+  std::vector<char, Allocator> buffer_;
   size_t readerIndex_;
   size_t writerIndex_;
 
@@ -0,0 +1,458 @@
+// Use of this source code is governed by a BSD-style license
+// that can be found in the License file.
+
+#include "muduo/net/BufferChain.h"
+
+#include "muduo/base/Logging.h"
+#include "muduo/net/SocketsOps.h"
+
+#include <errno.h>
+#include <sys/uio.h>
+
+using namespace muduo;
+using namespace muduo::net;
+
+const size_t BufferChain::kSegmentSize;
+const size_t BufferChain::kSpliceThreshold;
+const int BufferChain::kMaxIovecs;
+
+BufferChain::Segment::Segment(size_t initialSize, const Buffer::Allocator& alloc)
+  : buffer(initialSize, alloc),
+    fileFd(-1),
+    fileOffset(0),
+    fileBytes(0),
+    pinned(false),
+    busy(false),
+    zeroCopyId(0)
+{
+}
+
+BufferChain::Segment::Segment(int fd, off_t offset, size_t len)
+  : buffer(0),
+    fileFd(fd),
+    fileOffset(offset),
+    fileBytes(len),
+    pinned(false),
+    busy(false),
+    zeroCopyId(0)
+{
+  assert(fd >= 0);
+}
+
+BufferChain::Segment::Segment(Segment&& rhs)
+  : buffer(std::move(rhs.buffer)),
+    fileFd(rhs.fileFd),
+    fileOffset(rhs.fileOffset),
+    fileBytes(rhs.fileBytes),
+    pinned(rhs.pinned),
+    busy(rhs.busy),
+    zeroCopyId(rhs.zeroCopyId)
+{
+  rhs.fileFd = -1;
+}
+
+BufferChain::Segment& BufferChain::Segment::operator=(Segment&& rhs)
+{
+  if (this != &rhs)
+  {
+    if (isFile())
+    {
+      sockets::close(fileFd);
+    }
+    buffer = std::move(rhs.buffer);
+    fileFd = rhs.fileFd;
+    fileOffset = rhs.fileOffset;
+    fileBytes = rhs.fileBytes;
+    pinned = rhs.pinned;
+    busy = rhs.busy;
+    zeroCopyId = rhs.zeroCopyId;
+    rhs.fileFd = -1;
+  }
+  return *this;
+}
+
+BufferChain::Segment::~Segment()
+{
+  if (isFile())
+  {
+    sockets::close(fileFd);
+  }
+}
+
+void BufferChain::Segment::retrieve(size_t len)
+{
+  if (isFile())
+  {
+    assert(len <= fileBytes);
+    fileOffset += static_cast<off_t>(len);
+    fileBytes -= len;
+  }
+  else
+  {
+    buffer.retrieve(len);
+  }
+}
+
+BufferChain::BufferChain(const Buffer::Allocator& alloc)
+  : alloc_(alloc),
+    readableBytes_(0),
+    nextZeroCopyId_(0)
+{
+}
+
+BufferChain::~BufferChain() = default;
+
+size_t BufferChain::internalCapacity() const
+{
+  size_t capacity = 0;
+  for (const Segment& seg : segments_)
+  {
+    capacity += seg.buffer.internalCapacity();
+  }
+  return capacity;
+}
+
+Buffer& BufferChain::tail()
+{
+  // never write into memory the kernel may be reading
+  if (segments_.empty() || segments_.back().isFile() || segments_.back().isLocked())
+  {
+    segments_.emplace_back(Buffer::kInitialSize, alloc_);
+  }
+  return segments_.back().buffer;
+}
+
+void BufferChain::append(const void* /*restrict*/ data, size_t len)
+{
+  Buffer* seg = &tail();
+  if (seg->readableBytes() > 0 && seg->readableBytes() + len > kSegmentSize)
+  {
+    // don't grow the tail, which may memmove bytes already queued
+    segments_.emplace_back(Buffer::kInitialSize, alloc_);
+    seg = &segments_.back().buffer;
+  }
+  seg->append(data, len);
+  readableBytes_ += len;
+}
+
+void BufferChain::append(Buffer* buf)
+{
+  const size_t len = buf->readableBytes();
+  if (len < kSpliceThreshold)
+  {
+    append(buf->peek(), len);
+    buf->retrieveAll();
+  }
+  else
+  {
+    if (segments_.empty()
+        || segments_.back().isFile()
+        || segments_.back().isLocked()
+        || segments_.back().buffer.readableBytes() > 0)
+    {
+      // the empty buffer goes to buf, don't take it from the pool
+      segments_.emplace_back(0, Buffer::Allocator());
+    }
+    segments_.back().buffer.swap(*buf);
+    // buf now holds an empty segment
+    buf->retrieveAll();
+    readableBytes_ += len;
+  }
+}
+
+void BufferChain::appendFile(int fd, off_t offset, size_t len)
+{
+  if (!segments_.empty()
+      && !segments_.back().isFile()
+      && !segments_.back().isLocked()
+      && segments_.back().readableBytes() == 0)
+  {
+    segments_.pop_back();
+  }
+  segments_.emplace_back(fd, offset, len);
+  readableBytes_ += len;
+}
+
+void BufferChain::retrieve(size_t len)
+{
+  assert(len <= readableBytes_);
+  readableBytes_ -= len;
+  while (len > 0)
+  {
+    assert(!segments_.empty());
+    Segment& head = segments_.front();
+    const size_t readable = head.readableBytes();
+    if (len < readable)
+    {
+      head.retrieve(len);
+      len = 0;
+    }
+    else
+    {
+      len -= readable;
+      if (segments_.size() > 1 || head.isFile() || head.isPinned())
+      {
+        popFront();
+      }
+      else
+      {
+        // keep the last segment for further appending
+        head.buffer.retrieveAll();
+      }
+    }
+  }
+  // drop empty segments left behind a splice or a file
+  while (!segments_.empty()
+         && segments_.front().readableBytes() == 0
+         && (segments_.size() > 1
+             || segments_.front().isFile()
+             || segments_.front().isPinned()))
+  {
+    popFront();
+  }
+}
+
+void BufferChain::popFront()
+{
+  Segment& head = segments_.front();
+  if (head.isPinned())
+  {
+    pinnedBuffers_.push_back(PinnedBuffer(head.zeroCopyId, std::move(head.buffer)));
+  }
+  segments_.pop_front();
+  releasePinned();
+}
+
+void BufferChain::retrieveAll()
+{
+  while (!segments_.empty()
+         && (segments_.size() > 1
+             || segments_.front().isFile()
+             || segments_.front().isPinned()))
+  {
+    popFront();
+  }
+  if (!segments_.empty())
+  {
+    segments_.back().buffer.retrieveAll();
+  }
+  readableBytes_ = 0;
+}
+
+void BufferChain::shrink(size_t reserve)
+{
+  for (Segment& seg : segments_)
+  {
+    if (!seg.isFile() && !seg.isLocked())
+    {
+      seg.buffer.shrink(&seg == &segments_.back() ? reserve : 0);
+    }
+  }
+}
+
+void BufferChain::release()
+{
+  assert(empty());
+  // pinned segments were moved to pinnedBuffers_ when drained
+  segments_.clear();
+}
+
+ssize_t BufferChain::writeFd(int fd, int* savedErrno, size_t zeroCopyThreshold)
+{
+  if (!segments_.empty() && segments_.front().isFile())
+  {
+    return sendFile(fd, savedErrno);
+  }
+  if (zeroCopyThreshold > 0
+      && !segments_.empty()
+      && segments_.front().readableBytes() >= zeroCopyThreshold)
+  {
+    const ssize_t n = sendZeroCopy(fd, savedErrno);
+    if (n >= 0 || *savedErrno != ENOBUFS)
+    {
+      return n;
+    }
+    // out of optmem for pinning pages, copy this time
+  }
+
+  struct iovec vec[kMaxIovecs];
+  int iovcnt = 0;
+  for (const Segment& seg : segments_)
+  {
+    if (iovcnt == kMaxIovecs || seg.isFile())
+    {
+      break;
+    }
+    if (zeroCopyThreshold > 0 && iovcnt > 0 && seg.readableBytes() >= zeroCopyThreshold)
+    {
+      // leave it to sendZeroCopy()
+      break;
+    }
+    if (seg.readableBytes() > 0)
+    {
+      vec[iovcnt].iov_base = const_cast<char*>(seg.buffer.peek());
+      vec[iovcnt].iov_len = seg.readableBytes();
+      ++iovcnt;
+    }
+  }
+
+  const ssize_t n = sockets::writev(fd, vec, iovcnt);
+  if (n < 0)
+  {
+    *savedErrno = errno;
+  }
+  else
+  {
+    retrieve(implicit_cast<size_t>(n));
+  }
+  return n;
+}
+
+ssize_t BufferChain::sendFile(int fd, int* savedErrno)
+{
+  Segment& head = segments_.front();
+  assert(head.isFile());
+  off_t offset = head.fileOffset;
+  const ssize_t n = sockets::sendfile(fd, head.fileFd, &offset, head.fileBytes);
+  if (n < 0)
+  {
+    *savedErrno = errno;
+  }
+  else if (n == 0 && head.fileBytes > 0)
+  {
+    // the file was truncated after being queued, the rest can never be sent.
+    LOG_ERROR << "BufferChain::sendFile - unexpected EOF of fd " << head.fileFd
+              << ", discard " << head.fileBytes << " bytes";
+    retrieve(head.fileBytes);
+  }
+  else
+  {
+    retrieve(implicit_cast<size_t>(n));
+  }
+  return n;
+}
+
+ssize_t BufferChain::sendZeroCopy(int fd, int* savedErrno)
+{
+  Segment& head = segments_.front();
+  assert(!head.isFile());
+  const ssize_t n = sockets::sendZeroCopy(fd, head.buffer.peek(), head.buffer.readableBytes());
+  if (n < 0)
+  {
+    *savedErrno = errno;
+  }
+  else
+  {
+    // the kernel numbers successful MSG_ZEROCOPY sends from 0
+    head.pinned = true;
+    head.zeroCopyId = nextZeroCopyId_;
+    inflightZeroCopyIds_.insert(nextZeroCopyId_);
+    ++nextZeroCopyId_;
+    retrieve(implicit_cast<size_t>(n));
+  }
+  return n;
+}
+
+void BufferChain::releaseZeroCopy(uint32_t lo, uint32_t hi)
+{
+  // ids in flight are less than 2^32 before nextZeroCopyId_, so is lo,
+  // and the range holds hi - lo + 1 of them, mod 2^32
+  const uint32_t back = static_cast<uint32_t>(nextZeroCopyId_) - lo;
+  if (back == 0 || back > nextZeroCopyId_)
+  {
+    return;  // not sent yet
+  }
+  const uint64_t first = nextZeroCopyId_ - back;
+  const uint64_t last = first + static_cast<uint32_t>(hi - lo);
+  inflightZeroCopyIds_.erase(inflightZeroCopyIds_.lower_bound(first),
+                             inflightZeroCopyIds_.upper_bound(last));
+  releasePinned();
+}
+
+void BufferChain::setNextZeroCopyId(uint32_t id)
+{
+  assert(inflightZeroCopyIds_.empty());
+  nextZeroCopyId_ = id;
+}
+
+void BufferChain::releasePinned()
+{
+  // ids are assigned in chain order, so is pinnedBuffers_
+  while (!pinnedBuffers_.empty()
+         && (inflightZeroCopyIds_.empty()
+             || pinnedBuffers_.front().first < *inflightZeroCopyIds_.begin()))
+  {
+    pinnedBuffers_.pop_front();
+  }
+}
+
+void BufferChain::takePinned(BufferChain* other)
+{
+  assert(inflightZeroCopyIds_.empty() && pinnedBuffers_.empty());
+  // in id order, those popped before those still queued
+  for (PinnedBuffer& pinned : other->pinnedBuffers_)
+  {
+    pinnedBuffers_.push_back(std::move(pinned));
+  }
+  for (Segment& seg : other->segments_)
+  {
+    if (seg.isPinned())
+    {
+      pinnedBuffers_.push_back(PinnedBuffer(seg.zeroCopyId, std::move(seg.buffer)));
+    }
+  }
+  inflightZeroCopyIds_.swap(other->inflightZeroCopyIds_);
+  nextZeroCopyId_ = other->nextZeroCopyId_;
+  other->pinnedBuffers_.clear();
+  other->segments_.clear();
+  other->inflightZeroCopyIds_.clear();
+  other->readableBytes_ = 0;
+  releasePinned();
+}
+
+size_t BufferChain::pinnedBytes() const
+{
+  size_t bytes = 0;
+  for (const PinnedBuffer& pinned : pinnedBuffers_)
+  {
+    bytes += pinned.second.internalCapacity();
+  }
+  return bytes;
+}
+
+int BufferChain::startAsyncWrite(struct iovec* vec, int maxIovecs)
+{
+  int iovcnt = 0;
+  for (Segment& seg : segments_)
+  {
+    if (iovcnt == maxIovecs || seg.isFile())
+    {
+      break;
+    }
+    assert(!seg.busy);
+    if (seg.readableBytes() > 0)
+    {
+      vec[iovcnt].iov_base = const_cast<char*>(seg.buffer.peek());
+      vec[iovcnt].iov_len = seg.readableBytes();
+      seg.busy = true;
+      ++iovcnt;
+    }
+  }
+  return iovcnt;
+}
+
+void BufferChain::finishAsyncWrite(ssize_t n)
+{
+  for (Segment& seg : segments_)
+  {
+    if (seg.isFile())
+    {
+      break;
+    }
+    seg.busy = false;
+  }
+  if (n > 0)
+  {
+    retrieve(implicit_cast<size_t>(n));
+  }
+}
@@ -0,0 +1,181 @@
+// Use of this source code is governed by a BSD-style license
+// that can be found in the License file.
+//
+// This is a public header file, it must only include public header files.
+
+#ifndef MUDUO_NET_BUFFERCHAIN_H
+#define MUDUO_NET_BUFFERCHAIN_H
+
+#include "muduo/base/noncopyable.h"
+#include "muduo/base/StringPiece.h"
+#include "muduo/base/Types.h"
+#include "muduo/net/Buffer.h"
+
+#include <deque>
+#include <set>
+#include <utility>
+
+#include <sys/types.h>  // off_t
+
+struct iovec;
+
+namespace muduo
+{
+namespace net
+{
+
+///
+/// A chain of Buffer segments, used as output queue of TcpConnection.
+///
+/// Appending never moves bytes already queued, large Buffers are
+/// spliced in by swapping instead of copying, and consecutive memory
+/// segments are drained with one writev(2).
+/// A segment may also be a region of a file, drained with sendfile(2).
+///
+/// With a zero-copy threshold, big memory segments are sent with
+/// MSG_ZEROCOPY, and kept alive until the kernel reports completion.
+///
+/// For asynchronous writes, eg. with io_uring, leading memory segments
+/// are left alone from startAsyncWrite() until finishAsyncWrite().
+///
+/// @code
+/// +----------+     +----------+     +----------+
+/// | segment0 | --> |  file 1  | --> | segment2 | <-- append() here
+/// +----------+     +----------+     +----------+
+///   ^ writeFd() from here
+/// @endcode
+class BufferChain : noncopyable
+{
+ public:
+  /// Copied bytes go to the tail segment until it holds this many.
+  static const size_t kSegmentSize = 64*1024;
+  /// Buffers smaller than this are copied, not spliced.
+  static const size_t kSpliceThreshold = 4*1024;
+  /// Max iovecs per writev(2).
+  static const int kMaxIovecs = 64;
+
+  /// Memory segments are allocated from @c alloc.
+  explicit BufferChain(const Buffer::Allocator& alloc = Buffer::Allocator());
+  ~BufferChain();
+
+  size_t readableBytes() const
+  { return readableBytes_; }
+
+  bool empty() const
+  { return readableBytes_ == 0; }
+
+  size_t numSegments() const
+  { return segments_.size(); }
+
+  /// Total memory held by all segments.
+  size_t internalCapacity() const;
+
+  void append(const StringPiece& str)
+  { append(str.data(), str.size()); }
+
+  void append(const void* /*restrict*/ data, size_t len);
+
+  /// Takes all readable bytes of @c buf, leaves @c buf empty.
+  /// Big buffers are spliced in without copying the payload.
+  void append(Buffer* buf);
+
+  /// Queues @c len bytes of file @c fd starting at @c offset.
+  /// Takes ownership of @c fd, which is closed once sent or discarded.
+  void appendFile(int fd, off_t offset, size_t len);
+
+  void retrieve(size_t len);
+  void retrieveAll();
+
+  /// Releases spare memory, keeps @c reserve writable bytes in tail.
+  void shrink(size_t reserve);
+
+  /// Frees all segments of an empty chain.
+  void release();
+
+  /// Writes leading memory segments with one writev(2), or the leading
+  /// file region with one sendfile(2), retrieves the written bytes.
+  /// If @c zeroCopyThreshold > 0, a leading memory segment of at least
+  /// that many bytes is sent with sendmsg(MSG_ZEROCOPY) instead.
+  /// @return result of writev(2)/sendfile(2)/sendmsg(2), @c errno is saved
+  ssize_t writeFd(int fd, int* savedErrno, size_t zeroCopyThreshold = 0);
+
+  /// Called with the range of a MSG_ZEROCOPY completion notification,
+  /// frees segments no longer used by the kernel.
+  /// The kernel's ids are 32 bits and wrap, so @c lo may be above @c hi.
+  void releaseZeroCopy(uint32_t lo, uint32_t hi);
+
+  /// Id the kernel gives the next MSG_ZEROCOPY send, it counts them on
+  /// each socket from 0. Not while some send is in flight.
+  void setNextZeroCopyId(uint32_t id);
+
+  /// Bytes already sent with MSG_ZEROCOPY but not released.
+  size_t pinnedBytes() const;
+
+  /// Some MSG_ZEROCOPY send is not completed yet.
+  bool zeroCopyInflight() const
+  { return !inflightZeroCopyIds_.empty(); }
+
+  /// Takes buffers the kernel may still read from @c other, discards the
+  /// rest of it, eg. to keep them after the connection is destroyed.
+  /// This one must not have sent with MSG_ZEROCOPY itself.
+  void takePinned(BufferChain* other);
+
+  /// Fills @c vec with leading memory segments to be written by the
+  /// kernel later. Those segments are not appended to or shrunk until
+  /// finishAsyncWrite(), one asynchronous write at a time.
+  /// @return number of iovecs, 0 if empty or the head is a file region
+  int startAsyncWrite(struct iovec* vec, int maxIovecs);
+
+  /// Retrieves @c n bytes written by the kernel, none if @c n < 0.
+  void finishAsyncWrite(ssize_t n);
+
+ private:
+  struct Segment
+  {
+    Segment(size_t initialSize, const Buffer::Allocator& alloc);
+    Segment(int fd, off_t offset, size_t len);
+    Segment(Segment&& rhs);
+    Segment& operator=(Segment&& rhs);
+    ~Segment();
+
+    bool isFile() const { return fileFd >= 0; }
+    // sent with MSG_ZEROCOPY, the kernel may still read it
+    bool isPinned() const { return pinned; }
+    // in an asynchronous write, the kernel may be reading it
+    bool isLocked() const { return pinned || busy; }
+    size_t readableBytes() const
+    { return isFile() ? fileBytes : buffer.readableBytes(); }
+    void retrieve(size_t len);
+
+    Buffer buffer;
+    int fileFd;  // -1 for memory segment
+    off_t fileOffset;
+    size_t fileBytes;
+    bool pinned;
+    bool busy;
+    uint64_t zeroCopyId;  // of the last sendmsg(MSG_ZEROCOPY) on it
+  };
+
+  // (zeroCopyId, pinned buffer)
+  typedef std::pair<uint64_t, Buffer> PinnedBuffer;
+
+  Buffer& tail();
+  void popFront();
+  void releasePinned();
+  ssize_t sendFile(int fd, int* savedErrno);
+  ssize_t sendZeroCopy(int fd, int* savedErrno);
+
+  const Buffer::Allocator alloc_;
+  std::deque<Segment> segments_;
+  size_t readableBytes_;
+  // ids of the kernel, which are the low 32 bits of these, so that ours
+  // never wrap and keep their order
+  uint64_t nextZeroCopyId_;
+  std::set<uint64_t> inflightZeroCopyIds_;
+  std::deque<PinnedBuffer> pinnedBuffers_;
+};
+
+}  // namespace net
+}  // namespace muduo
+
+#endif  // MUDUO_NET_BUFFERCHAIN_H
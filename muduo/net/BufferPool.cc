@@ -0,0 +1,263 @@
+// Use of this source code is governed by a BSD-style license
+// that can be found in the License file.
+
+#include "muduo/net/BufferPool.h"
+
+#include "muduo/base/CurrentThread.h"
+#include "muduo/base/Logging.h"
+
+#include <algorithm>
+
+#include <assert.h>
+#include <stdlib.h>
+
+using namespace muduo;
+using namespace muduo::net;
+
+const size_t BufferPool::kMinBlockSize;
+const int BufferPool::kNumSizeClasses;
+const size_t BufferPool::kMinPooledSize;
+const size_t BufferPool::kSlabSize;
+
+// precedes every block handed out by the pool
+struct BufferPool::Block
+{
+  Slab* slab;  // NULL for heap memory
+  Block* nextFree;
+};
+
+struct BufferPool::Slab
+{
+  Slab* prev;
+  Slab* next;
+  int sizeClass;
+  size_t used;
+  size_t carved;  // blocks never used are not touched, so not in RSS
+  Block* freeList;
+};
+
+namespace
+{
+
+// room for Slab, keeps blocks aligned
+const size_t kSlabHeaderSize = 64;
+
+template<typename T>
+void unlink(T** list, T* node)
+{
+  if (node->prev)
+  {
+    node->prev->next = node->next;
+  }
+  else
+  {
+    *list = node->next;
+  }
+  if (node->next)
+  {
+    node->next->prev = node->prev;
+  }
+  node->prev = node->next = NULL;
+}
+
+template<typename T>
+void link(T** list, T* node)
+{
+  node->prev = NULL;
+  node->next = *list;
+  if (*list)
+  {
+    (*list)->prev = node;
+  }
+  *list = node;
+}
+
+}  // namespace
+
+BufferPool::BufferPool()
+  : ownerTid_(CurrentThread::tid()),
+    slabBytes_(0),
+    bytesInUse_(0),
+    numSlabs_(0),
+    allocations_(0),
+    fallbacks_(0),
+    hasRemoteFrees_(false)
+{
+  static_assert(sizeof(Slab) <= kSlabHeaderSize, "Slab header too big");
+  for (int i = 0; i < kNumSizeClasses; ++i)
+  {
+    SizeClass& sc = classes_[i];
+    sc.blockSize = kMinBlockSize << i;
+    const size_t stride = sizeof(Block) + sc.blockSize;
+    sc.blocksPerSlab = std::max<size_t>((kSlabSize - kSlabHeaderSize) / stride, 4);
+    sc.available = NULL;
+    sc.full = NULL;
+  }
+}
+
+BufferPool::~BufferPool()
+{
+  // blocks still held by other threads can't be in use,
+  // as every Buffer using this pool shares ownership of it.
+  for (SizeClass& sc : classes_)
+  {
+    for (Slab** list : { &sc.available, &sc.full })
+    {
+      while (*list)
+      {
+        Slab* slab = *list;
+        *list = slab->next;
+        ::free(slab);
+      }
+    }
+  }
+}
+
+int BufferPool::sizeClassOf(size_t n)
+{
+  size_t blockSize = kMinBlockSize;
+  for (int i = 0; i < kNumSizeClasses; ++i)
+  {
+    if (n <= blockSize)
+    {
+      return i;
+    }
+    blockSize <<= 1;
+  }
+  return -1;
+}
+
+size_t BufferPool::goodSize(size_t n)
+{
+  const int sizeClass = sizeClassOf(n);
+  return sizeClass >= 0 ? kMinBlockSize << sizeClass : n;
+}
+
+void* BufferPool::allocate(size_t n)
+{
+  const int sizeClass = sizeClassOf(n);
+  if (sizeClass < 0 || n < kMinPooledSize || CurrentThread::tid() != ownerTid_)
+  {
+    ++fallbacks_;
+    Block* block = static_cast<Block*>(::operator new(sizeof(Block) + n));
+    block->slab = NULL;
+    return block + 1;
+  }
+
+  drainRemoteFrees();
+  SizeClass& sc = classes_[sizeClass];
+  Slab* slab = sc.available ? sc.available : newSlab(sizeClass);
+  Block* block = slab->freeList;
+  if (block)
+  {
+    slab->freeList = block->nextFree;
+  }
+  else
+  {
+    assert(slab->carved < sc.blocksPerSlab);
+    char* start = reinterpret_cast<char*>(slab) + kSlabHeaderSize;
+    block = reinterpret_cast<Block*>(start + slab->carved * (sizeof(Block) + sc.blockSize));
+    block->slab = slab;
+    ++slab->carved;
+  }
+  if (++slab->used == sc.blocksPerSlab)
+  {
+    unlink(&sc.available, slab);
+    link(&sc.full, slab);
+  }
+  bytesInUse_ += sc.blockSize;
+  ++allocations_;
+  return block + 1;
+}
+
+void BufferPool::deallocate(void* p, size_t)
+{
+  Block* block = static_cast<Block*>(p) - 1;
+  if (block->slab == NULL)
+  {
+    ::operator delete(block);
+  }
+  else if (CurrentThread::tid() != ownerTid_)
+  {
+    MutexLockGuard lock(mutex_);
+    remoteFrees_.push_back(block);
+    hasRemoteFrees_ = true;
+  }
+  else
+  {
+    drainRemoteFrees();
+    freeBlock(block);
+  }
+}
+
+BufferPool::Slab* BufferPool::newSlab(int sizeClass)
+{
+  SizeClass& sc = classes_[sizeClass];
+  const size_t bytes = kSlabHeaderSize + sc.blocksPerSlab * (sizeof(Block) + sc.blockSize);
+  Slab* slab = static_cast<Slab*>(::malloc(bytes));
+  if (slab == NULL)
+  {
+    LOG_SYSFATAL << "BufferPool::newSlab";
+  }
+  slab->sizeClass = sizeClass;
+  slab->used = 0;
+  slab->carved = 0;
+  slab->freeList = NULL;
+  link(&sc.available, slab);
+  slabBytes_ += bytes;
+  ++numSlabs_;
+  return slab;
+}
+
+void BufferPool::freeBlock(Block* block)
+{
+  Slab* slab = block->slab;
+  SizeClass& sc = classes_[slab->sizeClass];
+  if (slab->used == sc.blocksPerSlab)
+  {
+    unlink(&sc.full, slab);
+    link(&sc.available, slab);
+  }
+  block->nextFree = slab->freeList;
+  slab->freeList = block;
+  --slab->used;
+  bytesInUse_ -= sc.blockSize;
+
+  // keep one spare slab per size class
+  if (slab->used == 0 && (sc.available != slab || slab->next != NULL))
+  {
+    unlink(&sc.available, slab);
+    slabBytes_ -= kSlabHeaderSize + sc.blocksPerSlab * (sizeof(Block) + sc.blockSize);
+    --numSlabs_;
+    ::free(slab);
+  }
+}
+
+void BufferPool::drainRemoteFrees()
+{
+  if (!hasRemoteFrees_.load(std::memory_order_relaxed))
+  {
+    return;
+  }
+  std::vector<Block*> blocks;
+  {
+    MutexLockGuard lock(mutex_);
+    blocks.swap(remoteFrees_);
+    hasRemoteFrees_ = false;
+  }
+  for (Block* block : blocks)
+  {
+    freeBlock(block);
+  }
+}
+
+BufferPool::Stats BufferPool::stats() const
+{
+  Stats result;
+  result.slabBytes = slabBytes_;
+  result.bytesInUse = bytesInUse_;
+  result.numSlabs = numSlabs_;
+  result.allocations = allocations_;
+  result.fallbacks = fallbacks_.load();
+  return result;
+}
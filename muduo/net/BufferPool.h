@@ -0,0 +1,165 @@
+// Use of this source code is governed by a BSD-style license
+// that can be found in the License file.
+//
+// This is a public header file, it must only include public header files.
+
+#ifndef MUDUO_NET_BUFFERPOOL_H
+#define MUDUO_NET_BUFFERPOOL_H
+
+#include "muduo/base/Mutex.h"
+#include "muduo/base/noncopyable.h"
+#include "muduo/base/Types.h"
+
+#include <atomic>
+#include <memory>
+#include <type_traits>
+#include <vector>
+
+namespace muduo
+{
+namespace net
+{
+
+///
+/// Size-classed slab allocator for Buffer storage, one per EventLoop.
+///
+/// Only the owner thread allocates from slabs, without locking.
+/// Other threads get heap memory, and blocks they free are handed back
+/// to the owner thread.
+///
+class BufferPool : noncopyable
+{
+ public:
+  /// Block of size class i holds kMinBlockSize << i bytes, which is the
+  /// size of a default Buffer and its doublings.
+  static const size_t kMinBlockSize = 1032;
+  static const int kNumSizeClasses = 7;
+  /// Smaller requests, eg. an empty Buffer, go to the heap.
+  static const size_t kMinPooledSize = 256;
+  /// Target size of one slab, big classes get fewer blocks.
+  static const size_t kSlabSize = 256*1024;
+
+  struct Stats
+  {
+    size_t slabBytes;   // memory held by slabs
+    size_t bytesInUse;  // blocks handed out from slabs
+    int numSlabs;
+    int64_t allocations;  // served from slabs
+    int64_t fallbacks;    // served from heap
+  };
+
+  BufferPool();
+  ~BufferPool();
+
+  /// Returns the block size @c n is rounded up to,
+  /// or @c n if it is too big to be pooled.
+  static size_t goodSize(size_t n);
+
+  /// Thread safe.
+  void* allocate(size_t n);
+  /// Thread safe.
+  void deallocate(void* p, size_t n);
+
+  /// NOT thread safe, call it in owner thread.
+  Stats stats() const;
+
+  pid_t ownerThread() const { return ownerTid_; }
+
+ private:
+  struct Block;
+  struct Slab;
+  struct SizeClass
+  {
+    size_t blockSize;
+    size_t blocksPerSlab;
+    Slab* available;  // slabs with free blocks
+    Slab* full;
+  };
+
+  static int sizeClassOf(size_t n);
+  Slab* newSlab(int sizeClass);
+  void freeBlock(Block* block);
+  void drainRemoteFrees();
+
+  const pid_t ownerTid_;
+  SizeClass classes_[kNumSizeClasses];
+  size_t slabBytes_;
+  size_t bytesInUse_;
+  int numSlabs_;
+  int64_t allocations_;
+  std::atomic<int64_t> fallbacks_;
+
+  std::atomic<bool> hasRemoteFrees_;
+  MutexLock mutex_;
+  std::vector<Block*> remoteFrees_ GUARDED_BY(mutex_);
+};
+
+///
+/// Allocates from a BufferPool, or from the heap without one.
+///
+/// Moves and swaps along with the memory, so a swapped Buffer always
+/// frees into the right pool. Copies of a Buffer use the heap, as they
+/// may go to other threads.
+///
+template<typename T>
+class PoolAllocator
+{
+ public:
+  typedef T value_type;
+  typedef std::false_type propagate_on_container_copy_assignment;
+  typedef std::true_type propagate_on_container_move_assignment;
+  typedef std::true_type propagate_on_container_swap;
+
+  PoolAllocator() = default;
+
+  explicit PoolAllocator(std::shared_ptr<BufferPool> pool)
+    : pool_(std::move(pool))
+  {
+  }
+
+  template<typename U>
+  PoolAllocator(const PoolAllocator<U>& rhs)
+    : pool_(rhs.pool())
+  {
+  }
+
+  T* allocate(size_t n)
+  {
+    void* p = pool_ ? pool_->allocate(n * sizeof(T)) : ::operator new(n * sizeof(T));
+    return static_cast<T*>(p);
+  }
+
+  void deallocate(T* p, size_t n)
+  {
+    if (pool_)
+    {
+      pool_->deallocate(p, n * sizeof(T));
+    }
+    else
+    {
+      ::operator delete(p);
+    }
+  }
+
+  PoolAllocator select_on_container_copy_construction() const
+  { return PoolAllocator(); }
+
+  const std::shared_ptr<BufferPool>& pool() const
+  { return pool_; }
+
+ private:
+  std::shared_ptr<BufferPool> pool_;
+};
+
+template<typename T, typename U>
+bool operator==(const PoolAllocator<T>& lhs, const PoolAllocator<U>& rhs)
+{ return lhs.pool() == rhs.pool(); }
+
+template<typename T, typename U>
+bool operator!=(const PoolAllocator<T>& lhs, const PoolAllocator<U>& rhs)
+{ return lhs.pool() != rhs.pool(); }
+
+}  // namespace net
+}  // namespace muduo
+
+#endif  // MUDUO_NET_BUFFERPOOL_H
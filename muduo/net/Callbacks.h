@@ -11,6 +11,8 @@
 #ifndef MUDUO_NET_CALLBACKS_H
 #define MUDUO_NET_CALLBACKS_H
 
+#include "muduo/base/StringPiece.h"
+#include "muduo/base/Task.h"
 #include "muduo/base/Timestamp.h"
 
 #include <functional>
@@ -60,7 +62,7 @@ namespace net
 class Buffer;
 class TcpConnection;
 typedef std::shared_ptr<TcpConnection> TcpConnectionPtr;
-typedef std::function<void()> TimerCallback;
+typedef muduo::Task TimerCallback;  // move-only
 typedef std::function<void (const TcpConnectionPtr&)> ConnectionCallback;
 typedef std::function<void (const TcpConnectionPtr&)> CloseCallback;
 typedef std::function<void (const TcpConnectionPtr&)> WriteCompleteCallback;
@@ -71,6 +73,16 @@ typedef std::function<void (const TcpConnectionPtr&,
                             Buffer*,
                             Timestamp)> MessageCallback;
 
+class InetAddress;
+class UdpSocket;
+typedef std::shared_ptr<UdpSocket> UdpSocketPtr;
+
+// a datagram from peer
+typedef std::function<void (const UdpSocketPtr&,
+                            const InetAddress&,
+                            StringPiece,
+                            Timestamp)> UdpMessageCallback;
+
 void defaultConnectionCallback(const TcpConnectionPtr& conn);
 void defaultMessageCallback(const TcpConnectionPtr& conn,
                             Buffer* buffer,
@@ -27,7 +27,10 @@ Channel::Channel(EventLoop* loop, int fd__)
     events_(0),
     revents_(0),
     index_(-1),
+    dirty_(false),
+    registeredEvents_(0),
     logHup_(true),
+    edgeTriggered_(false),
     tied_(false),
     eventHandling_(false),
     addedToLoop_(false)
@@ -50,6 +53,15 @@ void Channel::tie(const std::shared_ptr<void>& obj)
   tied_ = true;
 }
 
+void Channel::setEdgeTriggered(bool on)
+{
+  edgeTriggered_ = on;
+  if (addedToLoop_ && !isNoneEvent())
+  {
+    update();
+  }
+}
+
 void Channel::update()
 {
   addedToLoop_ = true;
@@ -67,9 +67,20 @@ class Channel : noncopyable
   bool isWriting() const { return events_ & kWriteEvent; }
   bool isReading() const { return events_ & kReadEvent; }
 
+  /// With EPollPoller, reports events only when they arrive (EPOLLET),
+  /// so the callbacks must read or write until EAGAIN.
+  /// Other pollers stay level-triggered.
+  void setEdgeTriggered(bool on);
+  bool isEdgeTriggered() const { return edgeTriggered_; }
+
   // for Poller
   int index() { return index_; }
   void set_index(int idx) { index_ = idx; }
+  /// Changed since the Poller last applied it, for batching updates.
+  bool isDirty() const { return dirty_; }
+  void set_dirty(bool on) { dirty_ = on; }
+  int registeredEvents() const { return registeredEvents_; }
+  void set_registeredEvents(int ev) { registeredEvents_ = ev; }
 
   // for debug
   string reventsToString() const;
@@ -95,7 +106,10 @@ class Channel : noncopyable
   int        events_;
   int        revents_; // it's the received event types of epoll or poll
   int        index_; // used by Poller.
+  bool       dirty_; // used by Poller.
+  int        registeredEvents_; // used by Poller.
   bool       logHup_;
+  bool       edgeTriggered_;
 
   std::weak_ptr<void> tie_;
   bool tied_;
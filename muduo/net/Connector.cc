@@ -12,6 +12,7 @@
 #include "muduo/base/Logging.h"
 #include "muduo/net/Channel.h"
 #include "muduo/net/EventLoop.h"
+#include "muduo/net/Resolver.h"
 #include "muduo/net/SocketsOps.h"
 
 #include <errno.h>
@@ -24,6 +25,7 @@ const int Connector::kMaxRetryDelayMs;
 Connector::Connector(EventLoop* loop, const InetAddress& serverAddr)
   : loop_(loop),
     serverAddr_(serverAddr),
+    resolver_(NULL),
     connect_(false),
     state_(kDisconnected),
     retryDelayMs_(kInitRetryDelayMs)
@@ -31,6 +33,18 @@ Connector::Connector(EventLoop* loop, const InetAddress& serverAddr)
   LOG_DEBUG << "ctor[" << this << "]";
 }
 
+Connector::Connector(EventLoop* loop, Resolver* resolver, const string& hostname, uint16_t port)
+  : loop_(loop),
+    serverAddr_(port),
+    resolver_(CHECK_NOTNULL(resolver)),
+    hostname_(hostname),
+    connect_(false),
+    state_(kDisconnected),
+    retryDelayMs_(kInitRetryDelayMs)
+{
+  LOG_DEBUG << "ctor[" << this << "] " << hostname_ << ":" << port;
+}
+
 Connector::~Connector()
 {
   LOG_DEBUG << "dtor[" << this << "]";
@@ -46,10 +60,19 @@ void Connector::start()
 void Connector::startInLoop()
 {
   loop_->assertInLoopThread();
-  assert(state_ == kDisconnected);
+  assert(state_ != kConnecting);
+  // kConnected if started again after the last connection was handed over
+  setState(kDisconnected);
   if (connect_)
   {
-    connect();
+    if (resolver_)
+    {
+      resolve();
+    }
+    else
+    {
+      connect();
+    }
   }
   else
   {
@@ -57,6 +80,37 @@ void Connector::startInLoop()
   }
 }
 
+void Connector::resolve()
+{
+  resolver_->resolve(hostname_, std::bind(&Connector::onResolved, shared_from_this(), _1));
+}
+
+void Connector::onResolved(const std::vector<InetAddress>& addresses)
+{
+  loop_->runInLoop(std::bind(&Connector::connectResolved, shared_from_this(), addresses));
+}
+
+void Connector::connectResolved(const std::vector<InetAddress>& addresses)
+{
+  loop_->assertInLoopThread();
+  if (!connect_ || state_ != kDisconnected)
+  {
+    LOG_DEBUG << "do not connect";
+  }
+  else if (addresses.empty())
+  {
+    LOG_ERROR << "Connector::connectResolved - failed to resolve " << hostname_;
+    retryLater();
+  }
+  else
+  {
+    const uint16_t port = serverAddr_.port();
+    serverAddr_ = addresses.front();
+    serverAddr_.setPort(port);
+    connect();
+  }
+}
+
 void Connector::stop()
 {
   connect_ = false;
@@ -94,6 +148,7 @@ void Connector::connect()
     case EADDRNOTAVAIL:
     case ECONNREFUSED:
     case ENETUNREACH:
+    case ENOENT:  // AF_UNIX path not bound yet
       retry(sockfd);
       break;
 
@@ -209,10 +264,16 @@ void Connector::handleError()
 void Connector::retry(int sockfd)
 {
   sockets::close(sockfd);
+  retryLater();
+}
+
+void Connector::retryLater()
+{
   setState(kDisconnected);
   if (connect_)
   {
-    LOG_INFO << "Connector::retry - Retry connecting to " << serverAddr_.toIpPort()
+    LOG_INFO << "Connector::retry - Retry connecting to "
+             << (hostname_.empty() ? serverAddr_.toIpPort() : hostname_)
              << " in " << retryDelayMs_ << " milliseconds. ";
     loop_->runAfter(retryDelayMs_/1000.0,
                     std::bind(&Connector::startInLoop, shared_from_this()));
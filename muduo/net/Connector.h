@@ -16,6 +16,7 @@
 
 #include <functional>
 #include <memory>
+#include <vector>
 
 namespace muduo
 {
@@ -24,6 +25,7 @@ namespace net
 
 class Channel;
 class EventLoop;
+class Resolver;
 
 class Connector : noncopyable,
                   public std::enable_shared_from_this<Connector>
@@ -32,6 +34,9 @@ class Connector : noncopyable,
   typedef std::function<void (int sockfd)> NewConnectionCallback;
 
   Connector(EventLoop* loop, const InetAddress& serverAddr);
+  /// Resolves @c hostname with @c resolver on every attempt, and connects
+  /// to the first address. @c resolver must outlive this.
+  Connector(EventLoop* loop, Resolver* resolver, const string& hostname, uint16_t port);
   ~Connector();
 
   void setNewConnectionCallback(const NewConnectionCallback& cb)
@@ -41,7 +46,10 @@ class Connector : noncopyable,
   void restart();  // must be called in loop thread
   void stop();  // can be called in any thread
 
+  /// The last resolved one, if connecting by hostname.
   const InetAddress& serverAddress() const { return serverAddr_; }
+  /// Empty if connecting to an address.
+  const string& hostname() const { return hostname_; }
 
  private:
   enum States { kDisconnected, kConnecting, kConnected };
@@ -52,15 +60,22 @@ class Connector : noncopyable,
   void startInLoop();
   void stopInLoop();
   void connect();
+  void resolve();
+  // in resolver's loop
+  void onResolved(const std::vector<InetAddress>& addresses);
+  void connectResolved(const std::vector<InetAddress>& addresses);
   void connecting(int sockfd);
   void handleWrite();
   void handleError();
   void retry(int sockfd);
+  void retryLater();
   int removeAndResetChannel();
   void resetChannel();
 
   EventLoop* loop_;
   InetAddress serverAddr_;
+  Resolver* resolver_;  // NULL if not by hostname
+  const string hostname_;
   bool connect_; // atomic
   States state_;  // FIXME: use atomic variable
   std::unique_ptr<Channel> channel_;
@@ -9,15 +9,20 @@
 #include "muduo/net/EventLoop.h"
 
 #include "muduo/base/Logging.h"
-#include "muduo/base/Mutex.h"
+#include "muduo/net/BufferPool.h"
 #include "muduo/net/Channel.h"
 #include "muduo/net/Poller.h"
+#include "muduo/net/poller/IoUringPoller.h"
 #include "muduo/net/SocketsOps.h"
-#include "muduo/net/TimerQueue.h"
+#include "muduo/net/timer/SetTimerQueue.h"
+#include "muduo/net/timer/WheelTimerQueue.h"
 
 #include <algorithm>
 
+#include <cxxabi.h>
+
 #include <signal.h>
+#include <stdlib.h>
 #include <sys/eventfd.h>
 #include <unistd.h>
 
@@ -29,6 +34,8 @@ namespace
 __thread EventLoop* t_loopInThisThread = 0;
 
 const int kPollTimeMs = 10000;
+// busy ratio is measured over windows of this length
+const int64_t kLoadWindowMicroSeconds = 100*1000;
 
 int createEventfd()
 {
@@ -54,6 +61,24 @@ class IgnoreSigPipe
 #pragma GCC diagnostic error "-Wold-style-cast"
 
 IgnoreSigPipe initObj;
+
+string demangle(const std::type_info& type)
+{
+  int status = 0;
+  char* name = abi::__cxa_demangle(type.name(), NULL, NULL, &status);
+  string result(status == 0 && name ? name : type.name());
+  ::free(name);
+  return result;
+}
+
+TimerQueue* newTimerQueue(EventLoop* loop, EventLoop::TimerOption option)
+{
+  if (option == EventLoop::kTimingWheel)
+  {
+    return new WheelTimerQueue(loop);
+  }
+  return new SetTimerQueue(loop);
+}
 }  // namespace
 
 EventLoop* EventLoop::getEventLoopOfCurrentThread()
@@ -62,6 +87,11 @@ EventLoop* EventLoop::getEventLoopOfCurrentThread()
 }
 
 EventLoop::EventLoop()
+  : EventLoop(::getenv("MUDUO_USE_TIMING_WHEEL") ? kTimingWheel : kTimerSet)
+{
+}
+
+EventLoop::EventLoop(TimerOption option)
   : looping_(false),
     quit_(false),
     eventHandling_(false),
@@ -69,10 +99,27 @@ EventLoop::EventLoop()
     iteration_(0),
     threadId_(CurrentThread::tid()),
     poller_(Poller::newDefaultPoller(this)),
-    timerQueue_(new TimerQueue(this)),
+    ioUring_(NULL),
+    timerQueue_(newTimerQueue(this, option)),
+    bufferPool_(new BufferPool),
     wakeupFd_(createEventfd()),
     wakeupChannel_(new Channel(this, wakeupFd_)),
-    currentActiveChannel_(NULL)
+    currentActiveChannel_(NULL),
+    sleeping_(false),
+    wakeupPending_(false),
+    numConnections_(0),
+    pendingOutputBytes_(0),
+    busyPermille_(0),
+    busyUpdated_(0),
+    windowStart_(Timestamp::now()),
+    windowBusyMicroSeconds_(0),
+    bytesReceived_(0),
+    bytesSent_(0),
+    busyPollMicroSeconds_(0),
+    spinMicroSeconds_(0),
+    busyPollStats_(),
+    profiling_(false),
+    slowCallbackMicroSeconds_(0)
 {
   LOG_DEBUG << "EventLoop created " << this << " in thread " << threadId_;
   if (t_loopInThisThread)
@@ -84,6 +131,11 @@ EventLoop::EventLoop()
   {
     t_loopInThisThread = this;
   }
+  IoUringPoller* uring = dynamic_cast<IoUringPoller*>(poller_.get());
+  if (uring && uring->completionEnabled())
+  {
+    ioUring_ = uring;
+  }
   wakeupChannel_->setReadCallback(
       std::bind(&EventLoop::handleRead, this));
   // we are always reading the wakeupfd
@@ -100,6 +152,16 @@ EventLoop::~EventLoop()
   t_loopInThisThread = NULL;
 }
 
+Timestamp EventLoop::cachedNow()
+{
+  const EventLoop* loop = t_loopInThisThread;
+  if (loop && loop->looping_)
+  {
+    return loop->pollReturnTime_;
+  }
+  return Timestamp::now();
+}
+
 void EventLoop::loop()
 {
   assert(!looping_);
@@ -108,31 +170,171 @@ void EventLoop::loop()
   quit_ = false;  // FIXME: what if someone calls quit() before loop() ?
   LOG_TRACE << "EventLoop " << this << " start looping";
 
+  Timestamp iterationEnd;
   while (!quit_)
   {
     activeChannels_.clear();
-    pollReturnTime_ = poller_->poll(kPollTimeMs, &activeChannels_);
+    const bool spin = spinning(iterationEnd);
+    int timeoutMs = 0;
+    if (spin)
+    {
+      // queueInLoop() needs no wakeup while spinning
+      ++busyPollStats_.polls;
+    }
+    else
+    {
+      // pairs with queueInLoop(), which pushes before checking sleeping_
+      sleeping_ = true;
+      timeoutMs = pendingFunctors_.empty() ? kPollTimeMs : 0;
+    }
+    pollReturnTime_ = poller_->poll(timeoutMs, &activeChannels_);
+    sleeping_ = false;
     ++iteration_;
+    if (busyPollMicroSeconds_ > 0 && !activeChannels_.empty())
+    {
+      if (spin)
+      {
+        ++busyPollStats_.hits;
+        spinMicroSeconds_ = std::min(spinMicroSeconds_ * 2, busyPollMicroSeconds_);
+      }
+      spinUntil_ = Timestamp(pollReturnTime_.microSecondsSinceEpoch() + spinMicroSeconds_);
+    }
     if (Logger::logLevel() <= Logger::TRACE)
     {
       printActiveChannels();
     }
     // TODO sort channel by priority
     eventHandling_ = true;
+    // end of last callback, while profiling
+    Timestamp callbackEnd(pollReturnTime_);
     for (Channel* channel : activeChannels_)
     {
       currentActiveChannel_ = channel;
       currentActiveChannel_->handleEvent(pollReturnTime_);
+      if (profiling_)
+      {
+        Timestamp now(Timestamp::now());
+        int64_t us = now.microSecondsSinceEpoch() - callbackEnd.microSecondsSinceEpoch();
+        if (isSlowCallback(us))
+        {
+          LOG_WARN << "EventLoop " << this << " slow channel {"
+                   << channel->reventsToString() << "} took " << us << "us";
+        }
+        callbackEnd = now;
+      }
     }
     currentActiveChannel_ = NULL;
     eventHandling_ = false;
-    doPendingFunctors();
+    if (profiling_)
+    {
+      if (iterationEnd.valid())
+      {
+        profile_.pollWait.add(pollReturnTime_.microSecondsSinceEpoch()
+                              - iterationEnd.microSecondsSinceEpoch());
+      }
+      profile_.activeChannels.add(static_cast<int64_t>(activeChannels_.size()));
+      profile_.eventHandling.add(callbackEnd.microSecondsSinceEpoch()
+                                 - pollReturnTime_.microSecondsSinceEpoch());
+    }
+    doPendingFunctors(callbackEnd);
+    iterationEnd = Timestamp::now();
+    if (profiling_)
+    {
+      profile_.pendingFunctors.add(iterationEnd.microSecondsSinceEpoch()
+                                   - callbackEnd.microSecondsSinceEpoch());
+    }
+    updateBusyRatio(iterationEnd);
   }
+  // those queued after the last batch, e.g. by ~TcpServer before quit()
+  doPendingFunctors(Timestamp::now());
 
   LOG_TRACE << "EventLoop " << this << " stop looping";
   looping_ = false;
 }
 
+void EventLoop::setBusyPoll(int microseconds)
+{
+  assertInLoopThread();
+  busyPollMicroSeconds_ = std::max(microseconds, 0);
+  spinMicroSeconds_ = busyPollMicroSeconds_;
+  spinUntil_ = Timestamp::invalid();
+}
+
+void EventLoop::setProfiling(bool on, double slowCallbackSeconds)
+{
+  assertInLoopThread();
+  profiling_ = on;
+  slowCallbackMicroSeconds_ = on && slowCallbackSeconds > 0
+      ? static_cast<int64_t>(slowCallbackSeconds * Timestamp::kMicroSecondsPerSecond)
+      : 0;
+}
+
+bool EventLoop::isSlowCallback(int64_t microSeconds)
+{
+  if (slowCallbackMicroSeconds_ > 0 && microSeconds >= slowCallbackMicroSeconds_)
+  {
+    profile_.slowCallbacks.store(profile_.slowCallbacks.load(std::memory_order_relaxed) + 1,
+                                 std::memory_order_relaxed);
+    return true;
+  }
+  return false;
+}
+
+void EventLoop::countTimerCallback(int64_t microSeconds, const std::type_info& callback)
+{
+  profile_.timerCallbacks.add(microSeconds);
+  if (isSlowCallback(microSeconds))
+  {
+    LOG_WARN << "EventLoop " << this << " slow timer callback "
+             << demangle(callback) << " took " << microSeconds << "us";
+  }
+}
+
+bool EventLoop::spinning(Timestamp lastIterationEnd)
+{
+  if (!spinUntil_.valid())
+  {
+    return false;
+  }
+  if (lastIterationEnd < spinUntil_)
+  {
+    return true;
+  }
+  ++busyPollStats_.misses;
+  spinMicroSeconds_ = std::max(spinMicroSeconds_ / 2, std::max<int64_t>(busyPollMicroSeconds_ / 16, 1));
+  spinUntil_ = Timestamp::invalid();
+  return false;
+}
+
+void EventLoop::updateBusyRatio(Timestamp iterationEnd)
+{
+  windowBusyMicroSeconds_ += iterationEnd.microSecondsSinceEpoch()
+                             - pollReturnTime_.microSecondsSinceEpoch();
+  const int64_t elapsed = iterationEnd.microSecondsSinceEpoch()
+                          - windowStart_.microSecondsSinceEpoch();
+  if (elapsed >= kLoadWindowMicroSeconds)
+  {
+    const int64_t permille = std::min<int64_t>(windowBusyMicroSeconds_ * 1000 / elapsed, 1000);
+    busyPermille_.store(static_cast<int>(permille), std::memory_order_relaxed);
+    busyUpdated_.store(iterationEnd.microSecondsSinceEpoch(), std::memory_order_relaxed);
+    windowStart_ = iterationEnd;
+    windowBusyMicroSeconds_ = 0;
+  }
+}
+
+double EventLoop::busyRatio() const
+{
+  // a loop blocked in poll for a whole window is idle,
+  // though it has not updated since.
+  if (sleeping_
+      && Timestamp::now().microSecondsSinceEpoch()
+         - busyUpdated_.load(std::memory_order_relaxed) > 2 * kLoadWindowMicroSeconds)
+  {
+    return 0.0;
+  }
+  return busyPermille_.load(std::memory_order_relaxed) / 1000.0;
+}
+
 void EventLoop::quit()
 {
   quit_ = true;
@@ -159,12 +361,11 @@ void EventLoop::runInLoop(Functor cb)
 
 void EventLoop::queueInLoop(Functor cb)
 {
-  {
-  MutexLockGuard lock(mutex_);
-  pendingFunctors_.push_back(std::move(cb));
-  }
+  pendingFunctors_.push(std::move(cb));
 
-  if (!isInLoopThread() || callingPendingFunctors_)
+  // Otherwise the loop sees cb before it sleeps, or has been woken up
+  // and will run cb in doPendingFunctors().
+  if (sleeping_ && !wakeupPending_.exchange(true))
   {
     wakeup();
   }
@@ -172,7 +373,6 @@ void EventLoop::queueInLoop(Functor cb)
 
 size_t EventLoop::queueSize() const
 {
-  MutexLockGuard lock(mutex_);
   return pendingFunctors_.size();
 }
 
@@ -251,19 +451,31 @@ void EventLoop::handleRead()
   }
 }
 
-void EventLoop::doPendingFunctors()
+void EventLoop::doPendingFunctors(Timestamp start)
 {
-  std::vector<Functor> functors;
   callingPendingFunctors_ = true;
-
-  {
-  MutexLockGuard lock(mutex_);
-  functors.swap(pendingFunctors_);
-  }
-
-  for (const Functor& functor : functors)
+  // before popping, so functors of producers which skipped wakeup()
+  // as one was pending are seen below
+  wakeupPending_.exchange(false);
+
+  // only those queued so far, later ones run in next iteration
+  size_t n = pendingFunctors_.size();
+  Functor functor;
+  while (n > 0 && pendingFunctors_.pop(&functor))
   {
     functor();
+    if (profiling_)
+    {
+      Timestamp now(Timestamp::now());
+      int64_t us = now.microSecondsSinceEpoch() - start.microSecondsSinceEpoch();
+      if (isSlowCallback(us))
+      {
+        LOG_WARN << "EventLoop " << this << " slow functor "
+                 << demangle(functor.targetType()) << " took " << us << "us";
+      }
+      start = now;
+    }
+    --n;
   }
   callingPendingFunctors_ = false;
 }
@@ -19,6 +19,9 @@
 
 #include "muduo/base/Mutex.h"
 #include "muduo/base/CurrentThread.h"
+#include "muduo/base/Histogram.h"
+#include "muduo/base/MpscQueue.h"
+#include "muduo/base/Task.h"
 #include "muduo/base/Timestamp.h"
 #include "muduo/net/Callbacks.h"
 #include "muduo/net/TimerId.h"
@@ -28,7 +31,9 @@ namespace muduo
 namespace net
 {
 
+class BufferPool;
 class Channel;
+class IoUringPoller;
 class Poller;
 class TimerQueue;
 
@@ -39,9 +44,18 @@ class TimerQueue;
 class EventLoop : noncopyable
 {
  public:
-  typedef std::function<void()> Functor;
+  typedef muduo::Task Functor;
 
+  /// How timers are kept.
+  enum TimerOption
+  {
+    kTimerSet,  // sorted, fires on time
+    kTimingWheel,  // O(1) to add and cancel, fires within 1ms late
+  };
+
+  /// kTimingWheel if MUDUO_USE_TIMING_WHEEL is set, otherwise kTimerSet.
   EventLoop();
+  explicit EventLoop(TimerOption option);
   ~EventLoop();  // force out-line dtor, for std::unique_ptr members.
 
   ///
@@ -53,6 +67,7 @@ class EventLoop : noncopyable
 
   /// Quits loop.
   ///
+  /// Functors queued before it still run.
   /// This is not 100% thread safe, if you call through a raw pointer,
   /// better to call through shared_ptr<EventLoop> for 100% safety.
   void quit();
@@ -64,6 +79,61 @@ class EventLoop : noncopyable
 
   int64_t iteration() const { return iteration_; }
 
+  ///
+  /// Time when poll returns in the loop of this thread, read once per
+  /// iteration. Cheaper than Timestamp::now(), but behind it by the time
+  /// spent in this iteration so far.
+  /// Outside of a looping EventLoop, same as Timestamp::now().
+  ///
+  static Timestamp cachedNow();
+
+  ///
+  /// Low latency mode, after events, keeps polling without blocking
+  /// for up to @c microseconds, so that the next message doesn't wait
+  /// for a wakeup. It burns the CPU while spinning.
+  /// The spin adapts between 1/16 and all of the budget, growing when
+  /// events come in time, and shrinking when they don't.
+  /// 0 to always block, the default. Call it in the loop thread.
+  ///
+  void setBusyPoll(int microseconds);
+
+  struct BusyPollStats
+  {
+    int64_t polls;  // non-blocking polls while spinning
+    int64_t hits;  // spins which got events
+    int64_t misses;  // spins which ran out and blocked
+
+    double hitRate() const
+    { return hits + misses > 0 ? static_cast<double>(hits) / static_cast<double>(hits + misses) : 0.0; }
+  };
+  /// Call it in the loop thread.
+  BusyPollStats busyPollStats() const { return busyPollStats_; }
+
+  /// Where the time of iterations goes, kept while profiling.
+  /// Safe to read from other threads, may be a little stale.
+  struct Profile
+  {
+    Histogram pollWait;  // microseconds blocked or spinning in poll
+    Histogram activeChannels;  // per poll
+    Histogram eventHandling;  // microseconds handling events of a poll
+    Histogram pendingFunctors;  // microseconds in pending functors of an iteration
+    Histogram timerCallbacks;  // microseconds per timer callback
+    std::atomic<int64_t> slowCallbacks;
+
+    Profile() : slowCallbacks(0) {}
+  };
+
+  ///
+  /// Profiles iterations, at the cost of a clock read per callback.
+  /// If @c slowCallbackSeconds > 0, logs channels, functors and timer
+  /// callbacks which run at least that long, eg. blocking the loop.
+  /// A slow timer callback is logged, then its timerfd channel too.
+  /// Off by default. Call it in the loop thread.
+  ///
+  void setProfiling(bool on, double slowCallbackSeconds = 0.0);
+  bool profiling() const { return profiling_; }
+  const Profile& profile() const { return profile_; }
+
   /// Runs callback immediately in the loop thread.
   /// It wakes up the loop, and run the cb.
   /// If in the same loop thread, cb is run within the function.
@@ -71,7 +141,8 @@ class EventLoop : noncopyable
   void runInLoop(Functor cb);
   /// Queues callback in the loop thread.
   /// Runs after finish pooling.
-  /// Safe to call from other threads.
+  /// Safe to call from other threads, lock-free, and only wakes up
+  /// the loop if it is blocked in poll and not woken up yet.
   void queueInLoop(Functor cb);
 
   size_t queueSize() const;
@@ -104,6 +175,11 @@ class EventLoop : noncopyable
   void updateChannel(Channel* channel);
   void removeChannel(Channel* channel);
   bool hasChannel(Channel* channel);
+  // by TimerQueue while profiling
+  void countTimerCallback(int64_t microSeconds, const std::type_info& callback);
+  /// For completion based I/O, NULL unless MUDUO_USE_IO_URING and
+  /// MUDUO_IO_URING_COMPLETION are set, and supported by the kernel.
+  IoUringPoller* ioUring() const { return ioUring_; }
 
   // pid_t threadId() const { return threadId_; }
   void assertInLoopThread()
@@ -126,12 +202,42 @@ class EventLoop : noncopyable
   boost::any* getMutableContext()
   { return &context_; }
 
+  /// Load of this loop, for placing new connections.
+  /// Safe to read from other threads, may be a little stale.
+  int numConnections() const { return numConnections_.load(std::memory_order_relaxed); }
+  /// Bytes queued in output buffers of connections.
+  int64_t pendingOutputBytes() const { return pendingOutputBytes_.load(std::memory_order_relaxed); }
+  /// Fraction of the last 100ms spent out of poll, 0.0 to 1.0.
+  double busyRatio() const;
+  /// Bytes read and written by connections of this loop, so far.
+  /// Safe to read from other threads.
+  int64_t bytesReceived() const { return bytesReceived_.load(std::memory_order_relaxed); }
+  int64_t bytesSent() const { return bytesSent_.load(std::memory_order_relaxed); }
+
+  // internal usage, by TcpConnection
+  void addConnections(int delta)
+  { numConnections_.fetch_add(delta, std::memory_order_relaxed); }
+  void addPendingOutputBytes(int64_t delta)
+  { pendingOutputBytes_.fetch_add(delta, std::memory_order_relaxed); }
+  // in loop thread, the only writer, so no locked add
+  void addBytesReceived(int64_t n)
+  { bytesReceived_.store(bytesReceived_.load(std::memory_order_relaxed) + n, std::memory_order_relaxed); }
+  void addBytesSent(int64_t n)
+  { bytesSent_.store(bytesSent_.load(std::memory_order_relaxed) + n, std::memory_order_relaxed); }
+
+  /// Memory pool for Buffers of connections in this loop.
+  const std::shared_ptr<BufferPool>& bufferPool() const { return bufferPool_; }
+
   static EventLoop* getEventLoopOfCurrentThread();
 
  private:
   void abortNotInLoopThread();
   void handleRead();  // waked up
-  void doPendingFunctors();
+  void doPendingFunctors(Timestamp start);
+  bool isSlowCallback(int64_t microSeconds);
+  void updateBusyRatio(Timestamp iterationEnd);
+  // decides by the end of last iteration
+  bool spinning(Timestamp lastIterationEnd);
 
   void printActiveChannels() const; // DEBUG
 
@@ -145,7 +251,9 @@ class EventLoop : noncopyable
   const pid_t threadId_;
   Timestamp pollReturnTime_;
   std::unique_ptr<Poller> poller_;
+  IoUringPoller* ioUring_;  // poller_ if completion based I/O is on
   std::unique_ptr<TimerQueue> timerQueue_;
+  std::shared_ptr<BufferPool> bufferPool_;
   int wakeupFd_;
   // unlike in TimerQueue, which is an internal class,
   // we don't expose Channel to client.
@@ -156,8 +264,32 @@ class EventLoop : noncopyable
   ChannelList activeChannels_;
   Channel* currentActiveChannel_;
 
-  mutable MutexLock mutex_;
-  std::vector<Functor> pendingFunctors_ GUARDED_BY(mutex_);
+  MpscQueue<Functor> pendingFunctors_;
+  std::atomic<bool> sleeping_;  // in poll with a timeout
+  std::atomic<bool> wakeupPending_;  // wakeupFd_ written since last doPendingFunctors()
+
+  // load
+  std::atomic<int> numConnections_;
+  std::atomic<int64_t> pendingOutputBytes_;
+  std::atomic<int> busyPermille_;  // of the last window
+  std::atomic<int64_t> busyUpdated_;  // microseconds since epoch
+  Timestamp windowStart_;
+  int64_t windowBusyMicroSeconds_;
+
+  // traffic
+  std::atomic<int64_t> bytesReceived_;
+  std::atomic<int64_t> bytesSent_;
+
+  // busy poll
+  int64_t busyPollMicroSeconds_;  // budget, 0 if off
+  int64_t spinMicroSeconds_;  // adapted
+  Timestamp spinUntil_;  // invalid if not spinning
+  BusyPollStats busyPollStats_;
+
+  // profiling
+  bool profiling_;
+  int64_t slowCallbackMicroSeconds_;  // 0 if not logged
+  Profile profile_;
 };
 
 }  // namespace net
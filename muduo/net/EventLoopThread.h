@@ -30,6 +30,10 @@ class EventLoopThread : noncopyable
   EventLoopThread(const ThreadInitCallback& cb = ThreadInitCallback(),
                   const string& name = string());
   ~EventLoopThread();
+  /// The loop is created after pinning, in memory of the local NUMA node.
+  /// Must be called before startLoop().
+  void setCpuAffinity(const std::vector<int>& cpus)
+  { thread_.setCpuAffinity(cpus); }
   EventLoop* startLoop();
 
  private:
@@ -8,6 +8,8 @@
 
 #include "muduo/net/EventLoopThreadPool.h"
 
+#include "muduo/base/Logging.h"
+#include "muduo/base/ProcessInfo.h"
 #include "muduo/net/EventLoop.h"
 #include "muduo/net/EventLoopThread.h"
 
@@ -21,7 +23,9 @@ EventLoopThreadPool::EventLoopThreadPool(EventLoop* baseLoop, const string& name
     name_(nameArg),
     started_(false),
     numThreads_(0),
-    next_(0)
+    next_(0),
+    placement_(kRoundRobin),
+    isolateBaseLoop_(false)
 {
 }
 
@@ -37,11 +41,31 @@ void EventLoopThreadPool::start(const ThreadInitCallback& cb)
 
   started_ = true;
 
+  std::vector<int> cpus(cpus_);
+  if ((isolateBaseLoop_ || numThreads_ == 0) && !cpus.empty())
+  {
+    // with no threads, the base loop is loop 0
+    LOG_INFO << "EventLoopThreadPool [" << name_ << "] - base loop on cpu " << cpus[0]
+             << " node " << ProcessInfo::numaNodeOfCpu(cpus[0]);
+    CurrentThread::setCpuAffinity(std::vector<int>(1, cpus[0]));
+    if (isolateBaseLoop_)
+    {
+      cpus.erase(cpus.begin());
+    }
+  }
+
   for (int i = 0; i < numThreads_; ++i)
   {
     char buf[name_.size() + 32];
     snprintf(buf, sizeof buf, "%s%d", name_.c_str(), i);
     EventLoopThread* t = new EventLoopThread(cb, buf);
+    if (!cpus.empty())
+    {
+      const int cpu = cpus[static_cast<size_t>(i) % cpus.size()];
+      LOG_INFO << "EventLoopThreadPool [" << name_ << "] - " << buf << " on cpu " << cpu
+               << " node " << ProcessInfo::numaNodeOfCpu(cpu);
+      t->setCpuAffinity(std::vector<int>(1, cpu));
+    }
     threads_.push_back(std::unique_ptr<EventLoopThread>(t));
     loops_.push_back(t->startLoop());
   }
@@ -57,17 +81,56 @@ EventLoop* EventLoopThreadPool::getNextLoop()
   assert(started_);
   EventLoop* loop = baseLoop_;
 
-  if (!loops_.empty())
+  if (loops_.empty())
   {
-    // round-robin
-    loop = loops_[next_];
-    ++next_;
-    if (implicit_cast<size_t>(next_) >= loops_.size())
+    return loop;
+  }
+  if (placementCallback_)
+  {
+    return placementCallback_(loops_);
+  }
+
+  switch (placement_)
+  {
+    case kLeastConnections:
+      loop = leastLoaded([](EventLoop* l) { return l->numConnections(); });
+      break;
+    case kLeastPendingBytes:
+      loop = leastLoaded([](EventLoop* l) { return l->pendingOutputBytes(); });
+      break;
+    case kLeastBusy:
+      loop = leastLoaded([](EventLoop* l) { return l->busyRatio(); });
+      break;
+    default:
+      loop = loops_[next_];
+      break;
+  }
+  ++next_;
+  if (implicit_cast<size_t>(next_) >= loops_.size())
+  {
+    next_ = 0;
+  }
+  return loop;
+}
+
+template<typename Load>
+EventLoop* EventLoopThreadPool::leastLoaded(Load load)
+{
+  const size_t n = loops_.size();
+  const size_t first = implicit_cast<size_t>(next_);
+  EventLoop* least = loops_[first];
+  auto leastLoad = load(least);
+  for (size_t i = 1; i < n; ++i)
+  {
+    EventLoop* loop = loops_[(first + i) % n];
+    auto l = load(loop);
+    if (l < leastLoad)
     {
-      next_ = 0;
+      least = loop;
+      leastLoad = l;
     }
   }
-  return loop;
+  return least;
 }
 
 EventLoop* EventLoopThreadPool::getLoopForHash(size_t hashCode)
@@ -6,7 +6,7 @@
 
 // Author: Shuo Chen (chenshuo at chenshuo dot com)
 //
-// This is an internal header file, you should not include this.
+// This is a public header file, it must only include public header files.
 
 #ifndef MUDUO_NET_EVENTLOOPTHREADPOOL_H
 #define MUDUO_NET_EVENTLOOPTHREADPOOL_H
@@ -31,14 +31,35 @@ class EventLoopThreadPool : noncopyable
 {
  public:
   typedef std::function<void(EventLoop*)> ThreadInitCallback;
+  /// Picks one of the loops for a new connection.
+  typedef std::function<EventLoop*(const std::vector<EventLoop*>&)> PlacementCallback;
+
+  /// How getNextLoop() places connections.
+  enum Placement
+  {
+    kRoundRobin,
+    kLeastConnections,
+    kLeastPendingBytes,  // queued for output
+    kLeastBusy,  // in the last 100ms
+  };
 
   EventLoopThreadPool(EventLoop* baseLoop, const string& nameArg);
   ~EventLoopThreadPool();
   void setThreadNum(int numThreads) { numThreads_ = numThreads; }
+  void setPlacement(Placement placement) { placement_ = placement; }
+  /// Overrides setPlacement().
+  void setPlacementCallback(const PlacementCallback& cb) { placementCallback_ = cb; }
+  /// Pins loop i to cpus[i % cpus.size()].
+  /// With isolateBaseLoop, the thread of baseLoop is pinned to cpus[0]
+  /// and loops to the rest, so accepting never waits for I/O.
+  /// See ProcessInfo::cpusOfNumaNode() to keep loops on one node.
+  void setCpuAffinity(const std::vector<int>& cpus, bool isolateBaseLoop = false)
+  { cpus_ = cpus; isolateBaseLoop_ = isolateBaseLoop; }
   void start(const ThreadInitCallback& cb = ThreadInitCallback());
 
   // valid after calling start()
-  /// round-robin
+  /// round-robin by default, see setPlacement().
+  /// Ties of load are broken round-robin.
   EventLoop* getNextLoop();
 
   /// with the same hash code, it will always return the same EventLoop
@@ -53,12 +74,19 @@ class EventLoopThreadPool : noncopyable
   { return name_; }
 
  private:
+  // the loop of least load, starting from next_
+  template<typename Load>
+  EventLoop* leastLoaded(Load load);
 
   EventLoop* baseLoop_;
   string name_;
   bool started_;
   int numThreads_;
   int next_;
+  Placement placement_;
+  PlacementCallback placementCallback_;
+  std::vector<int> cpus_;
+  bool isolateBaseLoop_;
   std::vector<std::unique_ptr<EventLoopThread>> threads_;
   std::vector<EventLoop*> loops_;
 };
@@ -45,8 +45,8 @@ static const in_addr_t kInaddrLoopback = INADDR_LOOPBACK;
 using namespace muduo;
 using namespace muduo::net;
 
-static_assert(sizeof(InetAddress) == sizeof(struct sockaddr_in6),
-              "InetAddress is same size as sockaddr_in6");
+static_assert(sizeof(InetAddress) < sizeof(struct sockaddr_un) + alignof(struct sockaddr_in6),
+              "InetAddress is same size as sockaddr_un, aligned");
 static_assert(offsetof(sockaddr_in, sin_family) == 0, "sin_family offset 0");
 static_assert(offsetof(sockaddr_in6, sin6_family) == 0, "sin6_family offset 0");
 static_assert(offsetof(sockaddr_in, sin_port) == 2, "sin_port offset 2");
@@ -56,6 +56,7 @@ InetAddress::InetAddress(uint16_t portArg, bool loopbackOnly, bool ipv6)
 {
   static_assert(offsetof(InetAddress, addr6_) == 0, "addr6_ offset 0");
   static_assert(offsetof(InetAddress, addr_) == 0, "addr_ offset 0");
+  static_assert(offsetof(InetAddress, addrUn_) == 0, "addrUn_ offset 0");
   if (ipv6)
   {
     memZero(&addr6_, sizeof addr6_);
@@ -88,8 +89,64 @@ InetAddress::InetAddress(StringArg ip, uint16_t portArg, bool ipv6)
   }
 }
 
+InetAddress InetAddress::unixDomain(StringArg path)
+{
+  struct sockaddr_un addr;
+  memZero(&addr, sizeof addr);
+  addr.sun_family = AF_UNIX;
+  const size_t len = strlen(path.c_str());
+  if (len >= sizeof addr.sun_path)
+  {
+    LOG_FATAL << "InetAddress::unixDomain path too long " << path.c_str();
+  }
+  // abstract names start with '\0' instead of '@'
+  memcpy(addr.sun_path, path.c_str(), len);
+  if (addr.sun_path[0] == '@')
+  {
+    addr.sun_path[0] = '\0';
+  }
+  return InetAddress(addr);
+}
+
+InetAddress InetAddress::localAddressOf(int sockfd)
+{
+  struct sockaddr_un addr;
+  sockets::getLocalAddr(sockfd, sockets::sockaddr_cast(&addr), static_cast<socklen_t>(sizeof addr));
+  return InetAddress(addr);
+}
+
+InetAddress InetAddress::peerAddressOf(int sockfd)
+{
+  struct sockaddr_un addr;
+  sockets::getPeerAddr(sockfd, sockets::sockaddr_cast(&addr), static_cast<socklen_t>(sizeof addr));
+  return InetAddress(addr);
+}
+
+string InetAddress::unixPath() const
+{
+  if (family() != AF_UNIX)
+  {
+    return string();
+  }
+  const char* path = addrUn_.sun_path;
+  const size_t pathSize = sizeof addrUn_.sun_path;
+  if (path[0] != '\0')
+  {
+    return string(path, strnlen(path, pathSize));
+  }
+  if (path[1] != '\0')
+  {
+    return "@" + string(path + 1, strnlen(path + 1, pathSize - 1));
+  }
+  return string();
+}
+
 string InetAddress::toIpPort() const
 {
+  if (family() == AF_UNIX)
+  {
+    return "unix:" + unixPath();
+  }
   char buf[64] = "";
   sockets::toIpPort(buf, sizeof buf, getSockAddr());
   return buf;
@@ -97,6 +154,10 @@ string InetAddress::toIpPort() const
 
 string InetAddress::toIp() const
 {
+  if (family() == AF_UNIX)
+  {
+    return "unix:" + unixPath();
+  }
   char buf[64] = "";
   sockets::toIp(buf, sizeof buf, getSockAddr());
   return buf;
@@ -113,6 +174,13 @@ uint16_t InetAddress::port() const
   return sockets::networkToHost16(portNetEndian());
 }
 
+void InetAddress::setPort(uint16_t portArg)
+{
+  assert(family() == AF_INET || family() == AF_INET6);
+  // same offset of sin_port and sin6_port
+  addr_.sin_port = sockets::hostToNetwork16(portArg);
+}
+
 static __thread char t_resolveBuffer[64 * 1024];
 
 bool InetAddress::resolve(StringArg hostname, InetAddress* out)
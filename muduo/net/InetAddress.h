@@ -15,6 +15,7 @@
 #include "muduo/base/StringPiece.h"
 
 #include <netinet/in.h>
+#include <sys/un.h>
 
 namespace muduo
 {
@@ -26,7 +27,8 @@ const struct sockaddr* sockaddr_cast(const struct sockaddr_in6* addr);
 }
 
 ///
-/// Wrapper of sockaddr_in.
+/// Wrapper of sockaddr_in, sockaddr_in6, or sockaddr_un of AF_UNIX
+/// stream sockets, for local peers.
 ///
 /// This is an POD interface class.
 class InetAddress : public muduo::copyable
@@ -50,10 +52,28 @@ class InetAddress : public muduo::copyable
     : addr6_(addr)
   { }
 
+  /// Constructs an endpoint of any family, in a sockaddr_un sized buffer.
+  explicit InetAddress(const struct sockaddr_un& addr)
+    : addrUn_(addr)
+  { }
+
+  /// Constructs an AF_UNIX endpoint, a filesystem @c path, or an abstract
+  /// name if it starts with '@', eg. "/run/cache.sock" or "@cache".
+  /// Aborts if it's longer than sun_path.
+  static InetAddress unixDomain(StringArg path);
+
+  /// Local and peer address of a socket, of any family.
+  static InetAddress localAddressOf(int sockfd);
+  static InetAddress peerAddressOf(int sockfd);
+
   sa_family_t family() const { return addr_.sin_family; }
+  /// "unix:" and unixPath() for AF_UNIX.
   string toIp() const;
   string toIpPort() const;
+  /// 0 for AF_UNIX.
   uint16_t port() const;
+  /// Path of AF_UNIX, '@' and the name if abstract, empty if unnamed.
+  string unixPath() const;
 
   // default copy/assignment are Okay
 
@@ -61,7 +81,9 @@ class InetAddress : public muduo::copyable
   void setSockAddrInet6(const struct sockaddr_in6& addr6) { addr6_ = addr6; }
 
   uint32_t ipv4NetEndian() const;
-  uint16_t portNetEndian() const { return addr_.sin_port; }
+  /// Not for AF_UNIX.
+  void setPort(uint16_t port);
+  uint16_t portNetEndian() const { return family() == AF_UNIX ? 0 : addr_.sin_port; }
 
   // resolve hostname to IP address, not changing port or sin_family
   // return true on success.
@@ -77,6 +99,7 @@ class InetAddress : public muduo::copyable
   {
     struct sockaddr_in addr_;
     struct sockaddr_in6 addr6_;
+    struct sockaddr_un addrUn_;
   };
 };
 
@@ -0,0 +1,608 @@
+// Use of this source code is governed by a BSD-style license
+// that can be found in the License file.
+
+#include "muduo/net/Resolver.h"
+
+#include "muduo/base/CurrentThread.h"
+#include "muduo/base/Logging.h"
+#include "muduo/net/EventLoop.h"
+#include "muduo/net/UdpSocket.h"
+
+#include <algorithm>
+#include <fstream>
+#include <sstream>
+
+#include <arpa/inet.h>
+#include <ctype.h>
+#include <string.h>
+
+using namespace muduo;
+using namespace muduo::net;
+
+namespace
+{
+
+// RFC 1035
+const size_t kHeaderSize = 12;
+const uint16_t kFlagResponse = 0x8000;
+const uint16_t kFlagRecursionDesired = 0x0100;
+const uint16_t kRcodeMask = 0x000F;
+const uint16_t kRcodeNoError = 0;
+const uint16_t kRcodeNameError = 3;
+const uint16_t kTypeA = 1;
+const uint16_t kTypeAAAA = 28;
+const uint16_t kClassIN = 1;
+const size_t kMaxNameLength = 253;
+const size_t kMaxLabelLength = 63;
+const int kMaxPointers = 16;
+const uint16_t kDnsPort = 53;
+
+uint16_t readUint16(const char* p)
+{
+  return static_cast<uint16_t>((static_cast<uint8_t>(p[0]) << 8) | static_cast<uint8_t>(p[1]));
+}
+
+uint32_t readUint32(const char* p)
+{
+  return (static_cast<uint32_t>(readUint16(p)) << 16) | readUint16(p + 2);
+}
+
+void appendUint16(string* out, uint16_t x)
+{
+  out->push_back(static_cast<char>(x >> 8));
+  out->push_back(static_cast<char>(x & 0xFF));
+}
+
+string toLower(const string& s)
+{
+  string result(s);
+  for (char& c : result)
+  {
+    c = static_cast<char>(::tolower(static_cast<unsigned char>(c)));
+  }
+  return result;
+}
+
+// lower case, without the trailing dot
+string normalize(const string& hostname)
+{
+  string name = toLower(hostname);
+  if (!name.empty() && name.back() == '.')
+  {
+    name.pop_back();
+  }
+  return name;
+}
+
+bool isValidName(const string& name)
+{
+  if (name.empty() || name.size() > kMaxNameLength)
+  {
+    return false;
+  }
+  size_t start = 0;
+  while (start <= name.size())
+  {
+    size_t dot = std::min(name.find('.', start), name.size());
+    if (dot == start || dot - start > kMaxLabelLength)
+    {
+      return false;
+    }
+    start = dot + 1;
+  }
+  return true;
+}
+
+string makeQuery(uint16_t id, const string& name, uint16_t type)
+{
+  string query;
+  query.reserve(kHeaderSize + name.size() + 6);
+  appendUint16(&query, id);
+  appendUint16(&query, kFlagRecursionDesired);
+  appendUint16(&query, 1);  // questions
+  appendUint16(&query, 0);  // answers
+  appendUint16(&query, 0);  // authorities
+  appendUint16(&query, 0);  // additionals
+  size_t start = 0;
+  while (start < name.size())
+  {
+    size_t dot = std::min(name.find('.', start), name.size());
+    query.push_back(static_cast<char>(dot - start));
+    query.append(name, start, dot - start);
+    start = dot + 1;
+  }
+  query.push_back('\0');
+  appendUint16(&query, type);
+  appendUint16(&query, kClassIN);
+  return query;
+}
+
+// Reads a name at *offset, which may end with a pointer to another,
+// and moves *offset past it. Returns false if malformed.
+bool readName(const char* data, size_t len, size_t* offset, string* name)
+{
+  name->clear();
+  size_t pos = *offset;
+  bool jumped = false;
+  int pointers = 0;
+  while (pos < len)
+  {
+    const uint8_t labelLength = static_cast<uint8_t>(data[pos]);
+    if (labelLength == 0)
+    {
+      if (!jumped)
+      {
+        *offset = pos + 1;
+      }
+      return true;
+    }
+    else if ((labelLength & 0xC0) == 0xC0)
+    {
+      if (pos + 1 >= len || ++pointers > kMaxPointers)
+      {
+        return false;
+      }
+      if (!jumped)
+      {
+        *offset = pos + 2;
+        jumped = true;
+      }
+      pos = static_cast<size_t>(readUint16(data + pos) & 0x3FFF);
+    }
+    else if (labelLength > kMaxLabelLength || pos + 1 + labelLength > len)
+    {
+      return false;
+    }
+    else
+    {
+      if (!name->empty())
+      {
+        name->push_back('.');
+      }
+      name->append(data + pos + 1, labelLength);
+      pos += 1 + labelLength;
+    }
+  }
+  return false;
+}
+
+}  // namespace
+
+Resolver::Resolver(EventLoop* loop, const Options& options)
+  : loop_(CHECK_NOTNULL(loop)),
+    options_(options),
+    nameservers_(options.nameservers),
+    idState_(static_cast<uint64_t>(Timestamp::now().microSecondsSinceEpoch())
+             ^ (static_cast<uint64_t>(CurrentThread::tid()) << 32)
+             ^ reinterpret_cast<uintptr_t>(this)),
+    queriesSent_(0),
+    cacheHits_(0),
+    timeouts_(0)
+{
+  if (!options_.hostsFile.empty())
+  {
+    readHostsFile(options_.hostsFile);
+  }
+  if (nameservers_.empty())
+  {
+    readResolvConf(options_.resolvConf);
+  }
+  for (InetAddress& server : nameservers_)
+  {
+    if (server.port() == 0)
+    {
+      server.setPort(kDnsPort);
+    }
+  }
+  if (nameservers_.empty())
+  {
+    LOG_WARN << "Resolver - no name servers, only hosts file and IP literals";
+  }
+}
+
+Resolver::~Resolver()
+{
+  loop_->assertInLoopThread();
+  for (const auto& entry : queries_)
+  {
+    loop_->cancel(entry.second->timer);
+  }
+  if (socket4_)
+  {
+    socket4_->stop();
+  }
+  if (socket6_)
+  {
+    socket6_->stop();
+  }
+}
+
+void Resolver::resolve(const string& hostname, Callback cb)
+{
+  if (loop_->isInLoopThread())
+  {
+    resolveInLoop(hostname, std::move(cb));
+  }
+  else
+  {
+    loop_->queueInLoop(std::bind(&Resolver::resolveInLoop, this, hostname, std::move(cb)));
+  }
+}
+
+void Resolver::resolveInLoop(const string& hostname, Callback cb)
+{
+  loop_->assertInLoopThread();
+  const string name = normalize(hostname);
+  AddressList addresses;
+  if (lookupLocal(name, &addresses))
+  {
+    cb(addresses);
+    return;
+  }
+
+  auto cached = cache_.find(name);
+  if (cached != cache_.end())
+  {
+    if (Timestamp::now() < cached->second.expiration)
+    {
+      ++cacheHits_;
+      cb(cached->second.addresses);
+      return;
+    }
+    cache_.erase(cached);
+  }
+
+  auto pending = queries_.find(name);
+  if (pending != queries_.end())
+  {
+    pending->second->callbacks.push_back(std::move(cb));
+    return;
+  }
+
+  if (nameservers_.empty() || !isValidName(name))
+  {
+    cb(addresses);
+    return;
+  }
+
+  std::unique_ptr<Query> query(new Query);
+  query->name = name;
+  query->callbacks.push_back(std::move(cb));
+  for (int t = 0; t < kNumTypes; ++t)
+  {
+    query->ids[t] = nextId();
+    query->answered[t] = (t == kAAAA && !options_.ipv6);
+    queriesById_[query->ids[t]] = query.get();
+  }
+  query->ttl = static_cast<uint32_t>(options_.maxTtl);
+  query->server = 0;
+  query->tries = 0;
+  Query* q = query.get();
+  queries_[name] = std::move(query);
+  sendQuery(q);
+}
+
+bool Resolver::lookupLocal(const string& name, AddressList* addresses)
+{
+  struct in6_addr ip;
+  if (::inet_pton(AF_INET, name.c_str(), &ip) == 1
+      || ::inet_pton(AF_INET6, name.c_str(), &ip) == 1)
+  {
+    addresses->push_back(InetAddress(name, 0));
+    return true;
+  }
+  auto it = hosts_.find(name);
+  if (it != hosts_.end())
+  {
+    *addresses = it->second;
+    return true;
+  }
+  return false;
+}
+
+void Resolver::sendQuery(Query* query)
+{
+  const InetAddress& server = nameservers_[query->server];
+  const UdpSocketPtr& socket = socketOf(server.family());
+  for (int t = 0; t < kNumTypes; ++t)
+  {
+    if (!query->answered[t])
+    {
+      socket->send(server, makeQuery(query->ids[t], query->name, t == kA ? kTypeA : kTypeAAAA));
+      ++queriesSent_;
+    }
+  }
+  query->timer = loop_->runAfter(options_.timeout,
+                                 std::bind(&Resolver::onTimeout, this, query->name));
+}
+
+void Resolver::onTimeout(const string& name)
+{
+  auto it = queries_.find(name);
+  if (it == queries_.end())
+  {
+    return;
+  }
+  ++timeouts_;
+  Query* query = it->second.get();
+  LOG_WARN << "Resolver - " << name << " timed out at "
+           << nameservers_[query->server].toIpPort();
+  nextServer(query);
+}
+
+void Resolver::nextServer(Query* query)
+{
+  ++query->tries;
+  if (static_cast<size_t>(query->tries) >= static_cast<size_t>(options_.attempts) * nameservers_.size())
+  {
+    finish(query);
+  }
+  else
+  {
+    query->server = (query->server + 1) % nameservers_.size();
+    sendQuery(query);
+  }
+}
+
+bool Resolver::isNameserver(const InetAddress& peer) const
+{
+  const string ipPort = peer.toIpPort();
+  for (const InetAddress& server : nameservers_)
+  {
+    if (server.toIpPort() == ipPort)
+    {
+      return true;
+    }
+  }
+  return false;
+}
+
+void Resolver::onMessage(const InetAddress& peer, StringPiece datagram)
+{
+  const char* data = datagram.data();
+  const size_t len = static_cast<size_t>(datagram.size());
+  if (len < kHeaderSize)
+  {
+    return;
+  }
+  const uint16_t id = readUint16(data);
+  const uint16_t flags = readUint16(data + 2);
+  const uint16_t questions = readUint16(data + 4);
+  const uint16_t answers = readUint16(data + 6);
+  auto it = queriesById_.find(id);
+  if (!(flags & kFlagResponse) || it == queriesById_.end() || !isNameserver(peer))
+  {
+    return;
+  }
+  Query* query = it->second;
+  const int t = query->ids[kA] == id ? kA : kAAAA;
+  const uint16_t type = t == kA ? kTypeA : kTypeAAAA;
+  if (query->answered[t])
+  {
+    return;
+  }
+
+  // the question must be ours
+  size_t offset = kHeaderSize;
+  string name;
+  if (questions != 1
+      || !readName(data, len, &offset, &name)
+      || offset + 4 > len
+      || readUint16(data + offset) != type
+      || toLower(name) != query->name)
+  {
+    return;
+  }
+  offset += 4;
+
+  const uint16_t rcode = flags & kRcodeMask;
+  if (rcode != kRcodeNoError && rcode != kRcodeNameError)
+  {
+    LOG_WARN << "Resolver - " << query->name << " got rcode " << rcode
+             << " from " << peer.toIpPort();
+    loop_->cancel(query->timer);
+    nextServer(query);
+    return;
+  }
+
+  // CNAMEs are followed by the name server, take all addresses
+  AddressList addresses;
+  uint32_t ttl = query->ttl;
+  for (uint16_t i = 0; i < answers; ++i)
+  {
+    if (!readName(data, len, &offset, &name) || offset + 10 > len)
+    {
+      return;
+    }
+    const uint16_t rrType = readUint16(data + offset);
+    const uint16_t rrClass = readUint16(data + offset + 2);
+    const uint32_t rrTtl = readUint32(data + offset + 4);
+    const size_t rdLength = readUint16(data + offset + 8);
+    offset += 10;
+    if (offset + rdLength > len)
+    {
+      return;
+    }
+    if (rrClass == kClassIN && rrType == kTypeA && type == kTypeA && rdLength == 4)
+    {
+      struct sockaddr_in addr;
+      memZero(&addr, sizeof addr);
+      addr.sin_family = AF_INET;
+      memcpy(&addr.sin_addr, data + offset, rdLength);
+      addresses.push_back(InetAddress(addr));
+      ttl = std::min(ttl, rrTtl);
+    }
+    else if (rrClass == kClassIN && rrType == kTypeAAAA && type == kTypeAAAA && rdLength == 16)
+    {
+      struct sockaddr_in6 addr;
+      memZero(&addr, sizeof addr);
+      addr.sin6_family = AF_INET6;
+      memcpy(&addr.sin6_addr, data + offset, rdLength);
+      addresses.push_back(InetAddress(addr));
+      ttl = std::min(ttl, rrTtl);
+    }
+    offset += rdLength;
+  }
+
+  query->answered[t] = true;
+  query->addresses[t].swap(addresses);
+  query->ttl = ttl;
+  if (query->answered[kA] && query->answered[kAAAA])
+  {
+    loop_->cancel(query->timer);
+    finish(query);
+  }
+}
+
+void Resolver::finish(Query* query)
+{
+  AddressList addresses(query->addresses[kA]);
+  addresses.insert(addresses.end(), query->addresses[kAAAA].begin(), query->addresses[kAAAA].end());
+  const string name = query->name;
+  addToCache(name, addresses,
+             addresses.empty() ? static_cast<uint32_t>(options_.negativeTtl) : query->ttl);
+
+  std::vector<Callback> callbacks;
+  callbacks.swap(query->callbacks);
+  for (int t = 0; t < kNumTypes; ++t)
+  {
+    queriesById_.erase(query->ids[t]);
+  }
+  queries_.erase(name);  // query is gone
+  // may resolve again
+  for (const Callback& cb : callbacks)
+  {
+    cb(addresses);
+  }
+}
+
+void Resolver::addToCache(const string& name, const AddressList& addresses, uint32_t ttl)
+{
+  if (ttl == 0 || options_.maxCacheEntries == 0)
+  {
+    return;
+  }
+  const Timestamp now(Timestamp::now());
+  if (cache_.size() >= options_.maxCacheEntries)
+  {
+    for (auto it = cache_.begin(); it != cache_.end(); )
+    {
+      if (it->second.expiration < now)
+      {
+        it = cache_.erase(it);
+      }
+      else
+      {
+        ++it;
+      }
+    }
+  }
+  if (cache_.size() >= options_.maxCacheEntries)
+  {
+    cache_.erase(cache_.begin());
+  }
+  CacheEntry& entry = cache_[name];
+  entry.addresses = addresses;
+  entry.expiration = addTime(now, static_cast<double>(ttl));
+}
+
+void Resolver::clearCache()
+{
+  loop_->assertInLoopThread();
+  cache_.clear();
+}
+
+const UdpSocketPtr& Resolver::socketOf(sa_family_t family)
+{
+  UdpSocketPtr& socket = family == AF_INET6 ? socket6_ : socket4_;
+  if (!socket)
+  {
+    // unbound, the kernel picks a random port on first send
+    socket = std::make_shared<UdpSocket>(loop_, "Resolver", family);
+    socket->setMessageCallback(
+        std::bind(&Resolver::onMessage, this, _2, _3));
+    socket->start();
+  }
+  return socket;
+}
+
+uint16_t Resolver::nextId()
+{
+  uint16_t id = 0;
+  do
+  {
+    // xorshift64
+    idState_ ^= idState_ << 13;
+    idState_ ^= idState_ >> 7;
+    idState_ ^= idState_ << 17;
+    id = static_cast<uint16_t>(idState_ >> 24);
+  } while (queriesById_.count(id) > 0);
+  return id;
+}
+
+void Resolver::readHostsFile(const string& path)
+{
+  std::ifstream in(path.c_str());
+  string line;
+  while (std::getline(in, line))
+  {
+    line = line.substr(0, line.find('#'));
+    std::istringstream fields(line);
+    string ip;
+    string name;
+    struct in6_addr addr;
+    if (!(fields >> ip)
+        || (::inet_pton(AF_INET, ip.c_str(), &addr) != 1
+            && ::inet_pton(AF_INET6, ip.c_str(), &addr) != 1))
+    {
+      continue;
+    }
+    while (fields >> name)
+    {
+      hosts_[normalize(name)].push_back(InetAddress(ip, 0));
+    }
+  }
+  for (auto& entry : hosts_)
+  {
+    std::stable_partition(entry.second.begin(), entry.second.end(),
+                          [](const InetAddress& addr) { return addr.family() == AF_INET; });
+  }
+}
+
+void Resolver::readResolvConf(const string& path)
+{
+  std::ifstream in(path.c_str());
+  string line;
+  while (std::getline(in, line))
+  {
+    line = line.substr(0, line.find_first_of("#;"));
+    std::istringstream fields(line);
+    string keyword;
+    string value;
+    fields >> keyword;
+    if (keyword == "nameserver" && fields >> value)
+    {
+      struct in6_addr addr;
+      // link local ones with %scope are skipped
+      if (::inet_pton(AF_INET, value.c_str(), &addr) == 1
+          || ::inet_pton(AF_INET6, value.c_str(), &addr) == 1)
+      {
+        nameservers_.push_back(InetAddress(value, kDnsPort));
+      }
+    }
+    else if (keyword == "options")
+    {
+      while (fields >> value)
+      {
+        if (value.compare(0, 8, "timeout:") == 0)
+        {
+          options_.timeout = std::max(atof(value.c_str() + 8), 0.1);
+        }
+        else if (value.compare(0, 9, "attempts:") == 0)
+        {
+          options_.attempts = std::max(atoi(value.c_str() + 9), 1);
+        }
+      }
+    }
+  }
+}
@@ -0,0 +1,159 @@
+// Use of this source code is governed by a BSD-style license
+// that can be found in the License file.
+//
+// This is a public header file, it must only include public header files.
+
+#ifndef MUDUO_NET_RESOLVER_H
+#define MUDUO_NET_RESOLVER_H
+
+#include "muduo/base/noncopyable.h"
+#include "muduo/base/Timestamp.h"
+#include "muduo/base/Types.h"
+#include "muduo/net/Callbacks.h"
+#include "muduo/net/InetAddress.h"
+#include "muduo/net/TimerId.h"
+
+#include <functional>
+#include <map>
+#include <memory>
+#include <unordered_map>
+#include <vector>
+
+namespace muduo
+{
+namespace net
+{
+
+class EventLoop;
+
+///
+/// Non-blocking DNS resolver in an EventLoop, for A and AAAA records.
+///
+/// Looks up /etc/hosts first, then asks name servers of /etc/resolv.conf
+/// over UDP, one after another on timeout. Answers are cached for their
+/// TTL, failures for Options::negativeTtl. Lookups of a name already
+/// being asked for wait for that query, instead of sending another.
+///
+/// Search domains of resolv.conf are not applied, names are absolute.
+/// Truncated answers are taken as they are, there is no TCP fallback.
+///
+class Resolver : noncopyable
+{
+ public:
+  /// IPv4 addresses first, port 0, empty if failed.
+  typedef std::vector<InetAddress> AddressList;
+  typedef std::function<void (const AddressList&)> Callback;
+
+  struct Options
+  {
+    /// Port 53 if 0. If empty, name servers of resolvConf, and its
+    /// "options timeout:n attempts:n" override the two below.
+    std::vector<InetAddress> nameservers;
+    string resolvConf;
+    /// Empty to skip.
+    string hostsFile;
+    /// Seconds to wait for a name server.
+    double timeout;
+    /// Rounds over name servers.
+    int attempts;
+    /// Asks for AAAA records too.
+    bool ipv6;
+    /// Seconds to cache failed lookups and names without addresses.
+    int negativeTtl;
+    /// Caps TTL of answers, in seconds.
+    int maxTtl;
+    /// Expired entries are dropped, then arbitrary ones.
+    size_t maxCacheEntries;
+
+    Options()
+      : resolvConf("/etc/resolv.conf"),
+        hostsFile("/etc/hosts"),
+        timeout(2.0),
+        attempts(2),
+        ipv6(true),
+        negativeTtl(5),
+        maxTtl(3600),
+        maxCacheEntries(10000)
+    { }
+  };
+
+  /// Reads hosts file and resolv.conf, in loop thread or not.
+  explicit Resolver(EventLoop* loop, const Options& options = Options());
+  /// In loop thread, pending callbacks are not called.
+  ~Resolver();
+
+  EventLoop* getLoop() const { return loop_; }
+  const std::vector<InetAddress>& nameservers() const { return nameservers_; }
+
+  ///
+  /// Resolves @c hostname, or an IP literal, and calls @c cb in loop thread.
+  /// Thread safe. In loop thread, @c cb may be called before it returns,
+  /// eg. with a cached answer.
+  ///
+  void resolve(const string& hostname, Callback cb);
+
+  /// Drops cached answers, in loop thread.
+  void clearCache();
+
+  // in loop thread
+  int64_t queriesSent() const { return queriesSent_; }
+  int64_t cacheHits() const { return cacheHits_; }
+  int64_t timeouts() const { return timeouts_; }
+
+ private:
+  enum QuestionType { kA, kAAAA, kNumTypes };
+
+  struct Query
+  {
+    string name;
+    std::vector<Callback> callbacks;
+    uint16_t ids[kNumTypes];
+    bool answered[kNumTypes];
+    AddressList addresses[kNumTypes];
+    uint32_t ttl;  // min of answers
+    size_t server;  // index of nameservers_
+    int tries;
+    TimerId timer;
+  };
+
+  struct CacheEntry
+  {
+    AddressList addresses;
+    Timestamp expiration;
+  };
+
+  void resolveInLoop(const string& hostname, Callback cb);
+  bool lookupLocal(const string& name, AddressList* addresses);
+  void sendQuery(Query* query);
+  void onTimeout(const string& name);
+  void nextServer(Query* query);
+  void onMessage(const InetAddress& peer, StringPiece datagram);
+  bool isNameserver(const InetAddress& peer) const;
+  void finish(Query* query);
+  void addToCache(const string& name, const AddressList& addresses, uint32_t ttl);
+  const UdpSocketPtr& socketOf(sa_family_t family);
+  uint16_t nextId();
+  void readHostsFile(const string& path);
+  void readResolvConf(const string& path);
+
+  EventLoop* loop_;
+  Options options_;
+  std::vector<InetAddress> nameservers_;
+  std::unordered_map<string, AddressList> hosts_;
+  UdpSocketPtr socket4_;
+  UdpSocketPtr socket6_;
+  // by name, for coalescing
+  std::map<string, std::unique_ptr<Query>> queries_;
+  std::unordered_map<uint16_t, Query*> queriesById_;
+  std::unordered_map<string, CacheEntry> cache_;
+  uint64_t idState_;
+
+  int64_t queriesSent_;
+  int64_t cacheHits_;
+  int64_t timeouts_;
+};
+
+}  // namespace net
+}  // namespace muduo
+
+#endif  // MUDUO_NET_RESOLVER_H
@@ -12,6 +12,7 @@
 #include "muduo/net/InetAddress.h"
 #include "muduo/net/SocketsOps.h"
 
+#include <linux/filter.h>
 #include <netinet/in.h>
 #include <netinet/tcp.h>
 #include <stdio.h>  // snprintf
@@ -31,6 +32,13 @@ bool Socket::getTcpInfo(struct tcp_info* tcpi) const
   return ::getsockopt(sockfd_, SOL_TCP, TCP_INFO, tcpi, &len) == 0;
 }
 
+bool Socket::getPeerCredentials(struct ucred* cred) const
+{
+  socklen_t len = sizeof(*cred);
+  memZero(cred, len);
+  return ::getsockopt(sockfd_, SOL_SOCKET, SO_PEERCRED, cred, &len) == 0;
+}
+
 bool Socket::getTcpInfoString(char* buf, int len) const
 {
   struct tcp_info tcpi;
@@ -69,12 +77,14 @@ void Socket::listen()
 
 int Socket::accept(InetAddress* peeraddr)
 {
-  struct sockaddr_in6 addr;
+  // large enough for any family
+  struct sockaddr_un addr;
   memZero(&addr, sizeof addr);
-  int connfd = sockets::accept(sockfd_, &addr);
+  int connfd = sockets::accept(sockfd_, sockets::sockaddr_cast(&addr),
+                               static_cast<socklen_t>(sizeof addr));
   if (connfd >= 0)
   {
-    peeraddr->setSockAddrInet6(addr);
+    *peeraddr = InetAddress(addr);
   }
   return connfd;
 }
@@ -118,6 +128,31 @@ void Socket::setReusePort(bool on)
 #endif
 }
 
+bool Socket::setReusePortCpuSteering(int numSockets)
+{
+#ifdef SO_ATTACH_REUSEPORT_CBPF
+  // A = cpu % numSockets, return A
+  struct sock_filter code[] = {
+    { static_cast<__u16>(BPF_LD | BPF_W | BPF_ABS), 0, 0, static_cast<__u32>(SKF_AD_OFF + SKF_AD_CPU) },
+    { static_cast<__u16>(BPF_ALU | BPF_MOD | BPF_K), 0, 0, static_cast<__u32>(numSockets) },
+    { static_cast<__u16>(BPF_RET | BPF_A), 0, 0, 0 },
+  };
+  struct sock_fprog prog;
+  prog.len = static_cast<unsigned short>(sizeof code / sizeof code[0]);
+  prog.filter = code;
+  int ret = ::setsockopt(sockfd_, SOL_SOCKET, SO_ATTACH_REUSEPORT_CBPF,
+                         &prog, static_cast<socklen_t>(sizeof prog));
+  if (ret < 0)
+  {
+    LOG_SYSERR << "SO_ATTACH_REUSEPORT_CBPF failed.";
+  }
+  return ret == 0;
+#else
+  LOG_ERROR << "SO_ATTACH_REUSEPORT_CBPF is not supported.";
+  return false;
+#endif
+}
+
 void Socket::setKeepAlive(bool on)
 {
   int optval = on ? 1 : 0;
@@ -126,3 +161,34 @@ void Socket::setKeepAlive(bool on)
   // FIXME CHECK
 }
 
+
+bool Socket::setBusyPoll(int microseconds)
+{
+  int ret = ::setsockopt(sockfd_, SOL_SOCKET, SO_BUSY_POLL,
+                         &microseconds, static_cast<socklen_t>(sizeof microseconds));
+  if (ret < 0)
+  {
+    LOG_SYSERR << "SO_BUSY_POLL failed.";
+  }
+  return ret == 0;
+}
+
+bool Socket::setZeroCopy(bool on)
+{
+#ifdef SO_ZEROCOPY
+  int optval = on ? 1 : 0;
+  int ret = ::setsockopt(sockfd_, SOL_SOCKET, SO_ZEROCOPY,
+                         &optval, static_cast<socklen_t>(sizeof optval));
+  if (ret < 0 && on)
+  {
+    LOG_SYSERR << "SO_ZEROCOPY failed.";
+  }
+  return ret == 0;
+#else
+  if (on)
+  {
+    LOG_ERROR << "SO_ZEROCOPY is not supported.";
+  }
+  return !on;
+#endif
+}
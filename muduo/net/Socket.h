@@ -15,6 +15,8 @@
 
 // struct tcp_info is in <netinet/tcp.h>
 struct tcp_info;
+// struct ucred is in <sys/socket.h>
+struct ucred;
 
 namespace muduo
 {
@@ -45,6 +47,8 @@ class Socket : noncopyable
   // return true if success.
   bool getTcpInfo(struct tcp_info*) const;
   bool getTcpInfoString(char* buf, int len) const;
+  /// SO_PEERCRED of AF_UNIX sockets, the peer process when it connected.
+  bool getPeerCredentials(struct ucred*) const;
 
   /// abort if address in use
   void bindAddress(const InetAddress& localaddr);
@@ -74,11 +78,30 @@ class Socket : noncopyable
   ///
   void setReusePort(bool on);
 
+  ///
+  /// Steers connections of the SO_REUSEPORT group to its
+  /// (CPU % @c numSockets)-th socket, in the order they listen.
+  /// Call it before listening, return true if success.
+  ///
+  bool setReusePortCpuSteering(int numSockets);
+
   ///
   /// Enable/disable SO_KEEPALIVE
   ///
   void setKeepAlive(bool on);
 
+  ///
+  /// Enable/disable SO_ZEROCOPY, return true if success.
+  ///
+  bool setZeroCopy(bool on);
+
+  ///
+  /// Set SO_BUSY_POLL, the kernel spins on the device queue for
+  /// up to @c microseconds when reading, 0 to disable.
+  /// Values above net.core.busy_read need CAP_NET_ADMIN.
+  ///
+  bool setBusyPoll(int microseconds);
+
  private:
   const int sockfd_;
 };
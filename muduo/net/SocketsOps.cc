@@ -12,11 +12,18 @@
 #include "muduo/base/Types.h"
 #include "muduo/net/Endian.h"
 
+#include <algorithm>
+
 #include <errno.h>
 #include <fcntl.h>
+#include <linux/errqueue.h>
+#include <netinet/in.h>
+#include <stddef.h>  // offsetof
 #include <stdio.h>  // snprintf
+#include <sys/sendfile.h>
 #include <sys/socket.h>
-#include <sys/uio.h>  // readv
+#include <sys/uio.h>  // readv, writev
+#include <sys/un.h>
 #include <unistd.h>
 
 using namespace muduo;
@@ -59,6 +66,16 @@ struct sockaddr* sockets::sockaddr_cast(struct sockaddr_in6* addr)
   return static_cast<struct sockaddr*>(implicit_cast<void*>(addr));
 }
 
+const struct sockaddr* sockets::sockaddr_cast(const struct sockaddr_un* addr)
+{
+  return static_cast<const struct sockaddr*>(implicit_cast<const void*>(addr));
+}
+
+struct sockaddr* sockets::sockaddr_cast(struct sockaddr_un* addr)
+{
+  return static_cast<struct sockaddr*>(implicit_cast<void*>(addr));
+}
+
 const struct sockaddr* sockets::sockaddr_cast(const struct sockaddr_in* addr)
 {
   return static_cast<const struct sockaddr*>(implicit_cast<const void*>(addr));
@@ -77,7 +94,7 @@ const struct sockaddr_in6* sockets::sockaddr_in6_cast(const struct sockaddr* add
 int sockets::createNonblockingOrDie(sa_family_t family)
 {
 #if VALGRIND
-  int sockfd = ::socket(family, SOCK_STREAM, IPPROTO_TCP);
+  int sockfd = ::socket(family, SOCK_STREAM, family == AF_UNIX ? 0 : IPPROTO_TCP);
   if (sockfd < 0)
   {
     LOG_SYSFATAL << "sockets::createNonblockingOrDie";
@@ -85,7 +102,8 @@ int sockets::createNonblockingOrDie(sa_family_t family)
 
   setNonBlockAndCloseOnExec(sockfd);
 #else
-  int sockfd = ::socket(family, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, IPPROTO_TCP);
+  int sockfd = ::socket(family, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC,
+                        family == AF_UNIX ? 0 : IPPROTO_TCP);
   if (sockfd < 0)
   {
     LOG_SYSFATAL << "sockets::createNonblockingOrDie";
@@ -94,9 +112,19 @@ int sockets::createNonblockingOrDie(sa_family_t family)
   return sockfd;
 }
 
+int sockets::createUdpNonblockingOrDie(sa_family_t family)
+{
+  int sockfd = ::socket(family, SOCK_DGRAM | SOCK_NONBLOCK | SOCK_CLOEXEC, IPPROTO_UDP);
+  if (sockfd < 0)
+  {
+    LOG_SYSFATAL << "sockets::createUdpNonblockingOrDie";
+  }
+  return sockfd;
+}
+
 void sockets::bindOrDie(int sockfd, const struct sockaddr* addr)
 {
-  int ret = ::bind(sockfd, addr, static_cast<socklen_t>(sizeof(struct sockaddr_in6)));
+  int ret = ::bind(sockfd, addr, sockaddrLength(addr));
   if (ret < 0)
   {
     LOG_SYSFATAL << "sockets::bindOrDie";
@@ -112,14 +140,13 @@ void sockets::listenOrDie(int sockfd)
   }
 }
 
-int sockets::accept(int sockfd, struct sockaddr_in6* addr)
+int sockets::accept(int sockfd, struct sockaddr* addr, socklen_t addrlen)
 {
-  socklen_t addrlen = static_cast<socklen_t>(sizeof *addr);
 #if VALGRIND || defined (NO_ACCEPT4)
-  int connfd = ::accept(sockfd, sockaddr_cast(addr), &addrlen);
+  int connfd = ::accept(sockfd, addr, &addrlen);
   setNonBlockAndCloseOnExec(connfd);
 #else
-  int connfd = ::accept4(sockfd, sockaddr_cast(addr),
+  int connfd = ::accept4(sockfd, addr,
                          &addrlen, SOCK_NONBLOCK | SOCK_CLOEXEC);
 #endif
   if (connfd < 0)
@@ -158,7 +185,7 @@ int sockets::accept(int sockfd, struct sockaddr_in6* addr)
 
 int sockets::connect(int sockfd, const struct sockaddr* addr)
 {
-  return ::connect(sockfd, addr, static_cast<socklen_t>(sizeof(struct sockaddr_in6)));
+  return ::connect(sockfd, addr, sockaddrLength(addr));
 }
 
 ssize_t sockets::read(int sockfd, void *buf, size_t count)
@@ -176,6 +203,74 @@ ssize_t sockets::write(int sockfd, const void *buf, size_t count)
   return ::write(sockfd, buf, count);
 }
 
+ssize_t sockets::writev(int sockfd, const struct iovec *iov, int iovcnt)
+{
+  return ::writev(sockfd, iov, iovcnt);
+}
+
+ssize_t sockets::sendfile(int sockfd, int fileFd, off_t *offset, size_t count)
+{
+  return ::sendfile(sockfd, fileFd, offset, count);
+}
+
+int sockets::recvmmsg(int sockfd, struct mmsghdr* msgvec, unsigned int vlen)
+{
+  return ::recvmmsg(sockfd, msgvec, vlen, MSG_DONTWAIT, NULL);
+}
+
+int sockets::sendmmsg(int sockfd, struct mmsghdr* msgvec, unsigned int vlen)
+{
+  return ::sendmmsg(sockfd, msgvec, vlen, MSG_DONTWAIT);
+}
+
+ssize_t sockets::sendZeroCopy(int sockfd, const void *buf, size_t count)
+{
+#ifdef MSG_ZEROCOPY
+  return ::send(sockfd, buf, count, MSG_ZEROCOPY);
+#else
+  errno = EOPNOTSUPP;
+  return -1;
+#endif
+}
+
+bool sockets::readZeroCopyCompletion(int sockfd, uint32_t* lo, uint32_t* hi, bool* copied)
+{
+#ifdef SO_EE_ORIGIN_ZEROCOPY
+  char control[128];
+  struct msghdr msg;
+  memZero(&msg, sizeof msg);
+  msg.msg_control = control;
+  msg.msg_controllen = sizeof control;
+  if (::recvmsg(sockfd, &msg, MSG_ERRQUEUE) < 0)
+  {
+    if (errno != EAGAIN)
+    {
+      LOG_SYSERR << "sockets::readZeroCopyCompletion";
+    }
+    return false;
+  }
+  for (struct cmsghdr* cm = CMSG_FIRSTHDR(&msg); cm != NULL; cm = CMSG_NXTHDR(&msg, cm))
+  {
+    if ((cm->cmsg_level == SOL_IP && cm->cmsg_type == IP_RECVERR)
+        || (cm->cmsg_level == SOL_IPV6 && cm->cmsg_type == IPV6_RECVERR))
+    {
+      const struct sock_extended_err* serr =
+          static_cast<const struct sock_extended_err*>(implicit_cast<const void*>(CMSG_DATA(cm)));
+      if (serr->ee_errno == 0 && serr->ee_origin == SO_EE_ORIGIN_ZEROCOPY)
+      {
+        *lo = serr->ee_info;
+        *hi = serr->ee_data;
+        *copied = (serr->ee_code & SO_EE_CODE_ZEROCOPY_COPIED) != 0;
+        return true;
+      }
+    }
+  }
+  return false;
+#else
+  return false;
+#endif
+}
+
 void sockets::close(int sockfd)
 {
   if (::close(sockfd) < 0)
@@ -268,27 +363,67 @@ int sockets::getSocketError(int sockfd)
   }
 }
 
-struct sockaddr_in6 sockets::getLocalAddr(int sockfd)
+socklen_t sockets::sockaddrLength(const struct sockaddr* addr)
 {
-  struct sockaddr_in6 localaddr;
-  memZero(&localaddr, sizeof localaddr);
-  socklen_t addrlen = static_cast<socklen_t>(sizeof localaddr);
-  if (::getsockname(sockfd, sockaddr_cast(&localaddr), &addrlen) < 0)
+  if (addr->sa_family == AF_INET)
+  {
+    return static_cast<socklen_t>(sizeof(struct sockaddr_in));
+  }
+  else if (addr->sa_family == AF_UNIX)
+  {
+    const struct sockaddr_un* addrUn =
+        static_cast<const struct sockaddr_un*>(implicit_cast<const void*>(addr));
+    const size_t pathSize = sizeof addrUn->sun_path;
+    size_t len = 0;
+    if (addrUn->sun_path[0] != '\0')
+    {
+      // a path, with its '\0' if it fits
+      len = std::min(::strnlen(addrUn->sun_path, pathSize) + 1, pathSize);
+    }
+    else if (addrUn->sun_path[1] != '\0')
+    {
+      // abstract, a leading '\0' and the name, no trailing '\0'
+      len = 1 + ::strnlen(addrUn->sun_path + 1, pathSize - 1);
+    }
+    else
+    {
+      // unnamed
+      return static_cast<socklen_t>(sizeof(sa_family_t));
+    }
+    return static_cast<socklen_t>(offsetof(struct sockaddr_un, sun_path) + len);
+  }
+  return static_cast<socklen_t>(sizeof(struct sockaddr_in6));
+}
+
+void sockets::getLocalAddr(int sockfd, struct sockaddr* addr, socklen_t addrlen)
+{
+  memZero(addr, addrlen);
+  if (::getsockname(sockfd, addr, &addrlen) < 0)
   {
     LOG_SYSERR << "sockets::getLocalAddr";
   }
-  return localaddr;
 }
 
-struct sockaddr_in6 sockets::getPeerAddr(int sockfd)
+void sockets::getPeerAddr(int sockfd, struct sockaddr* addr, socklen_t addrlen)
 {
-  struct sockaddr_in6 peeraddr;
-  memZero(&peeraddr, sizeof peeraddr);
-  socklen_t addrlen = static_cast<socklen_t>(sizeof peeraddr);
-  if (::getpeername(sockfd, sockaddr_cast(&peeraddr), &addrlen) < 0)
+  memZero(addr, addrlen);
+  if (::getpeername(sockfd, addr, &addrlen) < 0)
   {
     LOG_SYSERR << "sockets::getPeerAddr";
   }
+}
+
+struct sockaddr_in6 sockets::getLocalAddr(int sockfd)
+{
+  struct sockaddr_in6 localaddr;
+  getLocalAddr(sockfd, sockaddr_cast(&localaddr), static_cast<socklen_t>(sizeof localaddr));
+  return localaddr;
+}
+
+struct sockaddr_in6 sockets::getPeerAddr(int sockfd)
+{
+  struct sockaddr_in6 peeraddr;
+  getPeerAddr(sockfd, sockaddr_cast(&peeraddr), static_cast<socklen_t>(sizeof peeraddr));
   return peeraddr;
 }
 
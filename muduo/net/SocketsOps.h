@@ -13,6 +13,9 @@
 
 #include <arpa/inet.h>
 
+struct mmsghdr;
+struct sockaddr_un;
+
 namespace muduo
 {
 namespace net
@@ -21,17 +24,34 @@ namespace sockets
 {
 
 ///
-/// Creates a non-blocking socket file descriptor,
-/// abort if any error.
+/// Creates a non-blocking stream socket file descriptor, TCP or
+/// AF_UNIX, abort if any error.
 int createNonblockingOrDie(sa_family_t family);
+///
+/// Creates a non-blocking UDP socket file descriptor,
+/// abort if any error.
+int createUdpNonblockingOrDie(sa_family_t family);
 
 int  connect(int sockfd, const struct sockaddr* addr);
 void bindOrDie(int sockfd, const struct sockaddr* addr);
 void listenOrDie(int sockfd);
-int  accept(int sockfd, struct sockaddr_in6* addr);
+/// *addr is of any family, up to addrlen bytes.
+int  accept(int sockfd, struct sockaddr* addr, socklen_t addrlen);
 ssize_t read(int sockfd, void *buf, size_t count);
 ssize_t readv(int sockfd, const struct iovec *iov, int iovcnt);
 ssize_t write(int sockfd, const void *buf, size_t count);
+ssize_t writev(int sockfd, const struct iovec *iov, int iovcnt);
+ssize_t sendfile(int sockfd, int fileFd, off_t *offset, size_t count);
+/// Non-blocking recvmmsg(2), returns number of messages received.
+int recvmmsg(int sockfd, struct mmsghdr* msgvec, unsigned int vlen);
+/// Returns number of messages sent.
+int sendmmsg(int sockfd, struct mmsghdr* msgvec, unsigned int vlen);
+/// send(2) with MSG_ZEROCOPY, fails with EOPNOTSUPP if not supported.
+ssize_t sendZeroCopy(int sockfd, const void *buf, size_t count);
+/// Reads one MSG_ZEROCOPY completion notification from error queue,
+/// sets [*lo, *hi] of the completed sends and whether the kernel copied.
+/// returns false if there's none.
+bool readZeroCopyCompletion(int sockfd, uint32_t* lo, uint32_t* hi, bool* copied);
 void close(int sockfd);
 void shutdownWrite(int sockfd);
 
@@ -46,15 +66,22 @@ void fromIpPort(const char* ip, uint16_t port,
                 struct sockaddr_in6* addr);
 
 int getSocketError(int sockfd);
+/// Length of *addr of AF_INET, AF_INET6 or AF_UNIX, for bind(2) and connect(2).
+socklen_t sockaddrLength(const struct sockaddr* addr);
 
 const struct sockaddr* sockaddr_cast(const struct sockaddr_in* addr);
 const struct sockaddr* sockaddr_cast(const struct sockaddr_in6* addr);
 struct sockaddr* sockaddr_cast(struct sockaddr_in6* addr);
+const struct sockaddr* sockaddr_cast(const struct sockaddr_un* addr);
+struct sockaddr* sockaddr_cast(struct sockaddr_un* addr);
 const struct sockaddr_in* sockaddr_in_cast(const struct sockaddr* addr);
 const struct sockaddr_in6* sockaddr_in6_cast(const struct sockaddr* addr);
 
 struct sockaddr_in6 getLocalAddr(int sockfd);
 struct sockaddr_in6 getPeerAddr(int sockfd);
+/// Of any family, up to addrlen bytes.
+void getLocalAddr(int sockfd, struct sockaddr* addr, socklen_t addrlen);
+void getPeerAddr(int sockfd, struct sockaddr* addr, socklen_t addrlen);
 bool isSelfConnect(int sockfd);
 
 }  // namespace sockets
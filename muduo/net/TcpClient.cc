@@ -54,13 +54,30 @@ void removeConnector(const ConnectorPtr& connector)
 TcpClient::TcpClient(EventLoop* loop,
                      const InetAddress& serverAddr,
                      const string& nameArg)
-  : loop_(CHECK_NOTNULL(loop)),
-    connector_(new Connector(loop, serverAddr)),
+  : TcpClient(loop, std::make_shared<Connector>(CHECK_NOTNULL(loop), serverAddr), nameArg)
+{
+}
+
+TcpClient::TcpClient(EventLoop* loop,
+                     Resolver* resolver,
+                     const string& host,
+                     uint16_t port,
+                     const string& nameArg)
+  : TcpClient(loop, std::make_shared<Connector>(CHECK_NOTNULL(loop), resolver, host, port), nameArg)
+{
+}
+
+TcpClient::TcpClient(EventLoop* loop,
+                     const ConnectorPtr& connector,
+                     const string& nameArg)
+  : loop_(loop),
+    connector_(connector),
     name_(nameArg),
     connectionCallback_(defaultConnectionCallback),
     messageCallback_(defaultMessageCallback),
     retry_(false),
     connect_(true),
+    edgeTriggered_(false),
     nextConnId_(1)
 {
   connector_->setNewConnectionCallback(
@@ -105,7 +122,8 @@ void TcpClient::connect()
 {
   // FIXME: check state
   LOG_INFO << "TcpClient::connect[" << name_ << "] - connecting to "
-           << connector_->serverAddress().toIpPort();
+           << (connector_->hostname().empty() ? connector_->serverAddress().toIpPort()
+                                              : connector_->hostname());
   connect_ = true;
   connector_->start();
 }
@@ -132,13 +150,13 @@ void TcpClient::stop()
 void TcpClient::newConnection(int sockfd)
 {
   loop_->assertInLoopThread();
-  InetAddress peerAddr(sockets::getPeerAddr(sockfd));
-  char buf[32];
+  InetAddress peerAddr(InetAddress::peerAddressOf(sockfd));
+  char buf[160];  // or unix paths are truncated
   snprintf(buf, sizeof buf, ":%s#%d", peerAddr.toIpPort().c_str(), nextConnId_);
   ++nextConnId_;
   string connName = name_ + buf;
 
-  InetAddress localAddr(sockets::getLocalAddr(sockfd));
+  InetAddress localAddr(InetAddress::localAddressOf(sockfd));
   // FIXME poll with zero timeout to double confirm the new connection
   // FIXME use make_shared if necessary
   TcpConnectionPtr conn(new TcpConnection(loop_,
@@ -150,6 +168,7 @@ void TcpClient::newConnection(int sockfd)
   conn->setConnectionCallback(connectionCallback_);
   conn->setMessageCallback(messageCallback_);
   conn->setWriteCompleteCallback(writeCompleteCallback_);
+  conn->setEdgeTriggered(edgeTriggered_);
   conn->setCloseCallback(
       std::bind(&TcpClient::removeConnection, this, _1)); // FIXME: unsafe
   {
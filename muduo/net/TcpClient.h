@@ -20,18 +20,27 @@ namespace net
 {
 
 class Connector;
+class Resolver;
 typedef std::shared_ptr<Connector> ConnectorPtr;
 
 class TcpClient : noncopyable
 {
  public:
   // TcpClient(EventLoop* loop);
-  // TcpClient(EventLoop* loop, const string& host, uint16_t port);
   TcpClient(EventLoop* loop,
             const InetAddress& serverAddr,
             const string& nameArg);
+  /// Resolves @c host with @c resolver, which must outlive this, on each
+  /// connect and retry, so it follows DNS changes.
+  TcpClient(EventLoop* loop,
+            Resolver* resolver,
+            const string& host,
+            uint16_t port,
+            const string& nameArg);
   ~TcpClient();  // force out-line dtor, for std::unique_ptr members.
 
+  /// May be called again after the connection is closed, to connect anew.
+  /// Reconnects by itself only with enableRetry().
   void connect();
   void disconnect();
   void stop();
@@ -64,7 +73,16 @@ class TcpClient : noncopyable
   void setWriteCompleteCallback(WriteCompleteCallback cb)
   { writeCompleteCallback_ = std::move(cb); }
 
+  /// Edge triggered I/O for new connections.
+  /// See TcpConnection::setEdgeTriggered().
+  /// Not thread safe.
+  void setEdgeTriggered(bool on)
+  { edgeTriggered_ = on; }
+
  private:
+  TcpClient(EventLoop* loop,
+            const ConnectorPtr& connector,
+            const string& nameArg);
   /// Not thread safe, but in loop
   void newConnection(int sockfd);
   /// Not thread safe, but in loop
@@ -78,6 +96,7 @@ class TcpClient : noncopyable
   WriteCompleteCallback writeCompleteCallback_;
   bool retry_;   // atomic
   bool connect_; // atomic
+  bool edgeTriggered_;
   // always in loop thread
   int nextConnId_;
   mutable MutexLock mutex_;
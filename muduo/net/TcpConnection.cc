@@ -14,12 +14,84 @@
 #include "muduo/net/EventLoop.h"
 #include "muduo/net/Socket.h"
 #include "muduo/net/SocketsOps.h"
+#include "muduo/net/poller/IoUringPoller.h"
+
+#include <algorithm>
 
 #include <errno.h>
+#include <fcntl.h>
+#include <inttypes.h>
+#include <stdio.h>  // snprintf
+#include <sys/uio.h>
 
 using namespace muduo;
 using namespace muduo::net;
 
+const size_t TcpConnection::kZeroCopyThreshold;
+
+namespace
+{
+
+// In edge triggered mode, a channel gets at most this many reads or writes
+// per event, the rest waits for other channels, so a busy peer can't
+// starve the loop.
+const int kMaxIoPerEvent = 16;
+
+// Keeps MSG_ZEROCOPY buffers of a destroyed connection, and its socket to
+// read completions, till the kernel is done with them. Only a timer of the
+// loop holds it, it frees the buffers to the loop's pool.
+// The socket is a dup it closes, or one kept open by @c sockfdOwner.
+class ZeroCopyLinger : noncopyable,
+                       public std::enable_shared_from_this<ZeroCopyLinger>
+{
+ public:
+  ZeroCopyLinger(EventLoop* loop,
+                 int sockfd,
+                 const std::shared_ptr<void>& sockfdOwner,
+                 BufferChain* output)
+    : loop_(loop),
+      sockfd_(sockfd),
+      sockfdOwner_(sockfdOwner),
+      delay_(0.001)
+  {
+    pinned_.takePinned(output);
+  }
+
+  ~ZeroCopyLinger()
+  {
+    if (!sockfdOwner_)
+    {
+      sockets::close(sockfd_);
+    }
+  }
+
+  void poll()
+  {
+    uint32_t lo = 0;
+    uint32_t hi = 0;
+    bool copied = false;
+    while (sockets::readZeroCopyCompletion(sockfd_, &lo, &hi, &copied))
+    {
+      pinned_.releaseZeroCopy(lo, hi);
+    }
+    if (pinned_.zeroCopyInflight())
+    {
+      // till the peer acks or the socket dies, which frees them too
+      loop_->runAfter(delay_, std::bind(&ZeroCopyLinger::poll, shared_from_this()));
+      delay_ = std::min(delay_ * 2, 1.0);
+    }
+  }
+
+ private:
+  EventLoop* loop_;
+  const int sockfd_;
+  const std::shared_ptr<void> sockfdOwner_;
+  double delay_;
+  BufferChain pinned_;
+};
+
+}  // namespace
+
 void muduo::net::defaultConnectionCallback(const TcpConnectionPtr& conn)
 {
   LOG_TRACE << conn->localAddress().toIpPort() << " -> "
@@ -40,15 +112,50 @@ TcpConnection::TcpConnection(EventLoop* loop,
                              int sockfd,
                              const InetAddress& localAddr,
                              const InetAddress& peerAddr)
+  : TcpConnection(loop, nameArg, NamePrefix(), 0, sockfd, localAddr, peerAddr)
+{
+}
+
+TcpConnection::TcpConnection(EventLoop* loop,
+                             const NamePrefix& namePrefix,
+                             uint64_t id,
+                             int sockfd,
+                             const InetAddress& localAddr,
+                             const InetAddress& peerAddr)
+  : TcpConnection(loop, string(), namePrefix, id, sockfd, localAddr, peerAddr)
+{
+}
+
+TcpConnection::TcpConnection(EventLoop* loop,
+                             const string& nameArg,
+                             const NamePrefix& namePrefix,
+                             uint64_t id,
+                             int sockfd,
+                             const InetAddress& localAddr,
+                             const InetAddress& peerAddr)
   : loop_(CHECK_NOTNULL(loop)),
+    id_(id),
+    namePrefix_(namePrefix),
     name_(nameArg),
     state_(kConnecting),
     reading_(true),
     socket_(new Socket(sockfd)),
     channel_(new Channel(loop, sockfd)),
+    ioUring_(loop->ioUring()),
+    asyncWriting_(false),
     localAddr_(localAddr),
     peerAddr_(peerAddr),
-    highWaterMark_(64*1024*1024)
+    highWaterMark_(64*1024*1024),
+    zeroCopySocket_(false),
+    zeroCopyThreshold_(0),
+    idleBufferTimeout_(0),
+    releaseTimerPending_(false),
+    // may run in another thread, where the pool gives heap memory,
+    // so start empty and grow from the pool when reading.
+    inputBuffer_(0, Buffer::Allocator(loop->bufferPool())),
+    outputBuffer_(Buffer::Allocator(loop->bufferPool())),
+    reportedOutputBytes_(0),
+    creationTime_(EventLoop::cachedNow())
 {
   channel_->setReadCallback(
       std::bind(&TcpConnection::handleRead, this, _1));
@@ -58,17 +165,40 @@ TcpConnection::TcpConnection(EventLoop* loop,
       std::bind(&TcpConnection::handleClose, this));
   channel_->setErrorCallback(
       std::bind(&TcpConnection::handleError, this));
-  LOG_DEBUG << "TcpConnection::ctor[" <<  name_ << "] at " << this
+  LOG_DEBUG << "TcpConnection::ctor[" <<  name() << "] at " << this
             << " fd=" << sockfd;
   socket_->setKeepAlive(true);
+  // counted as soon as it is placed, before connectEstablished() runs
+  loop_->addConnections(1);
 }
 
 TcpConnection::~TcpConnection()
 {
-  LOG_DEBUG << "TcpConnection::dtor[" <<  name_ << "] at " << this
+  LOG_DEBUG << "TcpConnection::dtor[" <<  name() << "] at " << this
             << " fd=" << channel_->fd()
             << " state=" << stateToString();
   assert(state_ == kDisconnected);
+  // never sent, eg. the loop quit
+  for (const PendingOutput& output : pendingOutput_)
+  {
+    if (output.kind == PendingOutput::kFile)
+    {
+      sockets::close(output.fd);
+    }
+  }
+}
+
+const string& TcpConnection::name() const
+{
+  std::call_once(nameOnce_, [this] {
+    if (namePrefix_)
+    {
+      char buf[32];
+      snprintf(buf, sizeof buf, "#%" PRIu64, id_);
+      name_ = *namePrefix_ + buf;
+    }
+  });
+  return name_;
 }
 
 bool TcpConnection::getTcpInfo(struct tcp_info* tcpi) const
@@ -76,6 +206,11 @@ bool TcpConnection::getTcpInfo(struct tcp_info* tcpi) const
   return socket_->getTcpInfo(tcpi);
 }
 
+bool TcpConnection::getPeerCredentials(struct ucred* cred) const
+{
+  return socket_->getPeerCredentials(cred);
+}
+
 string TcpConnection::getTcpInfoString() const
 {
   char buf[1024];
@@ -99,38 +234,129 @@ void TcpConnection::send(const StringPiece& message)
     }
     else
     {
-      void (TcpConnection::*fp)(const StringPiece& message) = &TcpConnection::sendInLoop;
-      loop_->runInLoop(
-          std::bind(fp,
-                    this,     // FIXME
-                    message.as_string()));
-                    //std::forward<string>(message)));
+      queueOutput(PendingOutput(message.as_string()));
     }
   }
 }
 
-// FIXME efficiency!!!
 void TcpConnection::send(Buffer* buf)
 {
   if (state_ == kConnected)
   {
     if (loop_->isInLoopThread())
     {
-      sendInLoop(buf->peek(), buf->readableBytes());
-      buf->retrieveAll();
+      sendInLoop(buf);
+    }
+    else if (buf->readableBytes() < BufferChain::kSpliceThreshold)
+    {
+      queueOutput(PendingOutput(buf->retrieveAllAsString()));
+    }
+    else
+    {
+      Buffer taken(0);
+      taken.swap(*buf);
+      queueOutput(PendingOutput(), &taken);
+    }
+  }
+}
+
+void TcpConnection::send(string&& message)
+{
+  if (state_ == kConnected)
+  {
+    if (loop_->isInLoopThread())
+    {
+      sendInLoop(message.data(), message.size());
     }
     else
     {
-      void (TcpConnection::*fp)(const StringPiece& message) = &TcpConnection::sendInLoop;
-      loop_->runInLoop(
-          std::bind(fp,
-                    this,     // FIXME
-                    buf->retrieveAllAsString()));
-                    //std::forward<string>(message)));
+      queueOutput(PendingOutput(std::move(message)));
     }
   }
 }
 
+void TcpConnection::send(Buffer&& message)
+{
+  if (state_ == kConnected)
+  {
+    if (loop_->isInLoopThread())
+    {
+      sendInLoop(&message);
+    }
+    else
+    {
+      queueOutput(PendingOutput(), &message);
+    }
+  }
+}
+
+void TcpConnection::send(std::unique_ptr<char[]> data, size_t len)
+{
+  if (state_ == kConnected)
+  {
+    if (loop_->isInLoopThread())
+    {
+      sendInLoop(data.get(), len);
+    }
+    else
+    {
+      queueOutput(PendingOutput(std::move(data), len));
+    }
+  }
+}
+
+void TcpConnection::queueOutput(PendingOutput&& output, Buffer* buffer)
+{
+  bool first = false;
+  {
+  MutexLockGuard lock(pendingMutex_);
+  first = pendingOutput_.empty();
+  pendingOutput_.push_back(std::move(output));
+  if (buffer)
+  {
+    pendingBuffers_.push_back(std::move(*buffer));
+  }
+  }
+  // later ones ride on the same task
+  if (first)
+  {
+    loop_->queueInLoop(
+        std::bind(&TcpConnection::sendPendingInLoop, shared_from_this()));
+  }
+}
+
+void TcpConnection::sendPendingInLoop()
+{
+  loop_->assertInLoopThread();
+  {
+  MutexLockGuard lock(pendingMutex_);
+  pendingOutput_.swap(drainingOutput_);
+  pendingBuffers_.swap(drainingBuffers_);
+  }
+  size_t nextBuffer = 0;
+  for (PendingOutput& output : drainingOutput_)
+  {
+    switch (output.kind)
+    {
+      case PendingOutput::kString:
+        sendInLoop(output.message.data(), output.message.size());
+        break;
+      case PendingOutput::kBytes:
+        sendInLoop(output.bytes.get(), output.length);
+        break;
+      case PendingOutput::kBuffer:
+        sendInLoop(&drainingBuffers_[nextBuffer++]);
+        break;
+      case PendingOutput::kFile:
+        sendFileInLoop(output.fd, output.offset, output.length);
+        break;
+    }
+  }
+  assert(nextBuffer == drainingBuffers_.size());
+  drainingOutput_.clear();
+  drainingBuffers_.clear();
+}
+
 void TcpConnection::sendInLoop(const StringPiece& message)
 {
   sendInLoop(message.data(), message.size());
@@ -139,56 +365,226 @@ void TcpConnection::sendInLoop(const StringPiece& message)
 void TcpConnection::sendInLoop(const void* data, size_t len)
 {
   loop_->assertInLoopThread();
-  ssize_t nwrote = 0;
-  size_t remaining = len;
+  if (state_ == kDisconnected)
+  {
+    LOG_WARN << "disconnected, give up writing";
+    return;
+  }
+  ++traffic_.messagesSent;
   bool faultError = false;
+  size_t nwrote = writeDirectly(data, len, &faultError);
+  size_t remaining = len - nwrote;
+  if (!faultError && remaining > 0)
+  {
+    size_t oldLen = outputBuffer_.readableBytes();
+    outputBuffer_.append(static_cast<const char*>(data)+nwrote, remaining);
+    checkHighWaterMark(oldLen);
+    startWriting();
+    reportOutputBytes();
+  }
+}
+
+void TcpConnection::sendInLoop(Buffer* buf)
+{
+  loop_->assertInLoopThread();
   if (state_ == kDisconnected)
   {
     LOG_WARN << "disconnected, give up writing";
+    buf->retrieveAll();
     return;
   }
-  // if no thing in output queue, try writing directly
-  if (!channel_->isWriting() && outputBuffer_.readableBytes() == 0)
+  ++traffic_.messagesSent;
+  if (zeroCopyThreshold_ > 0 && buf->readableBytes() >= zeroCopyThreshold_)
+  {
+    sendZeroCopyInLoop(buf);
+    return;
+  }
+  bool faultError = false;
+  size_t nwrote = writeDirectly(buf->peek(), buf->readableBytes(), &faultError);
+  buf->retrieve(nwrote);
+  if (!faultError && buf->readableBytes() > 0)
+  {
+    size_t oldLen = outputBuffer_.readableBytes();
+    // splice, not copy
+    outputBuffer_.append(buf);
+    checkHighWaterMark(oldLen);
+    startWriting();
+    reportOutputBytes();
+  }
+  buf->retrieveAll();
+}
+
+void TcpConnection::sendFile(int fd, off_t offset, size_t length)
+{
+  if (state_ == kConnected && length > 0)
   {
-    nwrote = sockets::write(channel_->fd(), data, len);
-    if (nwrote >= 0)
+    int ownedFd = ::fcntl(fd, F_DUPFD_CLOEXEC, 0);
+    if (ownedFd < 0)
     {
-      remaining = len - nwrote;
-      if (remaining == 0 && writeCompleteCallback_)
-      {
-        loop_->queueInLoop(std::bind(writeCompleteCallback_, shared_from_this()));
-      }
+      LOG_SYSERR << "TcpConnection::sendFile";
+      return;
     }
-    else // nwrote < 0
+    if (loop_->isInLoopThread())
     {
-      nwrote = 0;
-      if (errno != EWOULDBLOCK)
-      {
-        LOG_SYSERR << "TcpConnection::sendInLoop";
-        if (errno == EPIPE || errno == ECONNRESET) // FIXME: any others?
-        {
-          faultError = true;
-        }
-      }
+      sendFileInLoop(ownedFd, offset, length);
+    }
+    else
+    {
+      // in order with other sends
+      queueOutput(PendingOutput(ownedFd, offset, length));
     }
   }
+}
 
-  assert(remaining <= len);
+void TcpConnection::sendFileInLoop(int fd, off_t offset, size_t length)
+{
+  loop_->assertInLoopThread();
+  if (state_ == kDisconnected)
+  {
+    LOG_WARN << "disconnected, give up sending file";
+    sockets::close(fd);
+    return;
+  }
+  ++traffic_.messagesSent;
+  bool faultError = false;
+  size_t nwrote = 0;
+  if (!channel_->isWriting() && outputBuffer_.empty())
+  {
+    off_t off = offset;
+    nwrote = onDirectWrite(sockets::sendfile(channel_->fd(), fd, &off, length),
+                           length, &faultError);
+  }
+  size_t remaining = length - nwrote;
   if (!faultError && remaining > 0)
   {
     size_t oldLen = outputBuffer_.readableBytes();
-    if (oldLen + remaining >= highWaterMark_
-        && oldLen < highWaterMark_
-        && highWaterMarkCallback_)
+    outputBuffer_.appendFile(fd, offset + static_cast<off_t>(nwrote), remaining);
+    checkHighWaterMark(oldLen);
+    startWriting();
+    reportOutputBytes();
+  }
+  else
+  {
+    sockets::close(fd);
+  }
+}
+
+size_t TcpConnection::writeDirectly(const void* data, size_t len, bool* faultError)
+{
+  // if no thing in output queue, try writing directly,
+  // with io_uring, it is queued and submitted by next poll.
+  if (!ioUring_ && !channel_->isWriting() && outputBuffer_.empty())
+  {
+    return onDirectWrite(sockets::write(channel_->fd(), data, len), len, faultError);
+  }
+  return 0;
+}
+
+size_t TcpConnection::onDirectWrite(ssize_t n, size_t len, bool* faultError)
+{
+  size_t nwrote = 0;
+  if (n >= 0)
+  {
+    countBytesSent(n);
+    nwrote = implicit_cast<size_t>(n);
+    if (nwrote == len && writeCompleteCallback_)
     {
-      loop_->queueInLoop(std::bind(highWaterMarkCallback_, shared_from_this(), oldLen + remaining));
+      loop_->queueInLoop(std::bind(writeCompleteCallback_, shared_from_this()));
     }
-    outputBuffer_.append(static_cast<const char*>(data)+nwrote, remaining);
-    if (!channel_->isWriting())
+  }
+  else // n < 0
+  {
+    if (errno != EWOULDBLOCK)
+    {
+      LOG_SYSERR << "TcpConnection::sendInLoop";
+      if (errno == EPIPE || errno == ECONNRESET) // FIXME: any others?
+      {
+        *faultError = true;
+      }
+    }
+  }
+  assert(nwrote <= len);
+  return nwrote;
+}
+
+void TcpConnection::checkHighWaterMark(size_t oldLen)
+{
+  size_t newLen = outputBuffer_.readableBytes();
+  if (newLen >= highWaterMark_
+      && oldLen < highWaterMark_
+      && highWaterMarkCallback_)
+  {
+    loop_->queueInLoop(std::bind(highWaterMarkCallback_, shared_from_this(), newLen));
+  }
+}
+
+void TcpConnection::reportOutputBytes()
+{
+  const size_t bytes = outputBuffer_.readableBytes();
+  if (bytes != reportedOutputBytes_)
+  {
+    loop_->addPendingOutputBytes(static_cast<int64_t>(bytes)
+                                 - static_cast<int64_t>(reportedOutputBytes_));
+    reportedOutputBytes_ = bytes;
+  }
+}
+
+void TcpConnection::countBytesSent(ssize_t n)
+{
+  if (n > 0)
+  {
+    traffic_.bytesSent += n;
+    lastSendTime_ = loop_->pollReturnTime();
+    loop_->addBytesSent(n);
+  }
+}
+
+void TcpConnection::startWriting()
+{
+  if (ioUring_)
+  {
+    if (!asyncWriting_ && !channel_->isWriting())
+    {
+      writeAsync();
+    }
+  }
+  else if (!channel_->isWriting())
+  {
+    channel_->enableWriting();
+  }
+}
+
+void TcpConnection::sendZeroCopyInLoop(Buffer* buf)
+{
+  // the kernel reads the pages after send() returns,
+  // so the bytes must live in outputBuffer_ before sending.
+  const bool idle = !channel_->isWriting() && outputBuffer_.empty();
+  const size_t len = buf->readableBytes();
+  size_t oldLen = outputBuffer_.readableBytes();
+  outputBuffer_.append(buf);
+  if (idle)
+  {
+    int savedErrno = 0;
+    ssize_t n = outputBuffer_.writeFd(channel_->fd(), &savedErrno, zeroCopyThreshold_);
+    if (n < 0)
+    {
+      errno = savedErrno;
+    }
+    bool faultError = false;
+    onDirectWrite(n, len, &faultError);
+    if (faultError)
     {
-      channel_->enableWriting();
+      outputBuffer_.retrieveAll();
+      reportOutputBytes();
+      return;
     }
   }
+  if (!outputBuffer_.empty())
+  {
+    checkHighWaterMark(oldLen);
+    startWriting();
+  }
+  reportOutputBytes();
 }
 
 void TcpConnection::shutdown()
@@ -205,7 +601,7 @@ void TcpConnection::shutdown()
 void TcpConnection::shutdownInLoop()
 {
   loop_->assertInLoopThread();
-  if (!channel_->isWriting())
+  if (!channel_->isWriting() && !asyncWriting_)
   {
     // we are not writing
     socket_->shutdownWrite();
@@ -290,6 +686,38 @@ void TcpConnection::setTcpNoDelay(bool on)
   socket_->setTcpNoDelay(on);
 }
 
+void TcpConnection::setKeepAlive(bool on)
+{
+  socket_->setKeepAlive(on);
+}
+
+void TcpConnection::setBusyPoll(int microseconds)
+{
+  socket_->setBusyPoll(microseconds);
+}
+
+void TcpConnection::setEdgeTriggered(bool on)
+{
+  channel_->setEdgeTriggered(on);
+}
+
+void TcpConnection::setZeroCopy(bool on, size_t threshold)
+{
+  loop_->assertInLoopThread();
+  if (ioUring_)
+  {
+    // FIXME: IORING_OP_SEND_ZC
+    LOG_WARN << "TcpConnection::setZeroCopy [" << name() << "] - not with io_uring";
+    return;
+  }
+  if (on && !zeroCopySocket_)
+  {
+    // keep SO_ZEROCOPY once set, completions may still be on the way
+    zeroCopySocket_ = socket_->setZeroCopy(true);
+  }
+  zeroCopyThreshold_ = (on && zeroCopySocket_) ? std::max<size_t>(threshold, 1) : 0;
+}
+
 void TcpConnection::startRead()
 {
   loop_->runInLoop(std::bind(&TcpConnection::startReadInLoop, this));
@@ -326,6 +754,10 @@ void TcpConnection::connectEstablished()
   assert(state_ == kConnecting);
   setState(kConnected);
   channel_->tie(shared_from_this());
+  if (ioUring_)
+  {
+    ioUring_->setReceiveBuffer(channel_.get(), &inputBuffer_);
+  }
   channel_->enableReading();
 
   connectionCallback_(shared_from_this());
@@ -342,41 +774,118 @@ void TcpConnection::connectDestroyed()
     connectionCallback_(shared_from_this());
   }
   channel_->remove();
+  if (outputBuffer_.zeroCopyInflight())
+  {
+    // the kernel may still send from them, even after close()
+    int sockfd = ::fcntl(channel_->fd(), F_DUPFD_CLOEXEC, 0);
+    if (sockfd >= 0)
+    {
+      std::make_shared<ZeroCopyLinger>(loop_, sockfd, nullptr, &outputBuffer_)->poll();
+    }
+    else
+    {
+      // out of fds, keeps this alive instead, with its socket
+      LOG_SYSERR << "TcpConnection::connectDestroyed [" << name() << "] - dup";
+      std::make_shared<ZeroCopyLinger>(
+          loop_, channel_->fd(), shared_from_this(), &outputBuffer_)->poll();
+    }
+  }
+  loop_->addPendingOutputBytes(-static_cast<int64_t>(reportedOutputBytes_));
+  reportedOutputBytes_ = 0;
+  loop_->addConnections(-1);
 }
 
 void TcpConnection::handleRead(Timestamp receiveTime)
 {
   loop_->assertInLoopThread();
-  int savedErrno = 0;
-  ssize_t n = inputBuffer_.readFd(channel_->fd(), &savedErrno);
-  if (n > 0)
+  // with io_uring, data is already in inputBuffer_,
+  // we take until EAGAIN, as an EOF may follow.
+  const bool edgeTriggered = channel_->isEdgeTriggered() || ioUring_ != NULL;
+  for (int i = 1; ; ++i)
   {
-    messageCallback_(shared_from_this(), &inputBuffer_, receiveTime);
+    int savedErrno = 0;
+    ssize_t n = ioUring_ ? ioUring_->takeReceived(channel_.get(), &savedErrno)
+                         : inputBuffer_.readFd(channel_->fd(), &savedErrno);
+    if (n > 0)
+    {
+      traffic_.bytesReceived += n;
+      ++traffic_.messagesReceived;
+      lastReceiveTime_ = receiveTime;
+      loop_->addBytesReceived(n);
+      messageCallback_(shared_from_this(), &inputBuffer_, receiveTime);
+      onBuffersActive();
+    }
+    else if (n == 0)
+    {
+      handleClose();
+      return;
+    }
+    else if (edgeTriggered && savedErrno == EAGAIN)
+    {
+      // drained, wait for the next edge
+      return;
+    }
+    else
+    {
+      errno = savedErrno;
+      LOG_SYSERR << "TcpConnection::handleRead";
+      handleError();
+      if (edgeTriggered)
+      {
+        // no more events would tell us to close
+        handleClose();
+      }
+      return;
+    }
+
+    // disabled by callback, or closed
+    if (!edgeTriggered || !channel_->isReading())
+    {
+      return;
+    }
+    if (i == kMaxIoPerEvent)
+    {
+      // let other channels run
+      loop_->queueInLoop(std::bind(&TcpConnection::readMore, shared_from_this()));
+      return;
+    }
   }
-  else if (n == 0)
+}
+
+void TcpConnection::readMore()
+{
+  if (channel_->isReading())
   {
-    handleClose();
-  }
-  else
-  {
-    errno = savedErrno;
-    LOG_SYSERR << "TcpConnection::handleRead";
-    handleError();
+    handleRead(loop_->pollReturnTime());
   }
 }
 
 void TcpConnection::handleWrite()
 {
   loop_->assertInLoopThread();
-  if (channel_->isWriting())
+  if (ioUring_)
   {
-    ssize_t n = sockets::write(channel_->fd(),
-                               outputBuffer_.peek(),
-                               outputBuffer_.readableBytes());
-    if (n > 0)
+    handleAsyncWrite();
+    return;
+  }
+  if (!channel_->isWriting())
+  {
+    LOG_TRACE << "Connection fd = " << channel_->fd()
+              << " is down, no more writing";
+    return;
+  }
+
+  const bool edgeTriggered = channel_->isEdgeTriggered();
+  for (int i = 1; ; ++i)
+  {
+    int savedErrno = 0;
+    ssize_t n = outputBuffer_.writeFd(channel_->fd(), &savedErrno, zeroCopyThreshold_);
+    // n == 0 when a truncated file region is discarded
+    if (n >= 0)
     {
-      outputBuffer_.retrieve(n);
-      if (outputBuffer_.readableBytes() == 0)
+      countBytesSent(n);
+      reportOutputBytes();
+      if (outputBuffer_.empty())
       {
         channel_->disableWriting();
         if (writeCompleteCallback_)
@@ -388,21 +897,95 @@ void TcpConnection::handleWrite()
           shutdownInLoop();
         }
       }
+      onBuffersActive();
     }
     else
     {
-      LOG_SYSERR << "TcpConnection::handleWrite";
-      // if (state_ == kDisconnecting)
-      // {
-      //   shutdownInLoop();
-      // }
+      if (!edgeTriggered || savedErrno != EAGAIN)
+      {
+        errno = savedErrno;
+        LOG_SYSERR << "TcpConnection::handleWrite";
+        // if (state_ == kDisconnecting)
+        // {
+        //   shutdownInLoop();
+        // }
+      }
+      return;
+    }
+
+    if (!edgeTriggered || !channel_->isWriting())
+    {
+      return;
+    }
+    if (i == kMaxIoPerEvent)
+    {
+      // let other channels run
+      loop_->queueInLoop(std::bind(&TcpConnection::handleWrite, shared_from_this()));
+      return;
     }
   }
+}
+
+void TcpConnection::writeAsync()
+{
+  struct iovec vec[BufferChain::kMaxIovecs];
+  int iovcnt = outputBuffer_.startAsyncWrite(vec, BufferChain::kMaxIovecs);
+  if (iovcnt > 0)
+  {
+    asyncWriting_ = true;
+    // we must live until the kernel is done with outputBuffer_
+    ioUring_->startWrite(channel_.get(), vec, iovcnt, shared_from_this());
+  }
+  else if (!outputBuffer_.empty())
+  {
+    // a file region
+    channel_->enableWriting();
+  }
+}
+
+void TcpConnection::handleAsyncWrite()
+{
+  int savedErrno = 0;
+  ssize_t n = 0;
+  if (ioUring_->takeWritten(channel_.get(), &n, &savedErrno))
+  {
+    asyncWriting_ = false;
+    outputBuffer_.finishAsyncWrite(n);
+  }
+  else if (channel_->isWriting())
+  {
+    channel_->disableWriting();
+    n = outputBuffer_.writeFd(channel_->fd(), &savedErrno);
+  }
   else
   {
-    LOG_TRACE << "Connection fd = " << channel_->fd()
-              << " is down, no more writing";
+    return;
+  }
+  countBytesSent(n);
+  reportOutputBytes();
+
+  if (n < 0 && savedErrno != EAGAIN)
+  {
+    errno = savedErrno;
+    LOG_SYSERR << "TcpConnection::handleWrite";
+    return;
+  }
+  if (outputBuffer_.empty())
+  {
+    if (writeCompleteCallback_)
+    {
+      loop_->queueInLoop(std::bind(writeCompleteCallback_, shared_from_this()));
+    }
+    if (state_ == kDisconnecting)
+    {
+      shutdownInLoop();
+    }
   }
+  else if (state_ != kDisconnected)
+  {
+    writeAsync();
+  }
+  onBuffersActive();
 }
 
 void TcpConnection::handleClose()
@@ -422,8 +1005,90 @@ void TcpConnection::handleClose()
 
 void TcpConnection::handleError()
 {
+  // MSG_ZEROCOPY completions are reported as POLLERR
+  if (zeroCopySocket_ && readZeroCopyCompletions())
+  {
+    return;
+  }
   int err = sockets::getSocketError(channel_->fd());
-  LOG_ERROR << "TcpConnection::handleError [" << name_
+  LOG_ERROR << "TcpConnection::handleError [" << name()
             << "] - SO_ERROR = " << err << " " << strerror_tl(err);
 }
 
+
+bool TcpConnection::readZeroCopyCompletions()
+{
+  bool any = false;
+  uint32_t lo = 0;
+  uint32_t hi = 0;
+  bool copied = false;
+  while (sockets::readZeroCopyCompletion(channel_->fd(), &lo, &hi, &copied))
+  {
+    any = true;
+    LOG_TRACE << "TcpConnection::readZeroCopyCompletions [" << name()
+              << "] - " << lo << "-" << hi << (copied ? " copied" : "");
+    outputBuffer_.releaseZeroCopy(lo, hi);
+    if (copied && zeroCopyThreshold_ > 0)
+    {
+      // eg. loopback, or a device without scatter-gather, pinning is
+      // all cost then
+      LOG_DEBUG << "TcpConnection::readZeroCopyCompletions [" << name()
+                << "] - copied by the kernel, zero copy is off";
+      zeroCopyThreshold_ = 0;
+    }
+  }
+  return any;
+}
+
+void TcpConnection::onBuffersActive()
+{
+  if (idleBufferTimeout_ <= 0)
+  {
+    return;
+  }
+  lastBufferActive_ = loop_->pollReturnTime();
+  if (!releaseTimerPending_
+      && (inputBuffer_.internalCapacity() > Buffer::kCheapPrepend
+          || outputBuffer_.numSegments() > 0))
+  {
+    // one timer per burst, not per read
+    releaseTimerPending_ = true;
+    loop_->runAfter(idleBufferTimeout_,
+                    makeWeakCallback(shared_from_this(), &TcpConnection::releaseIdleBuffers));
+  }
+}
+
+void TcpConnection::releaseIdleBuffers()
+{
+  loop_->assertInLoopThread();
+  releaseTimerPending_ = false;
+  double idle = timeDifference(loop_->pollReturnTime(), lastBufferActive_);
+  if (idle < idleBufferTimeout_)
+  {
+    releaseTimerPending_ = true;
+    loop_->runAfter(idleBufferTimeout_ - idle,
+                    makeWeakCallback(shared_from_this(), &TcpConnection::releaseIdleBuffers));
+    return;
+  }
+
+  LOG_TRACE << "TcpConnection::releaseIdleBuffers [" << name() << "] - "
+            << inputBuffer_.internalCapacity() << " + "
+            << outputBuffer_.internalCapacity() << " bytes";
+  // a partial message or stalled output is kept, but compacted
+  if (inputBuffer_.readableBytes() == 0)
+  {
+    inputBuffer_.release();
+  }
+  else
+  {
+    inputBuffer_.shrink(0);
+  }
+  if (outputBuffer_.empty())
+  {
+    outputBuffer_.release();
+  }
+  else
+  {
+    outputBuffer_.shrink(0);
+  }
+}
@@ -11,19 +11,25 @@
 #ifndef MUDUO_NET_TCPCONNECTION_H
 #define MUDUO_NET_TCPCONNECTION_H
 
+#include "muduo/base/Mutex.h"
 #include "muduo/base/noncopyable.h"
 #include "muduo/base/StringPiece.h"
 #include "muduo/base/Types.h"
 #include "muduo/net/Callbacks.h"
 #include "muduo/net/Buffer.h"
+#include "muduo/net/BufferChain.h"
 #include "muduo/net/InetAddress.h"
 
 #include <memory>
+#include <mutex>
+#include <vector>
 
 #include <boost/any.hpp>
 
 // struct tcp_info is in <netinet/tcp.h>
 struct tcp_info;
+// struct ucred is in <sys/socket.h>
+struct ucred;
 
 namespace muduo
 {
@@ -32,6 +38,7 @@ namespace net
 
 class Channel;
 class EventLoop;
+class IoUringPoller;
 class Socket;
 
 ///
@@ -42,6 +49,27 @@ class TcpConnection : noncopyable,
                       public std::enable_shared_from_this<TcpConnection>
 {
  public:
+  static const size_t kZeroCopyThreshold = 32*1024;
+  typedef std::shared_ptr<const string> NamePrefix;
+
+  /// Counters of a connection, kept in its loop thread.
+  struct Traffic
+  {
+    int64_t bytesReceived = 0;
+    int64_t bytesSent = 0;
+    int64_t messagesReceived = 0;  // MessageCallback calls
+    int64_t messagesSent = 0;  // send() and sendFile() calls
+
+    Traffic& operator+=(const Traffic& rhs)
+    {
+      bytesReceived += rhs.bytesReceived;
+      bytesSent += rhs.bytesSent;
+      messagesReceived += rhs.messagesReceived;
+      messagesSent += rhs.messagesSent;
+      return *this;
+    }
+  };
+
   /// Constructs a TcpConnection with a connected sockfd
   ///
   /// User should not create this object.
@@ -50,28 +78,83 @@ class TcpConnection : noncopyable,
                 int sockfd,
                 const InetAddress& localAddr,
                 const InetAddress& peerAddr);
+  /// Named *namePrefix + "#" + id, only when name() is first called.
+  TcpConnection(EventLoop* loop,
+                const NamePrefix& namePrefix,
+                uint64_t id,
+                int sockfd,
+                const InetAddress& localAddr,
+                const InetAddress& peerAddr);
   ~TcpConnection();
 
   EventLoop* getLoop() const { return loop_; }
-  const string& name() const { return name_; }
+  /// Unique in its TcpServer, 0 if not from a TcpServer.
+  uint64_t id() const { return id_; }
+  /// Thread safe.
+  const string& name() const;
   const InetAddress& localAddress() const { return localAddr_; }
   const InetAddress& peerAddress() const { return peerAddr_; }
+  // NOT thread safe, in loop thread, see TcpServer::forEachConnection()
+  const Traffic& traffic() const { return traffic_; }
+  Timestamp creationTime() const { return creationTime_; }
+  Timestamp lastReceiveTime() const { return lastReceiveTime_; }
+  /// When bytes were last written, by poll time of the loop.
+  Timestamp lastSendTime() const { return lastSendTime_; }
+  /// Bytes queued in the output buffer.
+  size_t outputBacklog() const { return outputBuffer_.readableBytes(); }
+
   bool connected() const { return state_ == kConnected; }
   bool disconnected() const { return state_ == kDisconnected; }
   // return true if success.
   bool getTcpInfo(struct tcp_info*) const;
   string getTcpInfoString() const;
+  /// pid, uid and gid of the peer process of an AF_UNIX connection,
+  /// return true if success.
+  bool getPeerCredentials(struct ucred*) const;
 
-  // void send(string&& message); // C++11
+  // Sends from other threads are queued to the loop in order,
+  // one task for all queued before it runs.
   void send(const void* message, int len);
   void send(const StringPiece& message);
-  // void send(Buffer&& message); // C++11
-  void send(Buffer* message);  // this one will swap data
+  void send(const char* message)  // or it's ambiguous
+  { send(StringPiece(message)); }
+  void send(Buffer* message);  // this one will swap data, big ones are spliced in loop thread
+  /// Takes @c message without copying, thread safe.
+  /// @c message is left unspecified, like any moved-from object.
+  void send(string&& message);
+  /// Takes @c message without copying, big ones are spliced, thread safe.
+  /// @c message is left unspecified, assign to it before reusing.
+  void send(Buffer&& message);
+  /// Takes @c len bytes at @c data without copying, thread safe.
+  void send(std::unique_ptr<char[]> data, size_t len);
+  // sends file region with sendfile(2), in order with other sends.
+  // fd is dup()ed, caller may close it after return.
+  void sendFile(int fd, off_t offset, size_t length);
   void shutdown(); // NOT thread safe, no simultaneous calling
   // void shutdownAndForceCloseAfter(double seconds); // NOT thread safe, no simultaneous calling
   void forceClose();
   void forceCloseWithDelay(double seconds);
   void setTcpNoDelay(bool on);
+  /// SO_KEEPALIVE, to find out dead peers of idle connections.
+  void setKeepAlive(bool on);
+  /// SO_BUSY_POLL, see EventLoop::setBusyPoll() for spinning in the loop.
+  void setBusyPoll(int microseconds);
+  /// Sends output of at least @c threshold bytes with MSG_ZEROCOPY.
+  /// Only helps with send(Buffer*) and queued output, which we own until
+  /// the kernel reports completion. Needs Linux 4.14+, and is turned off
+  /// once the kernel reports it copied anyway, eg. on loopback.
+  /// Not supported with completion based I/O of EventLoop::ioUring().
+  /// NOT thread safe, call it in loop thread, eg. in ConnectionCallback.
+  void setZeroCopy(bool on, size_t threshold = kZeroCopyThreshold);
+  bool zeroCopy() const { return zeroCopyThreshold_ > 0; }
+  /// Reads and writes until EAGAIN on each event, which saves
+  /// epoll_wait(2) calls with EPollPoller.
+  /// NOT thread safe, call it before connectEstablished().
+  void setEdgeTriggered(bool on);
+  /// Frees drained buffers after no I/O for @c seconds, 0 to never free.
+  /// NOT thread safe, call it before connectEstablished() or in loop thread.
+  void setIdleBufferTimeout(double seconds)
+  { idleBufferTimeout_ = seconds; }
   // reading or not
   void startRead();
   void stopRead();
@@ -102,7 +185,7 @@ class TcpConnection : noncopyable,
   Buffer* inputBuffer()
   { return &inputBuffer_; }
 
-  Buffer* outputBuffer()
+  BufferChain* outputBuffer()
   { return &outputBuffer_; }
 
   /// Internal use only.
@@ -116,13 +199,72 @@ class TcpConnection : noncopyable,
 
  private:
   enum StateE { kDisconnected, kConnecting, kConnected, kDisconnecting };
+  TcpConnection(EventLoop* loop,
+                const string& name,
+                const NamePrefix& namePrefix,
+                uint64_t id,
+                int sockfd,
+                const InetAddress& localAddr,
+                const InetAddress& peerAddr);
   void handleRead(Timestamp receiveTime);
   void handleWrite();
+  // resumes reading stopped by kMaxIoPerEvent in edge triggered mode
+  void readMore();
   void handleClose();
   void handleError();
-  // void sendInLoop(string&& message);
   void sendInLoop(const StringPiece& message);
   void sendInLoop(const void* message, size_t len);
+  void sendInLoop(Buffer* message);
+  void sendFileInLoop(int fd, off_t offset, size_t length);
+  // output from other threads, sent in order by sendPendingInLoop()
+  struct PendingOutput
+  {
+    enum Kind { kString, kBytes, kBuffer, kFile };
+
+    explicit PendingOutput(string&& msg)
+      : kind(kString), message(std::move(msg)), length(0), fd(-1), offset(0)
+    {}
+    PendingOutput(std::unique_ptr<char[]>&& data, size_t len)
+      : kind(kBytes), bytes(std::move(data)), length(len), fd(-1), offset(0)
+    {}
+    // the Buffer is next in pendingBuffers_, which doesn't allocate
+    // like a default constructed Buffer member would
+    PendingOutput()
+      : kind(kBuffer), length(0), fd(-1), offset(0)
+    {}
+    PendingOutput(int fileFd, off_t off, size_t len)
+      : kind(kFile), length(len), fd(fileFd), offset(off)
+    {}
+
+    Kind kind;
+    string message;
+    std::unique_ptr<char[]> bytes;
+    size_t length;  // of bytes or the file region
+    int fd;
+    off_t offset;
+  };
+  // queues output from other threads, schedules sendPendingInLoop() if
+  // none is pending, with @c buffer for kBuffer
+  void queueOutput(PendingOutput&& output, Buffer* buffer = NULL);
+  void sendPendingInLoop();
+  // if nothing queued, writes without buffering, returns bytes written.
+  size_t writeDirectly(const void* message, size_t len, bool* faultError);
+  size_t onDirectWrite(ssize_t n, size_t len, bool* faultError);
+  // called after queueing output
+  void checkHighWaterMark(size_t oldLen);
+  void startWriting();
+  // tells loop_ how much outputBuffer_ has changed, for placement
+  void reportOutputBytes();
+  void countBytesSent(ssize_t n);
+  // with io_uring, submits leading memory of outputBuffer_,
+  // or waits for POLLOUT to sendfile(2)
+  void writeAsync();
+  void handleAsyncWrite();
+  void sendZeroCopyInLoop(Buffer* message);
+  bool readZeroCopyCompletions();
+  // schedules releaseIdleBuffers() if holding buffer memory
+  void onBuffersActive();
+  void releaseIdleBuffers();
   void shutdownInLoop();
   // void shutdownAndForceCloseInLoop(double seconds);
   void forceCloseInLoop();
@@ -132,12 +274,17 @@ class TcpConnection : noncopyable,
   void stopReadInLoop();
 
   EventLoop* loop_;
-  const string name_;
+  const uint64_t id_;
+  const NamePrefix namePrefix_;  // NULL if named by the ctor
+  mutable string name_;
+  mutable std::once_flag nameOnce_;
   StateE state_;  // FIXME: use atomic variable
   bool reading_;
   // we don't expose those classes to client.
   std::unique_ptr<Socket> socket_;
   std::unique_ptr<Channel> channel_;
+  IoUringPoller* const ioUring_;  // NULL for readiness based I/O
+  bool asyncWriting_;  // a write is submitted to ioUring_
   const InetAddress localAddr_;
   const InetAddress peerAddr_;
   ConnectionCallback connectionCallback_;
@@ -146,11 +293,25 @@ class TcpConnection : noncopyable,
   HighWaterMarkCallback highWaterMarkCallback_;
   CloseCallback closeCallback_;
   size_t highWaterMark_;
+  bool zeroCopySocket_;  // SO_ZEROCOPY is set
+  size_t zeroCopyThreshold_;  // 0 if zero copy is off
+  double idleBufferTimeout_;
+  bool releaseTimerPending_;
+  Timestamp lastBufferActive_;
   Buffer inputBuffer_;
-  Buffer outputBuffer_; // FIXME: use list<Buffer> as output buffer.
+  BufferChain outputBuffer_;
+  size_t reportedOutputBytes_;  // to loop_
+  Traffic traffic_;
+  const Timestamp creationTime_;
+  Timestamp lastReceiveTime_;
+  Timestamp lastSendTime_;
+  MutexLock pendingMutex_;
+  std::vector<PendingOutput> pendingOutput_ GUARDED_BY(pendingMutex_);
+  std::vector<Buffer> pendingBuffers_ GUARDED_BY(pendingMutex_);
+  // swapped with the above, to reuse their capacity
+  std::vector<PendingOutput> drainingOutput_;
+  std::vector<Buffer> drainingBuffers_;
   boost::any context_;
-  // FIXME: creationTime_, lastReceiveTime_
-  //        bytesReceived_, bytesSent_
 };
 
 typedef std::shared_ptr<TcpConnection> TcpConnectionPtr;
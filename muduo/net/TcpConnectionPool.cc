@@ -0,0 +1,589 @@
+// Use of this source code is governed by a BSD-style license
+// that can be found in the License file.
+
+#include "muduo/net/TcpConnectionPool.h"
+
+#include "muduo/base/Logging.h"
+#include "muduo/base/Mutex.h"
+#include "muduo/net/EventLoop.h"
+#include "muduo/net/EventLoopThreadPool.h"
+#include "muduo/net/TcpClient.h"
+
+#include <algorithm>
+#include <deque>
+
+#include <stdio.h>  // snprintf
+
+using namespace muduo;
+using namespace muduo::net;
+
+///
+/// Connections to one address. Callbacks in loops hold it, so it lives
+/// till all connections are closed, after the pool is gone.
+///
+class TcpConnectionPool::Endpoint : noncopyable,
+                                    public std::enable_shared_from_this<Endpoint>
+{
+ public:
+  Endpoint(const TcpConnectionPool& pool, const InetAddress& address, int connections)
+    : baseLoop_(pool.baseLoop_),
+      address_(address),
+      connections_(connections),
+      options_(pool.options_),
+      nextWaiterId_(1),
+      acquires_(0),
+      waits_(0),
+      failures_(0),
+      reconnects_(0),
+      healthCheckFailures_(0)
+  {
+  }
+
+  // in baseLoop thread
+  void start(const TcpConnectionPool& pool);
+  void stop();
+
+  TcpConnectionPtr tryAcquire();
+  void acquire(LeaseCallback cb);
+  void release(const TcpConnectionPtr& conn, bool reuse);
+  void addStats(Stats* stats) const;
+
+ private:
+  struct Slot
+  {
+    EventLoop* loop;
+    std::unique_ptr<TcpClient> client;
+    // in loop thread
+    Timestamp connectedAt;
+    double reconnectDelay;
+    bool reconnecting;
+    TimerId reconnectTimer;
+    TimerId healthCheckTimer;
+    bool stopped;
+    // guarded by mutex_
+    TcpConnectionPtr conn;
+    bool leased;
+  };
+
+  struct Waiter
+  {
+    uint64_t id;
+    LeaseCallback cb;
+  };
+
+  // in loop of slot
+  void startSlot(Slot* slot);
+  void stopSlot(Slot* slot);
+  void onConnection(Slot* slot, const TcpConnectionPtr& conn);
+  void scheduleReconnect(Slot* slot);
+  void reconnect(Slot* slot);
+  void checkHealth(Slot* slot);
+
+  // Makes a leased connection idle, or gives it to a waiter.
+  void giveBack(const TcpConnectionPtr& conn);
+  void expireWaiter(uint64_t id);
+  TcpConnectionPtr leaseIdle() REQUIRES(mutex_);
+  Slot* leasedSlotOf(const TcpConnectionPtr& conn) const REQUIRES(mutex_);
+  void removeIdle(Slot* slot) REQUIRES(mutex_);
+  bool healthChecking() const
+  { return healthCheck_ && options_.healthCheckInterval > 0; }
+
+  EventLoop* baseLoop_;
+  const InetAddress address_;
+  const int connections_;
+  const Options options_;
+  // set in start()
+  ConnectionCallback connectionCallback_;
+  HealthCheck healthCheck_;
+  std::vector<std::unique_ptr<Slot>> slots_;
+
+  mutable MutexLock mutex_;
+  std::vector<Slot*> idle_ GUARDED_BY(mutex_);
+  std::deque<Waiter> waiters_ GUARDED_BY(mutex_);
+  uint64_t nextWaiterId_ GUARDED_BY(mutex_);
+  int64_t acquires_ GUARDED_BY(mutex_);
+  int64_t waits_ GUARDED_BY(mutex_);
+  int64_t failures_ GUARDED_BY(mutex_);
+  int64_t reconnects_ GUARDED_BY(mutex_);
+  int64_t healthCheckFailures_ GUARDED_BY(mutex_);
+};
+
+void TcpConnectionPool::Endpoint::start(const TcpConnectionPool& pool)
+{
+  connectionCallback_ = pool.connectionCallback_;
+  healthCheck_ = pool.healthCheck_;
+  for (int i = 0; i < connections_; ++i)
+  {
+    std::unique_ptr<Slot> slot(new Slot);
+    slot->loop = pool.threadPool_ ? pool.threadPool_->getNextLoop() : baseLoop_;
+    char buf[32];
+    snprintf(buf, sizeof buf, "#%d", i);
+    slot->client.reset(new TcpClient(slot->loop, address_, pool.name_ + buf));
+    slot->client->setConnectionCallback(
+        std::bind(&Endpoint::onConnection, shared_from_this(), slot.get(), _1));
+    slot->client->setMessageCallback(pool.messageCallback_);
+    slot->client->setWriteCompleteCallback(pool.writeCompleteCallback_);
+    slot->reconnectDelay = options_.minReconnectDelay;
+    slot->reconnecting = false;
+    slot->stopped = false;
+    slot->leased = false;
+    slots_.push_back(std::move(slot));
+  }
+  for (const auto& slot : slots_)
+  {
+    slot->loop->runInLoop(std::bind(&Endpoint::startSlot, shared_from_this(), slot.get()));
+  }
+}
+
+void TcpConnectionPool::Endpoint::stop()
+{
+  for (const auto& slot : slots_)
+  {
+    slot->loop->runInLoop(std::bind(&Endpoint::stopSlot, shared_from_this(), slot.get()));
+  }
+  std::deque<Waiter> waiters;
+  {
+  MutexLockGuard lock(mutex_);
+  waiters.swap(waiters_);
+  failures_ += static_cast<int64_t>(waiters.size());
+  }
+  for (const Waiter& waiter : waiters)
+  {
+    waiter.cb(TcpConnectionPtr());
+  }
+}
+
+void TcpConnectionPool::Endpoint::startSlot(Slot* slot)
+{
+  slot->loop->assertInLoopThread();
+  if (slot->stopped)
+  {
+    return;
+  }
+  slot->client->connect();
+  if (healthChecking())
+  {
+    slot->healthCheckTimer = slot->loop->runEvery(
+        options_.healthCheckInterval,
+        std::bind(&Endpoint::checkHealth, shared_from_this(), slot));
+  }
+}
+
+void TcpConnectionPool::Endpoint::stopSlot(Slot* slot)
+{
+  slot->loop->assertInLoopThread();
+  slot->stopped = true;
+  if (slot->reconnecting)
+  {
+    slot->loop->cancel(slot->reconnectTimer);
+  }
+  if (healthChecking())
+  {
+    slot->loop->cancel(slot->healthCheckTimer);
+  }
+  TcpConnectionPtr conn;
+  {
+  MutexLockGuard lock(mutex_);
+  conn.swap(slot->conn);
+  removeIdle(slot);
+  slot->leased = false;
+  }
+  if (conn)
+  {
+    // no more calls into us
+    conn->setConnectionCallback(connectionCallback_);
+  }
+  slot->client.reset();
+  if (conn)
+  {
+    conn->forceClose();
+  }
+}
+
+void TcpConnectionPool::Endpoint::onConnection(Slot* slot, const TcpConnectionPtr& conn)
+{
+  slot->loop->assertInLoopThread();
+  if (conn->connected())
+  {
+    slot->connectedAt = Timestamp::now();
+    if (address_.family() != AF_UNIX)
+    {
+      conn->setTcpNoDelay(options_.tcpNoDelay);
+      conn->setKeepAlive(options_.keepAlive);
+    }
+    {
+    MutexLockGuard lock(mutex_);
+    slot->conn = conn;
+    slot->leased = true;  // till the callback is done
+    }
+    connectionCallback_(conn);
+    giveBack(conn);
+  }
+  else
+  {
+    {
+    MutexLockGuard lock(mutex_);
+    removeIdle(slot);
+    slot->conn.reset();
+    slot->leased = false;
+    }
+    connectionCallback_(conn);
+    scheduleReconnect(slot);
+  }
+}
+
+void TcpConnectionPool::Endpoint::scheduleReconnect(Slot* slot)
+{
+  if (slot->stopped)
+  {
+    return;
+  }
+  // backs off only if connections keep closing soon
+  if (timeDifference(Timestamp::now(), slot->connectedAt) > slot->reconnectDelay)
+  {
+    slot->reconnectDelay = options_.minReconnectDelay;
+  }
+  LOG_INFO << "TcpConnectionPool - reconnecting to " << address_.toIpPort()
+           << " in " << slot->reconnectDelay << " seconds";
+  slot->reconnecting = true;
+  slot->reconnectTimer = slot->loop->runAfter(
+      slot->reconnectDelay,
+      std::bind(&Endpoint::reconnect, shared_from_this(), slot));
+  slot->reconnectDelay = std::min(slot->reconnectDelay * 2, options_.maxReconnectDelay);
+}
+
+void TcpConnectionPool::Endpoint::reconnect(Slot* slot)
+{
+  slot->loop->assertInLoopThread();
+  slot->reconnecting = false;
+  if (slot->stopped)
+  {
+    return;
+  }
+  {
+  MutexLockGuard lock(mutex_);
+  ++reconnects_;
+  }
+  slot->client->connect();
+}
+
+void TcpConnectionPool::Endpoint::checkHealth(Slot* slot)
+{
+  slot->loop->assertInLoopThread();
+  TcpConnectionPtr conn;
+  {
+  MutexLockGuard lock(mutex_);
+  if (slot->conn && !slot->leased)
+  {
+    removeIdle(slot);
+    slot->leased = true;
+    conn = slot->conn;
+  }
+  }
+  if (!conn)
+  {
+    return;
+  }
+  if (healthCheck_(conn))
+  {
+    giveBack(conn);
+  }
+  else
+  {
+    {
+    MutexLockGuard lock(mutex_);
+    ++healthCheckFailures_;
+    }
+    LOG_WARN << "TcpConnectionPool - " << conn->name() << " failed health check";
+    conn->forceClose();
+  }
+}
+
+TcpConnectionPtr TcpConnectionPool::Endpoint::tryAcquire()
+{
+  MutexLockGuard lock(mutex_);
+  TcpConnectionPtr conn = leaseIdle();
+  if (!conn)
+  {
+    ++failures_;
+  }
+  return conn;
+}
+
+void TcpConnectionPool::Endpoint::acquire(LeaseCallback cb)
+{
+  TcpConnectionPtr conn;
+  bool waiting = false;
+  uint64_t id = 0;
+  {
+  MutexLockGuard lock(mutex_);
+  conn = leaseIdle();
+  if (!conn)
+  {
+    ++waits_;
+    if (waiters_.size() < options_.maxWaiters)
+    {
+      waiting = true;
+      id = nextWaiterId_++;
+      Waiter waiter = { id, std::move(cb) };
+      waiters_.push_back(std::move(waiter));
+    }
+    else
+    {
+      ++failures_;
+    }
+  }
+  }
+
+  if (!waiting)
+  {
+    cb(conn);
+  }
+  else if (options_.acquireTimeout > 0)
+  {
+    // not canceled when served, it finds nothing then
+    baseLoop_->runAfter(options_.acquireTimeout,
+                        std::bind(&Endpoint::expireWaiter, shared_from_this(), id));
+  }
+}
+
+void TcpConnectionPool::Endpoint::release(const TcpConnectionPtr& conn, bool reuse)
+{
+  if (reuse)
+  {
+    giveBack(conn);
+    return;
+  }
+  bool leased = false;
+  {
+  MutexLockGuard lock(mutex_);
+  leased = leasedSlotOf(conn) != NULL;
+  }
+  if (leased)
+  {
+    conn->forceClose();
+  }
+}
+
+void TcpConnectionPool::Endpoint::giveBack(const TcpConnectionPtr& conn)
+{
+  LeaseCallback cb;
+  {
+  MutexLockGuard lock(mutex_);
+  Slot* slot = leasedSlotOf(conn);
+  if (slot == NULL || !conn->connected())
+  {
+    // closed meanwhile, or closing and replaced soon
+    return;
+  }
+  if (waiters_.empty())
+  {
+    slot->leased = false;
+    idle_.push_back(slot);
+    return;
+  }
+  cb = std::move(waiters_.front().cb);
+  waiters_.pop_front();
+  ++acquires_;
+  }
+  cb(conn);
+}
+
+void TcpConnectionPool::Endpoint::expireWaiter(uint64_t id)
+{
+  LeaseCallback cb;
+  {
+  MutexLockGuard lock(mutex_);
+  for (auto it = waiters_.begin(); it != waiters_.end(); ++it)
+  {
+    if (it->id == id)
+    {
+      cb = std::move(it->cb);
+      waiters_.erase(it);
+      ++failures_;
+      break;
+    }
+  }
+  }
+  if (cb)
+  {
+    cb(TcpConnectionPtr());
+  }
+}
+
+TcpConnectionPtr TcpConnectionPool::Endpoint::leaseIdle()
+{
+  if (idle_.empty())
+  {
+    return TcpConnectionPtr();
+  }
+  // the most recently used, in our loop if any, to save a thread hop
+  size_t i = idle_.size() - 1;
+  EventLoop* current = EventLoop::getEventLoopOfCurrentThread();
+  for (size_t j = idle_.size(); current && j > 0; --j)
+  {
+    if (idle_[j-1]->loop == current)
+    {
+      i = j-1;
+      break;
+    }
+  }
+  Slot* slot = idle_[i];
+  idle_.erase(idle_.begin() + static_cast<ptrdiff_t>(i));
+  slot->leased = true;
+  ++acquires_;
+  return slot->conn;
+}
+
+TcpConnectionPool::Endpoint::Slot*
+TcpConnectionPool::Endpoint::leasedSlotOf(const TcpConnectionPtr& conn) const
+{
+  for (const auto& slot : slots_)
+  {
+    if (slot->conn == conn && slot->leased)
+    {
+      return slot.get();
+    }
+  }
+  return NULL;
+}
+
+void TcpConnectionPool::Endpoint::removeIdle(Slot* slot)
+{
+  idle_.erase(std::remove(idle_.begin(), idle_.end(), slot), idle_.end());
+}
+
+void TcpConnectionPool::Endpoint::addStats(Stats* stats) const
+{
+  MutexLockGuard lock(mutex_);
+  int connected = 0;
+  for (const auto& slot : slots_)
+  {
+    if (slot->conn)
+    {
+      ++connected;
+    }
+  }
+  const int idle = static_cast<int>(idle_.size());
+  stats->connections += connections_;
+  stats->connected += connected;
+  stats->idle += idle;
+  stats->leased += connected - idle;
+  stats->waiters += static_cast<int>(waiters_.size());
+  stats->acquires += acquires_;
+  stats->waits += waits_;
+  stats->failures += failures_;
+  stats->reconnects += reconnects_;
+  stats->healthCheckFailures += healthCheckFailures_;
+}
+
+TcpConnectionPool::TcpConnectionPool(EventLoop* baseLoop,
+                                     const string& nameArg,
+                                     const Options& options)
+  : baseLoop_(CHECK_NOTNULL(baseLoop)),
+    name_(nameArg),
+    options_(options),
+    connectionCallback_(defaultConnectionCallback),
+    messageCallback_(defaultMessageCallback),
+    started_(false)
+{
+}
+
+TcpConnectionPool::~TcpConnectionPool()
+{
+  baseLoop_->assertInLoopThread();
+  LOG_TRACE << "TcpConnectionPool::~TcpConnectionPool [" << name_ << "] destructing";
+  if (started_)
+  {
+    for (const auto& item : endpoints_)
+    {
+      item.second->stop();
+    }
+  }
+}
+
+void TcpConnectionPool::addEndpoint(const InetAddress& endpoint, int connections)
+{
+  assert(!started_);
+  assert(connections > 0);
+  EndpointPtr& ptr = endpoints_[endpoint.toIpPort()];
+  if (ptr)
+  {
+    LOG_WARN << "TcpConnectionPool::addEndpoint [" << name_ << "] - "
+             << endpoint.toIpPort() << " added again";
+  }
+  ptr.reset(new Endpoint(*this, endpoint, connections));
+}
+
+void TcpConnectionPool::start()
+{
+  baseLoop_->assertInLoopThread();
+  assert(!started_);
+  assert(!threadPool_ || threadPool_->started());
+  started_ = true;
+  for (const auto& item : endpoints_)
+  {
+    item.second->start(*this);
+  }
+}
+
+TcpConnectionPool::Endpoint* TcpConnectionPool::findEndpoint(const InetAddress& endpoint) const
+{
+  std::map<string, EndpointPtr>::const_iterator it = endpoints_.find(endpoint.toIpPort());
+  if (it == endpoints_.end())
+  {
+    LOG_ERROR << "TcpConnectionPool [" << name_ << "] - unknown endpoint "
+              << endpoint.toIpPort();
+    return NULL;
+  }
+  return get_pointer(it->second);
+}
+
+TcpConnectionPtr TcpConnectionPool::tryAcquire(const InetAddress& endpoint)
+{
+  Endpoint* ep = findEndpoint(endpoint);
+  return ep ? ep->tryAcquire() : TcpConnectionPtr();
+}
+
+void TcpConnectionPool::acquire(const InetAddress& endpoint, LeaseCallback cb)
+{
+  Endpoint* ep = findEndpoint(endpoint);
+  if (ep)
+  {
+    ep->acquire(std::move(cb));
+  }
+  else
+  {
+    cb(TcpConnectionPtr());
+  }
+}
+
+void TcpConnectionPool::release(const TcpConnectionPtr& conn, bool reuse)
+{
+  Endpoint* ep = findEndpoint(conn->peerAddress());
+  if (ep)
+  {
+    ep->release(conn, reuse);
+  }
+}
+
+TcpConnectionPool::Stats TcpConnectionPool::stats(const InetAddress& endpoint) const
+{
+  Stats result = Stats();
+  Endpoint* ep = findEndpoint(endpoint);
+  if (ep)
+  {
+    ep->addStats(&result);
+  }
+  return result;
+}
+
+TcpConnectionPool::Stats TcpConnectionPool::stats() const
+{
+  Stats result = Stats();
+  for (const auto& item : endpoints_)
+  {
+    item.second->addStats(&result);
+  }
+  return result;
+}
@@ -0,0 +1,171 @@
+// Use of this source code is governed by a BSD-style license
+// that can be found in the License file.
+//
+// This is a public header file, it must only include public header files.
+
+#ifndef MUDUO_NET_TCPCONNECTIONPOOL_H
+#define MUDUO_NET_TCPCONNECTIONPOOL_H
+
+#include "muduo/base/noncopyable.h"
+#include "muduo/base/Types.h"
+#include "muduo/net/Callbacks.h"
+#include "muduo/net/InetAddress.h"
+
+#include <functional>
+#include <map>
+#include <memory>
+#include <vector>
+
+namespace muduo
+{
+namespace net
+{
+
+class EventLoop;
+class EventLoopThreadPool;
+
+///
+/// Client connections to a few endpoints, several to each, spread over
+/// loops of an EventLoopThreadPool.
+///
+/// A caller leases an idle connection with acquire(), has it to itself
+/// until release(), and so never queues behind others on one connection.
+/// Closed connections are replaced, after a delay which doubles from
+/// Options::minReconnectDelay while they keep closing soon after
+/// connected. Idle connections may be checked with a HealthCheck.
+///
+class TcpConnectionPool : noncopyable
+{
+ public:
+  /// NULL if no connection is available in time.
+  typedef std::function<void (const TcpConnectionPtr&)> LeaseCallback;
+  /// Called with an idle connection in its loop, false to close it.
+  typedef std::function<bool (const TcpConnectionPtr&)> HealthCheck;
+
+  struct Options
+  {
+    /// For addEndpoint() without a number.
+    int connectionsPerEndpoint;
+    /// Seconds to wait to replace a closed connection.
+    double minReconnectDelay;
+    double maxReconnectDelay;
+    /// Seconds between checks of each idle connection, 0 to disable.
+    double healthCheckInterval;
+    /// Seconds acquire() waits for a connection, 0 for ever.
+    double acquireTimeout;
+    /// Per endpoint, acquire() fails when so many are waiting.
+    size_t maxWaiters;
+    bool tcpNoDelay;
+    bool keepAlive;
+
+    Options()
+      : connectionsPerEndpoint(4),
+        minReconnectDelay(0.1),
+        maxReconnectDelay(30.0),
+        healthCheckInterval(0.0),
+        acquireTimeout(1.0),
+        maxWaiters(1024),
+        tcpNoDelay(true),
+        keepAlive(true)
+    { }
+  };
+
+  /// Of one endpoint, or summed over all.
+  struct Stats
+  {
+    int connections;  // configured
+    int connected;
+    int idle;
+    int leased;  // connected but not idle
+    int waiters;  // in acquire()
+    int64_t acquires;  // leases given out
+    int64_t waits;  // acquire() found no idle connection
+    int64_t failures;  // acquire() got NULL, tryAcquire() failed
+    int64_t reconnects;
+    int64_t healthCheckFailures;
+  };
+
+  TcpConnectionPool(EventLoop* baseLoop,
+                    const string& nameArg,
+                    const Options& options = Options());
+  /// In baseLoop thread, fails waiters, and closes connections in their
+  /// loops, so destroy it while they still run, and let them run till the
+  /// connections are down, eg. till the server sees them closed.
+  ~TcpConnectionPool();
+
+  const string& name() const { return name_; }
+  const Options& options() const { return options_; }
+
+  /// Places connections with getNextLoop() of @c threadPool, which is
+  /// started, instead of baseLoop. Before start().
+  void setThreadPool(const std::shared_ptr<EventLoopThreadPool>& threadPool)
+  { threadPool_ = threadPool; }
+
+  /// Before start().
+  void addEndpoint(const InetAddress& endpoint)
+  { addEndpoint(endpoint, options_.connectionsPerEndpoint); }
+  void addEndpoint(const InetAddress& endpoint, int connections);
+
+  /// Called for every connection up and down, in its loop.
+  /// A new connection is leased after this returns, so it may set context.
+  /// Not thread safe, before start().
+  void setConnectionCallback(ConnectionCallback cb)
+  { connectionCallback_ = std::move(cb); }
+
+  /// Not thread safe, before start().
+  void setMessageCallback(MessageCallback cb)
+  { messageCallback_ = std::move(cb); }
+
+  /// Not thread safe, before start().
+  void setWriteCompleteCallback(WriteCompleteCallback cb)
+  { writeCompleteCallback_ = std::move(cb); }
+
+  /// Not thread safe, before start(). See Options::healthCheckInterval.
+  void setHealthCheck(HealthCheck check)
+  { healthCheck_ = std::move(check); }
+
+  /// Connects to all endpoints, in baseLoop thread.
+  void start();
+
+  /// Leases an idle connection to @c endpoint, preferably one in the
+  /// loop of the caller, or returns NULL. Thread safe.
+  TcpConnectionPtr tryAcquire(const InetAddress& endpoint);
+
+  /// Calls @c cb with an idle connection, or the next one released
+  /// within Options::acquireTimeout. Thread safe.
+  /// @c cb is called in the thread giving the connection, the caller or
+  /// the one releasing, or in baseLoop on timeout.
+  void acquire(const InetAddress& endpoint, LeaseCallback cb);
+
+  /// Gives back a leased connection, @c reuse false to close it, eg. after
+  /// a protocol error. Closed ones need not be released. Thread safe.
+  void release(const TcpConnectionPtr& conn, bool reuse = true);
+
+  /// Thread safe.
+  Stats stats(const InetAddress& endpoint) const;
+  Stats stats() const;
+
+ private:
+  class Endpoint;
+  typedef std::shared_ptr<Endpoint> EndpointPtr;
+
+  Endpoint* findEndpoint(const InetAddress& endpoint) const;
+
+  EventLoop* baseLoop_;
+  const string name_;
+  const Options options_;
+  std::shared_ptr<EventLoopThreadPool> threadPool_;
+  ConnectionCallback connectionCallback_;
+  MessageCallback messageCallback_;
+  WriteCompleteCallback writeCompleteCallback_;
+  HealthCheck healthCheck_;
+  bool started_;
+  // by InetAddress::toIpPort(), fixed after start(). Each is shared with
+  // callbacks in loops, which outlive us till the connections are closed.
+  std::map<string, EndpointPtr> endpoints_;
+};
+
+}  // namespace net
+}  // namespace muduo
+
+#endif  // MUDUO_NET_TCPCONNECTIONPOOL_H
@@ -8,17 +8,35 @@
 
 #include "muduo/net/TcpServer.h"
 
+#include "muduo/base/CountDownLatch.h"
 #include "muduo/base/Logging.h"
 #include "muduo/net/Acceptor.h"
 #include "muduo/net/EventLoop.h"
 #include "muduo/net/EventLoopThreadPool.h"
 #include "muduo/net/SocketsOps.h"
 
-#include <stdio.h>  // snprintf
-
 using namespace muduo;
 using namespace muduo::net;
 
+namespace
+{
+
+// sockets of a path can't share it, each would bind it anew
+TcpServer::Option optionFor(const InetAddress& listenAddr,
+                            const string& name,
+                            TcpServer::Option option)
+{
+  if (listenAddr.family() == AF_UNIX && option != TcpServer::kNoReusePort)
+  {
+    LOG_WARN << "TcpServer::TcpServer [" << name
+             << "] - SO_REUSEPORT is ignored for " << listenAddr.toIpPort();
+    return TcpServer::kNoReusePort;
+  }
+  return option;
+}
+
+}  // namespace
+
 TcpServer::TcpServer(EventLoop* loop,
                      const InetAddress& listenAddr,
                      const string& nameArg,
@@ -26,11 +44,15 @@ TcpServer::TcpServer(EventLoop* loop,
   : loop_(CHECK_NOTNULL(loop)),
     ipPort_(listenAddr.toIpPort()),
     name_(nameArg),
-    acceptor_(new Acceptor(loop, listenAddr, option == kReusePort)),
+    option_(optionFor(listenAddr, nameArg, option)),
+    acceptor_(new Acceptor(loop, listenAddr, option_ != kNoReusePort)),
     threadPool_(new EventLoopThreadPool(loop, name_)),
     connectionCallback_(defaultConnectionCallback),
     messageCallback_(defaultMessageCallback),
-    nextConnId_(1)
+    edgeTriggered_(false),
+    cpuSteering_(false),
+    idleBufferTimeout_(0),
+    connNamePrefix_(std::make_shared<const string>(name_ + "-" + ipPort_))
 {
   acceptor_->setNewConnectionCallback(
       std::bind(&TcpServer::newConnection, this, _1, _2));
@@ -41,12 +63,29 @@ TcpServer::~TcpServer()
   loop_->assertInLoopThread();
   LOG_TRACE << "TcpServer::~TcpServer [" << name_ << "] destructing";
 
-  for (auto& item : connections_)
+  if (!loopAcceptors_.empty())
   {
-    TcpConnectionPtr conn(item.second);
-    item.second.reset();
-    conn->getLoop()->runInLoop(
-      std::bind(&TcpConnection::connectDestroyed, conn));
+    // stops accepting in I/O threads, without waiting for them
+    std::vector<EventLoop*> loops = threadPool_->getAllLoops();
+    for (size_t i = 0; i < loopAcceptors_.size(); ++i)
+    {
+      Acceptor* acceptor = loopAcceptors_[i].release();
+      loops[i]->runInLoop([acceptor] { delete acceptor; });
+    }
+  }
+
+  // each shard is destroyed in its loop, after this is gone
+  // FIXME: unsafe, a close callback may come in before
+  for (auto& item : shards_)
+  {
+    Shard* shard = item.second.release();
+    item.first->runInLoop([shard] {
+      for (auto& conn : shard->connections)
+      {
+        conn.second->connectDestroyed();
+      }
+      delete shard;
+    });
   }
 }
 
@@ -56,15 +95,68 @@ void TcpServer::setThreadNum(int numThreads)
   threadPool_->setThreadNum(numThreads);
 }
 
+void TcpServer::setThreadPlacement(EventLoopThreadPool::Placement placement)
+{
+  threadPool_->setPlacement(placement);
+}
+
+void TcpServer::setThreadPlacementCallback(const EventLoopThreadPool::PlacementCallback& cb)
+{
+  threadPool_->setPlacementCallback(cb);
+}
+
 void TcpServer::start()
 {
   if (started_.getAndSet(1) == 0)
   {
     threadPool_->start(threadInitCallback_);
+    ioLoops_ = threadPool_->getAllLoops();
+    for (EventLoop* ioLoop : ioLoops_)
+    {
+      shards_[ioLoop].reset(new Shard);
+    }
 
     assert(!acceptor_->listening());
-    loop_->runInLoop(
-        std::bind(&Acceptor::listen, get_pointer(acceptor_)));
+    if (option_ == kReusePortPerLoop && threadPool_->getAllLoops().front() != loop_)
+    {
+      // acceptor_ only holds the port
+      startLoopAcceptors();
+    }
+    else
+    {
+      loop_->runInLoop(
+          std::bind(&Acceptor::listen, get_pointer(acceptor_)));
+    }
+  }
+}
+
+void TcpServer::startLoopAcceptors()
+{
+  const InetAddress listenAddr(acceptor_->listenAddress());
+  std::vector<EventLoop*> loops = threadPool_->getAllLoops();
+  for (EventLoop* ioLoop : loops)
+  {
+    Acceptor* acceptor = new Acceptor(ioLoop, listenAddr, true);
+    acceptor->setNewConnectionCallback(
+        std::bind(&TcpServer::newConnectionInIoLoop, this, ioLoop, _1, _2));
+    loopAcceptors_.emplace_back(acceptor);
+  }
+  if (cpuSteering_)
+  {
+    // the first to listen creates the group
+    loopAcceptors_.front()->setCpuSteering(static_cast<int>(loops.size()));
+  }
+
+  // one by one, so that i-th acceptor is i-th of the SO_REUSEPORT group
+  for (size_t i = 0; i < loops.size(); ++i)
+  {
+    CountDownLatch latch(1);
+    Acceptor* acceptor = get_pointer(loopAcceptors_[i]);
+    loops[i]->runInLoop([acceptor, &latch] {
+      acceptor->listen();
+      latch.countDown();
+    });
+    latch.wait();
   }
 }
 
@@ -72,47 +164,116 @@ void TcpServer::newConnection(int sockfd, const InetAddress& peerAddr)
 {
   loop_->assertInLoopThread();
   EventLoop* ioLoop = threadPool_->getNextLoop();
-  char buf[64];
-  snprintf(buf, sizeof buf, "-%s#%d", ipPort_.c_str(), nextConnId_);
-  ++nextConnId_;
-  string connName = name_ + buf;
+  TcpConnectionPtr conn(createConnection(ioLoop, sockfd, peerAddr));
+  ioLoop->runInLoop(std::bind(&TcpServer::connectionEstablishedInLoop, this, conn));
+}
 
-  LOG_INFO << "TcpServer::newConnection [" << name_
-           << "] - new connection [" << connName
-           << "] from " << peerAddr.toIpPort();
-  InetAddress localAddr(sockets::getLocalAddr(sockfd));
+void TcpServer::newConnectionInIoLoop(EventLoop* ioLoop, int sockfd, const InetAddress& peerAddr)
+{
+  ioLoop->assertInLoopThread();
+  connectionEstablishedInLoop(createConnection(ioLoop, sockfd, peerAddr));
+}
+
+void TcpServer::connectionEstablishedInLoop(const TcpConnectionPtr& conn)
+{
+  conn->getLoop()->assertInLoopThread();
+  shardOf(conn->getLoop()).connections[conn->id()] = conn;
+  conn->connectEstablished();
+}
+
+TcpServer::Shard& TcpServer::shardOf(EventLoop* ioLoop)
+{
+  auto it = shards_.find(ioLoop);
+  assert(it != shards_.end());
+  return *it->second;
+}
+
+void TcpServer::forEachConnection(const ConnectionVisitor& cb)
+{
+  assert(started_.get());
+  for (auto& shard : shards_)
+  {
+    const ConnectionMap* connections = &shard.second->connections;
+    CountDownLatch latch(1);
+    shard.first->runInLoop([connections, &cb, &latch] {
+      for (const auto& item : *connections)
+      {
+        cb(item.second);
+      }
+      latch.countDown();
+    });
+    latch.wait();
+  }
+}
+
+TcpServer::Stats TcpServer::stats()
+{
+  Stats result;
+  for (auto& item : shards_)
+  {
+    const Shard* shard = get_pointer(item.second);
+    CountDownLatch latch(1);
+    item.first->runInLoop([shard, &result, &latch] {
+      result.connections += static_cast<int>(shard->connections.size());
+      result.traffic += shard->closedTraffic;
+      for (const auto& conn : shard->connections)
+      {
+        result.outputBacklog += conn.second->outputBacklog();
+        result.traffic += conn.second->traffic();
+      }
+      latch.countDown();
+    });
+    latch.wait();
+  }
+  result.accepted = nextConnId_.get();
+  return result;
+}
+
+TcpConnectionPtr TcpServer::createConnection(EventLoop* ioLoop,
+                                             int sockfd,
+                                             const InetAddress& peerAddr)
+{
+  InetAddress localAddr(InetAddress::localAddressOf(sockfd));
   // FIXME poll with zero timeout to double confirm the new connection
   // FIXME use make_shared if necessary
+  // named when first logged
   TcpConnectionPtr conn(new TcpConnection(ioLoop,
-                                          connName,
+                                          connNamePrefix_,
+                                          static_cast<uint64_t>(nextConnId_.incrementAndGet()),
                                           sockfd,
                                           localAddr,
                                           peerAddr));
-  connections_[connName] = conn;
+  // the name is built when first used, so only at DEBUG
+  LOG_INFO << "TcpServer::newConnection [" << name_
+           << "] - new connection #" << conn->id()
+           << " from " << peerAddr.toIpPort();
+  LOG_DEBUG << "TcpServer::newConnection [" << name_
+            << "] - connection #" << conn->id() << " is " << conn->name();
   conn->setConnectionCallback(connectionCallback_);
   conn->setMessageCallback(messageCallback_);
   conn->setWriteCompleteCallback(writeCompleteCallback_);
+  conn->setEdgeTriggered(edgeTriggered_);
+  conn->setIdleBufferTimeout(idleBufferTimeout_);
   conn->setCloseCallback(
       std::bind(&TcpServer::removeConnection, this, _1)); // FIXME: unsafe
-  ioLoop->runInLoop(std::bind(&TcpConnection::connectEstablished, conn));
+  return conn;
 }
 
 void TcpServer::removeConnection(const TcpConnectionPtr& conn)
 {
   // FIXME: unsafe
-  loop_->runInLoop(std::bind(&TcpServer::removeConnectionInLoop, this, conn));
-}
-
-void TcpServer::removeConnectionInLoop(const TcpConnectionPtr& conn)
-{
-  loop_->assertInLoopThread();
-  LOG_INFO << "TcpServer::removeConnectionInLoop [" << name_
-           << "] - connection " << conn->name();
-  size_t n = connections_.erase(conn->name());
+  EventLoop* ioLoop = conn->getLoop();
+  ioLoop->assertInLoopThread();
+  LOG_INFO << "TcpServer::removeConnection [" << name_
+           << "] - connection #" << conn->id()
+           << " from " << conn->peerAddress().toIpPort();
+  LOG_DEBUG << "TcpServer::removeConnection [" << name_
+            << "] - connection " << conn->name();
+  Shard& shard = shardOf(ioLoop);
+  size_t n = shard.connections.erase(conn->id());
   (void)n;
   assert(n == 1);
-  EventLoop* ioLoop = conn->getLoop();
+  shard.closedTraffic += conn->traffic();
   ioLoop->queueInLoop(
       std::bind(&TcpConnection::connectDestroyed, conn));
 }
-
@@ -13,9 +13,12 @@
 
 #include "muduo/base/Atomic.h"
 #include "muduo/base/Types.h"
+#include "muduo/net/EventLoopThreadPool.h"
 #include "muduo/net/TcpConnection.h"
 
 #include <map>
+#include <unordered_map>
+#include <vector>
 
 namespace muduo
 {
@@ -24,7 +27,6 @@ namespace net
 
 class Acceptor;
 class EventLoop;
-class EventLoopThreadPool;
 
 ///
 /// TCP server, supports single-threaded and thread-pool models.
@@ -34,10 +36,14 @@ class TcpServer : noncopyable
 {
  public:
   typedef std::function<void(EventLoop*)> ThreadInitCallback;
+  /// Both SO_REUSEPORT ones are ignored for AF_UNIX, with a warning.
   enum Option
   {
     kNoReusePort,
     kReusePort,
+    /// Every I/O loop listens with its own SO_REUSEPORT socket, and
+    /// keeps the connections it accepts.
+    kReusePortPerLoop,
   };
 
   //TcpServer(EventLoop* loop, const InetAddress& listenAddr);
@@ -53,20 +59,29 @@ class TcpServer : noncopyable
 
   /// Set the number of threads for handling input.
   ///
-  /// Always accepts new connection in loop's thread.
+  /// Always accepts new connection in loop's thread,
+  /// except with kReusePortPerLoop.
   /// Must be called before @c start
   /// @param numThreads
   /// - 0 means all I/O in loop's thread, no thread will created.
   ///   this is the default value.
   /// - 1 means all I/O in another thread.
   /// - N means a thread pool with N threads, new connections
-  ///   are assigned on a round-robin basis.
+  ///   are assigned on a round-robin basis, see setThreadPlacement().
   void setThreadNum(int numThreads);
+  /// How new connections are assigned to threads of the pool,
+  /// by the load of their loops. Not used with kReusePortPerLoop.
+  /// Must be called before @c start
+  void setThreadPlacement(EventLoopThreadPool::Placement placement);
+  void setThreadPlacementCallback(const EventLoopThreadPool::PlacementCallback& cb);
   void setThreadInitCallback(const ThreadInitCallback& cb)
   { threadInitCallback_ = cb; }
   /// valid after calling start()
   std::shared_ptr<EventLoopThreadPool> threadPool()
   { return threadPool_; }
+  /// Loops of the thread pool, valid after calling start(), thread safe.
+  const std::vector<EventLoop*>& ioLoops() const
+  { return ioLoops_; }
 
   /// Starts the server if it's not listening.
   ///
@@ -89,29 +104,86 @@ class TcpServer : noncopyable
   void setWriteCompleteCallback(const WriteCompleteCallback& cb)
   { writeCompleteCallback_ = cb; }
 
+  /// Edge triggered I/O for new connections.
+  /// See TcpConnection::setEdgeTriggered().
+  /// Not thread safe.
+  void setEdgeTriggered(bool on)
+  { edgeTriggered_ = on; }
+
+  /// With kReusePortPerLoop, a connection goes to the loop of
+  /// (CPU which received it % number of threads), instead of a hash.
+  /// Pin threads to match in ThreadInitCallback, Linux 4.6+.
+  /// Must be called before @c start
+  void setCpuSteering(bool on)
+  { cpuSteering_ = on; }
+
+  /// Frees buffers of connections idle for @c seconds, 0 to never free.
+  /// See TcpConnection::setIdleBufferTimeout().
+  /// Not thread safe.
+  void setIdleBufferTimeout(double seconds)
+  { idleBufferTimeout_ = seconds; }
+
+  /// Runs @c cb for each connection in its loop thread, one loop at a
+  /// time, and waits for all. Call it after start(), and not in an I/O
+  /// loop of this server unless it's the only one, eg. from Inspector.
+  typedef std::function<void (const TcpConnectionPtr&)> ConnectionVisitor;
+  void forEachConnection(const ConnectionVisitor& cb);
+
+  struct Stats
+  {
+    int connections = 0;
+    int64_t accepted = 0;
+    size_t outputBacklog = 0;  // of current connections
+    TcpConnection::Traffic traffic;  // of current and closed connections
+  };
+  /// Sums up connections of all loops, see forEachConnection().
+  Stats stats();
+
  private:
   /// Not thread safe, but in loop
   void newConnection(int sockfd, const InetAddress& peerAddr);
-  /// Thread safe.
+  /// Not thread safe, but in ioLoop, kReusePortPerLoop
+  void newConnectionInIoLoop(EventLoop* ioLoop, int sockfd, const InetAddress& peerAddr);
+  TcpConnectionPtr createConnection(EventLoop* ioLoop, int sockfd, const InetAddress& peerAddr);
+  void startLoopAcceptors();
+  /// Not thread safe, but in ioLoop of conn
+  void connectionEstablishedInLoop(const TcpConnectionPtr& conn);
+  /// Not thread safe, but in ioLoop of conn
   void removeConnection(const TcpConnectionPtr& conn);
-  /// Not thread safe, but in loop
-  void removeConnectionInLoop(const TcpConnectionPtr& conn);
 
-  typedef std::map<string, TcpConnectionPtr> ConnectionMap;
+  // by TcpConnection::id()
+  typedef std::unordered_map<uint64_t, TcpConnectionPtr> ConnectionMap;
+  // of one I/O loop
+  struct Shard
+  {
+    ConnectionMap connections;
+    TcpConnection::Traffic closedTraffic;
+  };
+  Shard& shardOf(EventLoop* ioLoop);
 
   EventLoop* loop_;  // the acceptor loop
   const string ipPort_;
   const string name_;
+  const Option option_;
   std::unique_ptr<Acceptor> acceptor_; // avoid revealing Acceptor
+  // kReusePortPerLoop, one per loop of threadPool_
+  std::vector<std::unique_ptr<Acceptor>> loopAcceptors_;
   std::shared_ptr<EventLoopThreadPool> threadPool_;
   ConnectionCallback connectionCallback_;
   MessageCallback messageCallback_;
   WriteCompleteCallback writeCompleteCallback_;
   ThreadInitCallback threadInitCallback_;
+  bool edgeTriggered_;
+  bool cpuSteering_;
+  double idleBufferTimeout_;
   AtomicInt32 started_;
-  // always in loop thread
-  int nextConnId_;
-  ConnectionMap connections_;
+  AtomicInt64 nextConnId_;
+  // name_ + "-" + ipPort_, shared by connections
+  const TcpConnection::NamePrefix connNamePrefix_;
+  // one per loop of threadPool_, filled in start(), then each
+  // is only touched in the thread of its loop, and destroyed there
+  std::map<EventLoop*, std::unique_ptr<Shard>> shards_;
+  std::vector<EventLoop*> ioLoops_;
 };
 
 }  // namespace net
@@ -31,7 +31,10 @@ class Timer : noncopyable
       expiration_(when),
       interval_(interval),
       repeat_(interval > 0.0),
-      sequence_(s_numCreated_.incrementAndGet())
+      sequence_(s_numCreated_.incrementAndGet()),
+      prev_(NULL),
+      next_(NULL),
+      slot_(-1)
   { }
 
   void run() const
@@ -39,6 +42,8 @@ class Timer : noncopyable
     callback_();
   }
 
+  const std::type_info& callbackType() const { return callback_.targetType(); }
+
   Timestamp expiration() const  { return expiration_; }
   bool repeat() const { return repeat_; }
   int64_t sequence() const { return sequence_; }
@@ -54,6 +59,12 @@ class Timer : noncopyable
   const bool repeat_;
   const int64_t sequence_;
 
+  // used by WheelTimerQueue
+  friend class WheelTimerQueue;
+  Timer* prev_;
+  Timer* next_;
+  int slot_;
+
   static AtomicInt64 s_numCreated_;
 };
 
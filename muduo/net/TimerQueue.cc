@@ -6,10 +6,6 @@
 
 // Author: Shuo Chen (chenshuo at chenshuo dot com)
 
-#ifndef __STDC_LIMIT_MACROS
-#define __STDC_LIMIT_MACROS
-#endif
-
 #include "muduo/net/TimerQueue.h"
 
 #include "muduo/base/Logging.h"
@@ -91,9 +87,7 @@ using namespace muduo::net::detail;
 TimerQueue::TimerQueue(EventLoop* loop)
   : loop_(loop),
     timerfd_(createTimerfd()),
-    timerfdChannel_(loop, timerfd_),
-    timers_(),
-    callingExpiredTimers_(false)
+    timerfdChannel_(loop, timerfd_)
 {
   timerfdChannel_.setReadCallback(
       std::bind(&TimerQueue::handleRead, this));
@@ -106,11 +100,6 @@ TimerQueue::~TimerQueue()
   timerfdChannel_.disableAll();
   timerfdChannel_.remove();
   ::close(timerfd_);
-  // do not remove channel, since we're in EventLoop::dtor();
-  for (const Entry& timer : timers_)
-  {
-    delete timer.second;
-  }
 }
 
 TimerId TimerQueue::addTimer(TimerCallback cb,
@@ -129,132 +118,39 @@ void TimerQueue::cancel(TimerId timerId)
       std::bind(&TimerQueue::cancelInLoop, this, timerId));
 }
 
-void TimerQueue::addTimerInLoop(Timer* timer)
+void TimerQueue::resetTimerfd(Timestamp expiration)
 {
-  loop_->assertInLoopThread();
-  bool earliestChanged = insert(timer);
-
-  if (earliestChanged)
-  {
-    resetTimerfd(timerfd_, timer->expiration());
-  }
-}
-
-void TimerQueue::cancelInLoop(TimerId timerId)
-{
-  loop_->assertInLoopThread();
-  assert(timers_.size() == activeTimers_.size());
-  ActiveTimer timer(timerId.timer_, timerId.sequence_);
-  ActiveTimerSet::iterator it = activeTimers_.find(timer);
-  if (it != activeTimers_.end())
-  {
-    size_t n = timers_.erase(Entry(it->first->expiration(), it->first));
-    assert(n == 1); (void)n;
-    delete it->first; // FIXME: no delete please
-    activeTimers_.erase(it);
-  }
-  else if (callingExpiredTimers_)
-  {
-    cancelingTimers_.insert(timer);
-  }
-  assert(timers_.size() == activeTimers_.size());
+  detail::resetTimerfd(timerfd_, expiration);
 }
 
-void TimerQueue::handleRead()
+void TimerQueue::runTimer(Timer* timer)
 {
-  loop_->assertInLoopThread();
-  Timestamp now(Timestamp::now());
-  readTimerfd(timerfd_, now);
-
-  std::vector<Entry> expired = getExpired(now);
-
-  callingExpiredTimers_ = true;
-  cancelingTimers_.clear();
-  // safe to callback outside critical section
-  for (const Entry& it : expired)
+  if (!loop_->profiling())
   {
-    it.second->run();
+    timer->run();
+    return;
   }
-  callingExpiredTimers_ = false;
-
-  reset(expired, now);
+  Timestamp start(Timestamp::now());
+  timer->run();
+  loop_->countTimerCallback(Timestamp::now().microSecondsSinceEpoch() - start.microSecondsSinceEpoch(),
+                            timer->callbackType());
 }
 
-std::vector<TimerQueue::Entry> TimerQueue::getExpired(Timestamp now)
+Timer* TimerQueue::timerOf(const TimerId& timerId)
 {
-  assert(timers_.size() == activeTimers_.size());
-  std::vector<Entry> expired;
-  Entry sentry(now, reinterpret_cast<Timer*>(UINTPTR_MAX));
-  TimerList::iterator end = timers_.lower_bound(sentry);
-  assert(end == timers_.end() || now < end->first);
-  std::copy(timers_.begin(), end, back_inserter(expired));
-  timers_.erase(timers_.begin(), end);
-
-  for (const Entry& it : expired)
-  {
-    ActiveTimer timer(it.second, it.second->sequence());
-    size_t n = activeTimers_.erase(timer);
-    assert(n == 1); (void)n;
-  }
-
-  assert(timers_.size() == activeTimers_.size());
-  return expired;
+  return timerId.timer_;
 }
 
-void TimerQueue::reset(const std::vector<Entry>& expired, Timestamp now)
+int64_t TimerQueue::sequenceOf(const TimerId& timerId)
 {
-  Timestamp nextExpire;
-
-  for (const Entry& it : expired)
-  {
-    ActiveTimer timer(it.second, it.second->sequence());
-    if (it.second->repeat()
-        && cancelingTimers_.find(timer) == cancelingTimers_.end())
-    {
-      it.second->restart(now);
-      insert(it.second);
-    }
-    else
-    {
-      // FIXME move to a free list
-      delete it.second; // FIXME: no delete please
-    }
-  }
-
-  if (!timers_.empty())
-  {
-    nextExpire = timers_.begin()->second->expiration();
-  }
-
-  if (nextExpire.valid())
-  {
-    resetTimerfd(timerfd_, nextExpire);
-  }
+  return timerId.sequence_;
 }
 
-bool TimerQueue::insert(Timer* timer)
+void TimerQueue::handleRead()
 {
   loop_->assertInLoopThread();
-  assert(timers_.size() == activeTimers_.size());
-  bool earliestChanged = false;
-  Timestamp when = timer->expiration();
-  TimerList::iterator it = timers_.begin();
-  if (it == timers_.end() || when < it->first)
-  {
-    earliestChanged = true;
-  }
-  {
-    std::pair<TimerList::iterator, bool> result
-      = timers_.insert(Entry(when, timer));
-    assert(result.second); (void)result;
-  }
-  {
-    std::pair<ActiveTimerSet::iterator, bool> result
-      = activeTimers_.insert(ActiveTimer(timer, timer->sequence()));
-    assert(result.second); (void)result;
-  }
-
-  assert(timers_.size() == activeTimers_.size());
-  return earliestChanged;
+  // fresh enough, timers fire late rather than early
+  Timestamp now(loop_->pollReturnTime());
+  readTimerfd(timerfd_, now);
+  runExpired(now);
 }
-
@@ -11,10 +11,6 @@
 #ifndef MUDUO_NET_TIMERQUEUE_H
 #define MUDUO_NET_TIMERQUEUE_H
 
-#include <set>
-#include <vector>
-
-#include "muduo/base/Mutex.h"
 #include "muduo/base/Timestamp.h"
 #include "muduo/net/Callbacks.h"
 #include "muduo/net/Channel.h"
@@ -32,11 +28,14 @@ class TimerId;
 /// A best efforts timer queue.
 /// No guarantee that the callback will be on time.
 ///
+/// Base class of timer containers, it owns the timerfd.
+/// See SetTimerQueue and WheelTimerQueue.
+///
 class TimerQueue : noncopyable
 {
  public:
   explicit TimerQueue(EventLoop* loop);
-  ~TimerQueue();
+  virtual ~TimerQueue();
 
   ///
   /// Schedules the callback to be run at given time,
@@ -49,36 +48,28 @@ class TimerQueue : noncopyable
 
   void cancel(TimerId timerId);
 
- private:
+ protected:
+  virtual void addTimerInLoop(Timer* timer) = 0;
+  virtual void cancelInLoop(TimerId timerId) = 0;
+  // called when timerfd alarms
+  virtual void runExpired(Timestamp now) = 0;
 
-  // FIXME: use unique_ptr<Timer> instead of raw pointers.
-  // This requires heterogeneous comparison lookup (N3465) from C++14
-  // so that we can find an T* in a set<unique_ptr<T>>.
-  typedef std::pair<Timestamp, Timer*> Entry;
-  typedef std::set<Entry> TimerList;
-  typedef std::pair<Timer*, int64_t> ActiveTimer;
-  typedef std::set<ActiveTimer> ActiveTimerSet;
+  // runs the callback of an expired timer, timed if the loop is profiling
+  void runTimer(Timer* timer);
 
-  void addTimerInLoop(Timer* timer);
-  void cancelInLoop(TimerId timerId);
-  // called when timerfd alarms
-  void handleRead();
-  // move out all expired timers
-  std::vector<Entry> getExpired(Timestamp now);
-  void reset(const std::vector<Entry>& expired, Timestamp now);
+  // wakes up the loop at expiration
+  void resetTimerfd(Timestamp expiration);
 
-  bool insert(Timer* timer);
+  static Timer* timerOf(const TimerId& timerId);
+  static int64_t sequenceOf(const TimerId& timerId);
 
   EventLoop* loop_;
+
+ private:
+  void handleRead();
+
   const int timerfd_;
   Channel timerfdChannel_;
-  // Timer list sorted by expiration
-  TimerList timers_;
-
-  // for cancel()
-  ActiveTimerSet activeTimers_;
-  bool callingExpiredTimers_; /* atomic */
-  ActiveTimerSet cancelingTimers_;
 };
 
 }  // namespace net
@@ -0,0 +1,73 @@
+// Use of this source code is governed by a BSD-style license
+// that can be found in the License file.
+
+#include "muduo/net/UdpClient.h"
+
+#include "muduo/base/Logging.h"
+#include "muduo/net/EventLoop.h"
+
+using namespace muduo;
+using namespace muduo::net;
+
+UdpClient::UdpClient(EventLoop* loop,
+                     const InetAddress& serverAddr,
+                     const string& nameArg)
+  : loop_(CHECK_NOTNULL(loop)),
+    serverAddr_(serverAddr),
+    name_(nameArg),
+    batchSize_(UdpSocket::kDefaultBatchSize)
+{
+  LOG_INFO << "UdpClient::UdpClient[" << name_
+           << "] - server " << serverAddr_.toIpPort();
+}
+
+UdpClient::~UdpClient()
+{
+  LOG_INFO << "UdpClient::~UdpClient[" << name_ << "]";
+  disconnect();
+}
+
+bool UdpClient::connect()
+{
+  UdpSocketPtr sock(new UdpSocket(loop_, name_, serverAddr_.family()));
+  if (!sock->connect(serverAddr_))
+  {
+    return false;
+  }
+  sock->setMessageCallback(messageCallback_);
+  sock->setBatchSize(batchSize_);
+  UdpSocketPtr old;
+  {
+  MutexLockGuard lock(mutex_);
+  old.swap(socket_);
+  socket_ = sock;
+  }
+  if (old)
+  {
+    loop_->runInLoop(std::bind(&UdpSocket::stop, old));
+  }
+  loop_->runInLoop(std::bind(&UdpSocket::start, sock));
+  return true;
+}
+
+void UdpClient::disconnect()
+{
+  UdpSocketPtr sock;
+  {
+  MutexLockGuard lock(mutex_);
+  sock.swap(socket_);
+  }
+  if (sock)
+  {
+    loop_->runInLoop(std::bind(&UdpSocket::stop, sock));
+  }
+}
+
+void UdpClient::send(const StringPiece& datagram)
+{
+  UdpSocketPtr sock(socket());
+  if (sock)
+  {
+    sock->send(datagram);
+  }
+}
@@ -0,0 +1,68 @@
+// Use of this source code is governed by a BSD-style license
+// that can be found in the License file.
+//
+// This is a public header file, it must only include public header files.
+
+#ifndef MUDUO_NET_UDPCLIENT_H
+#define MUDUO_NET_UDPCLIENT_H
+
+#include "muduo/base/Mutex.h"
+#include "muduo/net/UdpSocket.h"
+
+namespace muduo
+{
+namespace net
+{
+
+///
+/// UDP client, a socket connected to the server.
+///
+class UdpClient : noncopyable
+{
+ public:
+  UdpClient(EventLoop* loop,
+            const InetAddress& serverAddr,
+            const string& nameArg);
+  ~UdpClient();
+
+  /// Creates the socket and starts receiving, return true if success.
+  /// Thread safe.
+  bool connect();
+  /// Thread safe.
+  void disconnect();
+
+  /// Queues a datagram to the server, dropped if not connected.
+  /// Thread safe.
+  void send(const StringPiece& datagram);
+
+  UdpSocketPtr socket() const
+  {
+    MutexLockGuard lock(mutex_);
+    return socket_;
+  }
+
+  EventLoop* getLoop() const { return loop_; }
+  const string& name() const { return name_; }
+
+  /// Set message callback.
+  /// Not thread safe.
+  void setMessageCallback(UdpMessageCallback cb)
+  { messageCallback_ = std::move(cb); }
+  /// Must be called before connect().
+  void setBatchSize(int n)
+  { batchSize_ = n; }
+
+ private:
+  EventLoop* loop_;
+  const InetAddress serverAddr_;
+  const string name_;
+  UdpMessageCallback messageCallback_;
+  int batchSize_;
+  mutable MutexLock mutex_;
+  UdpSocketPtr socket_ GUARDED_BY(mutex_);
+};
+
+}  // namespace net
+}  // namespace muduo
+
+#endif  // MUDUO_NET_UDPCLIENT_H
@@ -0,0 +1,97 @@
+// Use of this source code is governed by a BSD-style license
+// that can be found in the License file.
+
+#include "muduo/net/UdpServer.h"
+
+#include "muduo/base/Logging.h"
+#include "muduo/net/EventLoop.h"
+#include "muduo/net/EventLoopThreadPool.h"
+
+#include <stdio.h>  // snprintf
+
+using namespace muduo;
+using namespace muduo::net;
+
+UdpServer::UdpServer(EventLoop* loop,
+                     const InetAddress& listenAddr,
+                     const string& nameArg,
+                     Option option)
+  : loop_(CHECK_NOTNULL(loop)),
+    listenAddr_(listenAddr),
+    name_(nameArg),
+    option_(option),
+    threadPool_(new EventLoopThreadPool(loop, name_)),
+    batchSize_(UdpSocket::kDefaultBatchSize),
+    maxDatagramSize_(UdpSocket::kDefaultMaxDatagramSize),
+    gro_(false)
+{
+}
+
+UdpServer::~UdpServer()
+{
+  loop_->assertInLoopThread();
+  LOG_TRACE << "UdpServer::~UdpServer [" << name_ << "] destructing";
+
+  for (UdpSocketPtr& sock : sockets_)
+  {
+    UdpSocketPtr s(sock);
+    sock.reset();
+    s->getLoop()->runInLoop(std::bind(&UdpSocket::stop, s));
+  }
+}
+
+void UdpServer::setThreadNum(int numThreads)
+{
+  assert(0 <= numThreads);
+  threadPool_->setThreadNum(numThreads);
+}
+
+void UdpServer::start()
+{
+  loop_->assertInLoopThread();
+  if (started_.getAndSet(1) != 0)
+  {
+    return;
+  }
+  threadPool_->start(threadInitCallback_);
+
+  std::vector<EventLoop*> loops = threadPool_->getAllLoops();
+  if (option_ == kNoReusePort)
+  {
+    loops.resize(1);
+  }
+  // binds here, so that the port is known when start() returns
+  InetAddress addr(listenAddr_);
+  for (size_t i = 0; i < loops.size(); ++i)
+  {
+    sockets_.push_back(createSocket(loops[i], addr, static_cast<int>(i)));
+    // others join the group of the first, on its port if 0 was given
+    addr = sockets_.front()->localAddress();
+  }
+  for (const UdpSocketPtr& sock : sockets_)
+  {
+    sock->getLoop()->runInLoop(std::bind(&UdpSocket::start, sock));
+  }
+}
+
+InetAddress UdpServer::listenAddress() const
+{
+  assert(!sockets_.empty());
+  return sockets_.front()->localAddress();
+}
+
+UdpSocketPtr UdpServer::createSocket(EventLoop* ioLoop, const InetAddress& addr, int index)
+{
+  char buf[64];
+  snprintf(buf, sizeof buf, "-%s#%d", addr.toIpPort().c_str(), index);
+  UdpSocketPtr sock(new UdpSocket(ioLoop, name_ + buf, addr.family()));
+  sock->bindAddress(addr, option_ == kReusePort);
+  sock->setMessageCallback(messageCallback_);
+  sock->setBatchSize(batchSize_);
+  sock->setMaxDatagramSize(maxDatagramSize_);
+  if (gro_)
+  {
+    sock->setGro(true);
+  }
+  return sock;
+}
@@ -0,0 +1,103 @@
+// Use of this source code is governed by a BSD-style license
+// that can be found in the License file.
+//
+// This is a public header file, it must only include public header files.
+
+#ifndef MUDUO_NET_UDPSERVER_H
+#define MUDUO_NET_UDPSERVER_H
+
+#include "muduo/base/Atomic.h"
+#include "muduo/base/Types.h"
+#include "muduo/net/UdpSocket.h"
+
+#include <vector>
+
+namespace muduo
+{
+namespace net
+{
+
+class EventLoop;
+class EventLoopThreadPool;
+
+///
+/// UDP server, supports single-threaded and thread-pool models.
+///
+/// This is an interface class, so don't expose too much details.
+class UdpServer : noncopyable
+{
+ public:
+  typedef std::function<void(EventLoop*)> ThreadInitCallback;
+  enum Option
+  {
+    kNoReusePort,
+    /// One socket per loop of the thread pool, in a SO_REUSEPORT group,
+    /// the kernel spreads peers across them by hash.
+    kReusePort,
+  };
+
+  UdpServer(EventLoop* loop,
+            const InetAddress& listenAddr,
+            const string& nameArg,
+            Option option = kNoReusePort);
+  ~UdpServer();  // force out-line dtor, for std::unique_ptr members.
+
+  const string& name() const { return name_; }
+  EventLoop* getLoop() const { return loop_; }
+
+  /// Set the number of threads, with kReusePort.
+  /// Otherwise the only socket is in the first thread.
+  /// Must be called before @c start
+  void setThreadNum(int numThreads);
+  void setThreadInitCallback(const ThreadInitCallback& cb)
+  { threadInitCallback_ = cb; }
+  /// valid after calling start()
+  std::shared_ptr<EventLoopThreadPool> threadPool()
+  { return threadPool_; }
+
+  // Must be called before @c start, see UdpSocket.
+  void setMessageCallback(const UdpMessageCallback& cb)
+  { messageCallback_ = cb; }
+  void setBatchSize(int n)
+  { batchSize_ = n; }
+  void setMaxDatagramSize(size_t n)
+  { maxDatagramSize_ = n; }
+  void setGro(bool on)
+  { gro_ = on; }
+
+  /// Binds and starts receiving.
+  ///
+  /// It's harmless to call it multiple times.
+  /// Must be called in loop thread.
+  void start();
+
+  /// Bound address, eg. to find the port if 0 was given.
+  /// valid after calling start()
+  InetAddress listenAddress() const;
+
+  /// One per loop with kReusePort.
+  /// valid after calling start()
+  const std::vector<UdpSocketPtr>& sockets() const
+  { return sockets_; }
+
+ private:
+  UdpSocketPtr createSocket(EventLoop* ioLoop, const InetAddress& addr, int index);
+
+  EventLoop* loop_;  // the acceptor loop
+  const InetAddress listenAddr_;
+  const string name_;
+  const Option option_;
+  std::shared_ptr<EventLoopThreadPool> threadPool_;
+  UdpMessageCallback messageCallback_;
+  ThreadInitCallback threadInitCallback_;
+  int batchSize_;
+  size_t maxDatagramSize_;
+  bool gro_;
+  AtomicInt32 started_;
+  std::vector<UdpSocketPtr> sockets_;
+};
+
+}  // namespace net
+}  // namespace muduo
+
+#endif  // MUDUO_NET_UDPSERVER_H
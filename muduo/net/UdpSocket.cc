@@ -0,0 +1,447 @@
+// Use of this source code is governed by a BSD-style license
+// that can be found in the License file.
+
+#include "muduo/net/UdpSocket.h"
+
+#include "muduo/base/Logging.h"
+#include "muduo/net/Channel.h"
+#include "muduo/net/EventLoop.h"
+#include "muduo/net/Socket.h"
+#include "muduo/net/SocketsOps.h"
+
+#include <algorithm>
+
+#include <errno.h>
+#include <netinet/udp.h>
+#include <string.h>
+
+using namespace muduo;
+using namespace muduo::net;
+
+const int UdpSocket::kDefaultBatchSize;
+const size_t UdpSocket::kDefaultMaxDatagramSize;
+
+namespace
+{
+
+// Like TcpConnection in edge triggered mode, at most this many batches
+// per event, so that a flood can't starve the loop.
+const int kMaxBatchesPerEvent = 16;
+const int kMaxBatchSize = 1024;  // UIO_MAXIOV
+const size_t kMaxDatagramSize = 65535;
+const size_t kDefaultHighWaterMark = 4*1024*1024;
+
+const size_t kRecvControlSize = CMSG_SPACE(sizeof(int));
+const size_t kSendControlSize = CMSG_SPACE(sizeof(uint16_t));
+
+}  // namespace
+
+UdpSocket::UdpSocket(EventLoop* loop, const string& nameArg, sa_family_t family)
+  : loop_(CHECK_NOTNULL(loop)),
+    name_(nameArg),
+    socket_(new Socket(sockets::createUdpNonblockingOrDie(family))),
+    channel_(new Channel(loop, socket_->fd())),
+    batchSize_(kDefaultBatchSize),
+    maxDatagramSize_(kDefaultMaxDatagramSize),
+    gro_(false),
+    highWaterMark_(kDefaultHighWaterMark),
+    started_(false),
+    handlingRead_(false),
+    flushQueued_(false),
+    sendHead_(0),
+    datagramsReceived_(0),
+    datagramsSent_(0),
+    datagramsDropped_(0)
+{
+  channel_->setReadCallback(
+      std::bind(&UdpSocket::handleRead, this, _1));
+  channel_->setWriteCallback(
+      std::bind(&UdpSocket::handleWrite, this));
+  LOG_DEBUG << "UdpSocket::ctor[" << name_ << "] at " << this
+            << " fd=" << socket_->fd();
+}
+
+UdpSocket::~UdpSocket()
+{
+  LOG_DEBUG << "UdpSocket::dtor[" << name_ << "] at " << this
+            << " fd=" << socket_->fd();
+  assert(!started_);
+}
+
+int UdpSocket::fd() const
+{
+  return socket_->fd();
+}
+
+InetAddress UdpSocket::localAddress() const
+{
+  return InetAddress(sockets::getLocalAddr(socket_->fd()));
+}
+
+void UdpSocket::bindAddress(const InetAddress& addr, bool reusePort)
+{
+  assert(!started_);
+  socket_->setReuseAddr(true);
+  socket_->setReusePort(reusePort);
+  socket_->bindAddress(addr);
+}
+
+bool UdpSocket::connect(const InetAddress& peer)
+{
+  assert(!started_);
+  if (sockets::connect(socket_->fd(), peer.getSockAddr()) < 0)
+  {
+    LOG_SYSERR << "UdpSocket::connect [" << name_ << "] - " << peer.toIpPort();
+    return false;
+  }
+  return true;
+}
+
+void UdpSocket::setBatchSize(int n)
+{
+  assert(!started_);
+  batchSize_ = std::min(std::max(n, 1), kMaxBatchSize);
+}
+
+void UdpSocket::setMaxDatagramSize(size_t n)
+{
+  assert(!started_);
+  maxDatagramSize_ = std::min(std::max(n, size_t(1)), kMaxDatagramSize);
+}
+
+bool UdpSocket::setGro(bool on)
+{
+  assert(!started_);
+#ifdef UDP_GRO
+  int optval = on ? 1 : 0;
+  int ret = ::setsockopt(socket_->fd(), SOL_UDP, UDP_GRO,
+                         &optval, static_cast<socklen_t>(sizeof optval));
+  if (ret < 0)
+  {
+    if (on)
+    {
+      LOG_SYSERR << "UDP_GRO failed.";
+    }
+    return false;
+  }
+  gro_ = on;
+  if (on)
+  {
+    maxDatagramSize_ = kMaxDatagramSize;
+  }
+  return true;
+#else
+  if (on)
+  {
+    LOG_ERROR << "UDP_GRO is not supported.";
+  }
+  return !on;
+#endif
+}
+
+void UdpSocket::start()
+{
+  loop_->assertInLoopThread();
+  assert(!started_);
+  started_ = true;
+
+  const size_t batch = static_cast<size_t>(batchSize_);
+  recvMsgs_.resize(batch);
+  recvVecs_.resize(batch);
+  recvAddrs_.resize(batch);
+  recvControl_.resize(batch * kRecvControlSize);
+  recvBuffer_.resize(batch * maxDatagramSize_);
+  memZero(recvMsgs_.data(), batch * sizeof(struct mmsghdr));
+  for (size_t i = 0; i < batch; ++i)
+  {
+    recvVecs_[i].iov_base = &recvBuffer_[i * maxDatagramSize_];
+    recvVecs_[i].iov_len = maxDatagramSize_;
+    struct msghdr& hdr = recvMsgs_[i].msg_hdr;
+    hdr.msg_name = &recvAddrs_[i];
+    hdr.msg_iov = &recvVecs_[i];
+    hdr.msg_iovlen = 1;
+    hdr.msg_control = gro_ ? &recvControl_[i * kRecvControlSize] : NULL;
+  }
+  sendMsgs_.resize(batch);
+  sendVecs_.resize(batch);
+  sendControl_.resize(batch * kSendControlSize);
+
+  channel_->tie(shared_from_this());
+  channel_->enableReading();
+}
+
+void UdpSocket::stop()
+{
+  loop_->assertInLoopThread();
+  if (started_)
+  {
+    started_ = false;
+    channel_->disableAll();
+    channel_->remove();
+    datagramsDropped_ += static_cast<int64_t>(sendQueue_.size() - sendHead_);
+    clearSendQueue();
+  }
+}
+
+void UdpSocket::send(const InetAddress& peer, const StringPiece& datagram)
+{
+  if (loop_->isInLoopThread())
+  {
+    sendInLoop(peer, datagram, false, 0);
+  }
+  else
+  {
+    loop_->runInLoop(
+        std::bind(&UdpSocket::sendCopyInLoop, shared_from_this(),
+                  peer, datagram.as_string(), false, 0));
+  }
+}
+
+void UdpSocket::send(const StringPiece& datagram)
+{
+  if (loop_->isInLoopThread())
+  {
+    sendInLoop(InetAddress(), datagram, true, 0);
+  }
+  else
+  {
+    loop_->runInLoop(
+        std::bind(&UdpSocket::sendCopyInLoop, shared_from_this(),
+                  InetAddress(), datagram.as_string(), true, 0));
+  }
+}
+
+void UdpSocket::sendSegments(const InetAddress& peer, const StringPiece& data, int segmentSize)
+{
+  loop_->assertInLoopThread();
+  assert(0 < segmentSize && segmentSize <= 65535);
+#ifdef UDP_SEGMENT
+  sendInLoop(peer, data, false, segmentSize);
+#else
+  // one by one
+  for (int offset = 0; offset < data.size(); offset += segmentSize)
+  {
+    sendInLoop(peer, StringPiece(data.data() + offset, std::min(segmentSize, data.size() - offset)),
+               false, 0);
+  }
+#endif
+}
+
+void UdpSocket::sendCopyInLoop(const InetAddress& peer, const string& data,
+                               bool connected, int segmentSize)
+{
+  sendInLoop(peer, data, connected, segmentSize);
+}
+
+void UdpSocket::sendInLoop(const InetAddress& peer, const StringPiece& data,
+                           bool connected, int segmentSize)
+{
+  loop_->assertInLoopThread();
+  const size_t len = static_cast<size_t>(data.size());
+  if (!started_ || queuedBytes() + len > highWaterMark_)
+  {
+    LOG_TRACE << "UdpSocket::sendInLoop [" << name_ << "] - drop " << len << " bytes";
+    ++datagramsDropped_;
+    return;
+  }
+
+  Datagram datagram;
+  datagram.offset = sendBuffer_.size();
+  datagram.length = len;
+  memcpy(&datagram.peer, peer.getSockAddr(), sizeof datagram.peer);
+  datagram.connected = connected;
+  datagram.segmentSize = static_cast<uint16_t>(segmentSize);
+  sendBuffer_.insert(sendBuffer_.end(), data.data(), data.data() + len);
+  sendQueue_.push_back(datagram);
+
+  if (sendQueue_.size() - sendHead_ >= static_cast<size_t>(batchSize_))
+  {
+    flush();
+  }
+  else if (!handlingRead_ && !flushQueued_ && !channel_->isWriting())
+  {
+    // sends of this round of the loop go together
+    flushQueued_ = true;
+    loop_->queueInLoop(std::bind(&UdpSocket::flushQueued, shared_from_this()));
+  }
+}
+
+void UdpSocket::flushQueued()
+{
+  flushQueued_ = false;
+  if (!channel_->isWriting())
+  {
+    flush();
+  }
+}
+
+void UdpSocket::flush()
+{
+  loop_->assertInLoopThread();
+  while (started_ && sendHead_ < sendQueue_.size())
+  {
+    const size_t n = std::min(sendQueue_.size() - sendHead_, static_cast<size_t>(batchSize_));
+    for (size_t i = 0; i < n; ++i)
+    {
+      Datagram& datagram = sendQueue_[sendHead_ + i];
+      sendVecs_[i].iov_base = &sendBuffer_[datagram.offset];
+      sendVecs_[i].iov_len = datagram.length;
+      struct msghdr& hdr = sendMsgs_[i].msg_hdr;
+      memZero(&hdr, sizeof hdr);
+      if (!datagram.connected)
+      {
+        hdr.msg_name = &datagram.peer;
+        hdr.msg_namelen = static_cast<socklen_t>(sizeof datagram.peer);
+      }
+      hdr.msg_iov = &sendVecs_[i];
+      hdr.msg_iovlen = 1;
+#ifdef UDP_SEGMENT
+      if (datagram.segmentSize > 0)
+      {
+        hdr.msg_control = &sendControl_[i * kSendControlSize];
+        hdr.msg_controllen = kSendControlSize;
+        struct cmsghdr* cmsg = CMSG_FIRSTHDR(&hdr);
+        cmsg->cmsg_level = SOL_UDP;
+        cmsg->cmsg_type = UDP_SEGMENT;
+        cmsg->cmsg_len = CMSG_LEN(sizeof(uint16_t));
+        memcpy(CMSG_DATA(cmsg), &datagram.segmentSize, sizeof(uint16_t));
+      }
+#endif
+    }
+
+    int sent = sockets::sendmmsg(socket_->fd(), sendMsgs_.data(), static_cast<unsigned int>(n));
+    if (sent > 0)
+    {
+      sendHead_ += static_cast<size_t>(sent);
+      datagramsSent_ += sent;
+    }
+    else if (errno == EAGAIN || errno == EWOULDBLOCK)
+    {
+      // socket buffer is full
+      if (!channel_->isWriting())
+      {
+        channel_->enableWriting();
+      }
+      return;
+    }
+    else
+    {
+      // eg. ECONNREFUSED by an earlier datagram, or EMSGSIZE
+      LOG_SYSERR << "UdpSocket::flush [" << name_ << "]";
+      ++sendHead_;
+      ++datagramsDropped_;
+    }
+  }
+  clearSendQueue();
+  if (channel_->isWriting())
+  {
+    channel_->disableWriting();
+  }
+}
+
+size_t UdpSocket::queuedBytes() const
+{
+  return sendHead_ < sendQueue_.size()
+      ? sendBuffer_.size() - sendQueue_[sendHead_].offset : 0;
+}
+
+void UdpSocket::clearSendQueue()
+{
+  sendQueue_.clear();
+  sendHead_ = 0;
+  sendBuffer_.clear();
+}
+
+void UdpSocket::handleRead(Timestamp receiveTime)
+{
+  loop_->assertInLoopThread();
+  UdpSocketPtr guardThis(shared_from_this());
+  handlingRead_ = true;
+  for (int i = 0; i < kMaxBatchesPerEvent && started_; ++i)
+  {
+    for (int j = 0; j < batchSize_; ++j)
+    {
+      struct msghdr& hdr = recvMsgs_[j].msg_hdr;
+      hdr.msg_namelen = static_cast<socklen_t>(sizeof(struct sockaddr_in6));
+      hdr.msg_controllen = gro_ ? kRecvControlSize : 0;
+      hdr.msg_flags = 0;
+    }
+    int n = sockets::recvmmsg(socket_->fd(), recvMsgs_.data(), static_cast<unsigned int>(batchSize_));
+    if (n < 0)
+    {
+      // ECONNREFUSED of a connected socket is reported here
+      if (errno != EAGAIN && errno != EWOULDBLOCK)
+      {
+        LOG_SYSERR << "UdpSocket::handleRead [" << name_ << "]";
+      }
+      break;
+    }
+    for (int j = 0; j < n && started_; ++j)
+    {
+      deliver(guardThis, recvMsgs_[j], &recvBuffer_[j * maxDatagramSize_], receiveTime);
+    }
+    if (n < batchSize_)
+    {
+      break;
+    }
+  }
+  handlingRead_ = false;
+  // replies to this batch
+  if (!channel_->isWriting())
+  {
+    flush();
+  }
+}
+
+void UdpSocket::handleWrite()
+{
+  loop_->assertInLoopThread();
+  flush();
+}
+
+void UdpSocket::deliver(const UdpSocketPtr& self, const struct mmsghdr& msg,
+                        const char* data, Timestamp receiveTime)
+{
+  const size_t len = msg.msg_len;
+  if (msg.msg_hdr.msg_flags & MSG_TRUNC)
+  {
+    LOG_WARN << "UdpSocket::deliver [" << name_ << "] - datagram larger than "
+             << maxDatagramSize_ << " bytes is dropped";
+    ++datagramsDropped_;
+    return;
+  }
+
+  size_t segmentSize = len;
+#ifdef UDP_GRO
+  if (gro_)
+  {
+    for (struct cmsghdr* cmsg = CMSG_FIRSTHDR(&msg.msg_hdr);
+         cmsg != NULL;
+         cmsg = CMSG_NXTHDR(const_cast<struct msghdr*>(&msg.msg_hdr), cmsg))
+    {
+      if (cmsg->cmsg_level == SOL_UDP && cmsg->cmsg_type == UDP_GRO)
+      {
+        int gsoSize = 0;
+        memcpy(&gsoSize, CMSG_DATA(cmsg), sizeof gsoSize);
+        if (gsoSize > 0)
+        {
+          segmentSize = static_cast<size_t>(gsoSize);
+        }
+      }
+    }
+  }
+#endif
+
+  const InetAddress peer(*static_cast<const struct sockaddr_in6*>(msg.msg_hdr.msg_name));
+  size_t offset = 0;
+  do
+  {
+    const size_t n = std::min(segmentSize, len - offset);
+    ++datagramsReceived_;
+    if (messageCallback_)
+    {
+      messageCallback_(self, peer, StringPiece(data + offset, static_cast<int>(n)), receiveTime);
+    }
+    offset += n;
+  } while (offset < len);
+}
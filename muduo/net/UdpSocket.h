@@ -0,0 +1,158 @@
+// Use of this source code is governed by a BSD-style license
+// that can be found in the License file.
+//
+// This is a public header file, it must only include public header files.
+
+#ifndef MUDUO_NET_UDPSOCKET_H
+#define MUDUO_NET_UDPSOCKET_H
+
+#include "muduo/base/noncopyable.h"
+#include "muduo/base/StringPiece.h"
+#include "muduo/base/Types.h"
+#include "muduo/net/Callbacks.h"
+#include "muduo/net/InetAddress.h"
+
+#include <memory>
+#include <vector>
+
+#include <sys/socket.h>
+#include <sys/uio.h>
+
+namespace muduo
+{
+namespace net
+{
+
+class Channel;
+class EventLoop;
+class Socket;
+
+///
+/// A bound or connected UDP socket in an EventLoop.
+///
+/// Receives with recvmmsg(2) in batches, and queues datagrams to send,
+/// they go out together with sendmmsg(2) after the current batch of
+/// receives, or in the next round of the loop.
+///
+/// Use UdpServer or UdpClient to create one.
+///
+class UdpSocket : noncopyable,
+                  public std::enable_shared_from_this<UdpSocket>
+{
+ public:
+  static const int kDefaultBatchSize = 32;
+  /// Larger datagrams are truncated, and dropped.
+  static const size_t kDefaultMaxDatagramSize = 2048;
+
+  /// Creates a socket of @c family, AF_INET or AF_INET6.
+  UdpSocket(EventLoop* loop, const string& name, sa_family_t family);
+  ~UdpSocket();
+
+  EventLoop* getLoop() const { return loop_; }
+  const string& name() const { return name_; }
+  int fd() const;
+  InetAddress localAddress() const;
+
+  /// Binds, abort if any error. Must be called before start().
+  /// With @c reusePort, it joins the SO_REUSEPORT group of the address.
+  void bindAddress(const InetAddress& addr, bool reusePort);
+  /// Only receives from @c peer, and send(datagram) goes to it.
+  /// Return true if success.
+  bool connect(const InetAddress& peer);
+
+  // Must be called before start().
+  void setMessageCallback(const UdpMessageCallback& cb)
+  { messageCallback_ = cb; }
+  /// Datagrams per recvmmsg(2) or sendmmsg(2).
+  void setBatchSize(int n);
+  void setMaxDatagramSize(size_t n);
+  /// UDP_GRO, the kernel coalesces datagrams of a flow into one receive,
+  /// which is split again for UdpMessageCallback. Linux 5.0+.
+  /// Raises max datagram size to 64KiB, return true if success.
+  bool setGro(bool on);
+
+  /// Queued bytes to send, datagrams beyond it are dropped.
+  void setHighWaterMark(size_t bytes) { highWaterMark_ = bytes; }
+
+  /// Starts receiving, in loop thread.
+  void start();
+  /// Stops receiving, in loop thread, queued datagrams are dropped.
+  void stop();
+
+  /// Queues a datagram to @c peer.
+  /// Thread safe, copies @c datagram if not in loop thread.
+  void send(const InetAddress& peer, const StringPiece& datagram);
+  /// Queues a datagram to the connected peer, see UdpClient.
+  void send(const StringPiece& datagram);
+  /// With UDP_SEGMENT, the kernel or the NIC splits @c data into datagrams
+  /// of @c segmentSize bytes to @c peer, the last may be shorter.
+  /// At most 64 segments and 64KiB. Linux 4.18+.
+  void sendSegments(const InetAddress& peer, const StringPiece& data, int segmentSize);
+  /// Sends queued datagrams now, in loop thread.
+  void flush();
+
+  // in loop thread
+  int64_t datagramsReceived() const { return datagramsReceived_; }
+  int64_t datagramsSent() const { return datagramsSent_; }
+  /// Truncated, or beyond high water mark, or failed to send.
+  int64_t datagramsDropped() const { return datagramsDropped_; }
+
+ private:
+  struct Datagram
+  {
+    size_t offset;  // in sendBuffer_
+    size_t length;
+    struct sockaddr_in6 peer;
+    bool connected;  // no peer
+    uint16_t segmentSize;  // 0 if not GSO
+  };
+
+  void handleRead(Timestamp receiveTime);
+  void handleWrite();
+  void sendInLoop(const InetAddress& peer, const StringPiece& data,
+                  bool connected, int segmentSize);
+  void sendCopyInLoop(const InetAddress& peer, const string& data,
+                      bool connected, int segmentSize);
+  void deliver(const UdpSocketPtr& self, const struct mmsghdr& msg,
+               const char* data, Timestamp receiveTime);
+  void flushQueued();
+  size_t queuedBytes() const;
+  void clearSendQueue();
+
+  EventLoop* loop_;
+  const string name_;
+  std::unique_ptr<Socket> socket_;
+  std::unique_ptr<Channel> channel_;
+  UdpMessageCallback messageCallback_;
+  int batchSize_;
+  size_t maxDatagramSize_;
+  bool gro_;
+  size_t highWaterMark_;
+  bool started_;
+  bool handlingRead_;  // sends are flushed after the batch
+  bool flushQueued_;
+
+  // receive, allocated in start()
+  std::vector<struct mmsghdr> recvMsgs_;
+  std::vector<struct iovec> recvVecs_;
+  std::vector<struct sockaddr_in6> recvAddrs_;
+  std::vector<char> recvControl_;
+  std::vector<char> recvBuffer_;
+
+  // send
+  std::vector<Datagram> sendQueue_;
+  size_t sendHead_;  // first not sent
+  std::vector<char> sendBuffer_;
+  std::vector<struct mmsghdr> sendMsgs_;
+  std::vector<struct iovec> sendVecs_;
+  std::vector<char> sendControl_;
+
+  int64_t datagramsReceived_;
+  int64_t datagramsSent_;
+  int64_t datagramsDropped_;
+};
+
+}  // namespace net
+}  // namespace muduo
+
+#endif  // MUDUO_NET_UDPSOCKET_H
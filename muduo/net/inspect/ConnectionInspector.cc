@@ -0,0 +1,174 @@
+// Use of this source code is governed by a BSD-style license
+// that can be found in the License file.
+
+#include "muduo/net/inspect/ConnectionInspector.h"
+
+#include "muduo/net/EventLoop.h"
+#include "muduo/net/TcpServer.h"
+
+#include <algorithm>
+
+#include <inttypes.h>
+#include <stdlib.h>
+
+using namespace muduo;
+using namespace muduo::net;
+
+namespace muduo
+{
+namespace inspect
+{
+int stringPrintf(string* out, const char* fmt, ...) __attribute__ ((format (printf, 2, 3)));
+}
+}
+
+using namespace muduo::inspect;
+
+namespace
+{
+
+struct ConnectionRow
+{
+  TcpConnectionPtr conn;
+  size_t backlog;
+  TcpConnection::Traffic traffic;
+  Timestamp creationTime;
+  Timestamp lastActive;
+};
+
+bool moreBacklog(const ConnectionRow& lhs, const ConnectionRow& rhs)
+{
+  return lhs.backlog > rhs.backlog;
+}
+
+bool moreBytes(const ConnectionRow& lhs, const ConnectionRow& rhs)
+{
+  return lhs.traffic.bytesReceived + lhs.traffic.bytesSent
+      > rhs.traffic.bytesReceived + rhs.traffic.bytesSent;
+}
+
+}  // namespace
+
+const int ConnectionInspector::kDefaultTop;
+
+ConnectionInspector::ConnectionInspector(Inspector* ins)
+  : inspector_(ins)
+{
+  ins->add("conn", "servers",
+           std::bind(&ConnectionInspector::servers, this, _1, _2),
+           "print traffic of servers");
+  ins->add("conn", "loops",
+           std::bind(&ConnectionInspector::loops, this, _1, _2),
+           "print traffic of loops of servers");
+  ins->add("conn", "top",
+           std::bind(&ConnectionInspector::top, this, _1, _2),
+           "print top connections, /conn/top/[backlog|bytes]/[N]");
+}
+
+ConnectionInspector::~ConnectionInspector()
+{
+  inspector_->remove("conn", "servers");
+  inspector_->remove("conn", "loops");
+  inspector_->remove("conn", "top");
+}
+
+void ConnectionInspector::addServer(TcpServer* server)
+{
+  MutexLockGuard lock(mutex_);
+  servers_.push_back(server);
+}
+
+void ConnectionInspector::removeServer(TcpServer* server)
+{
+  MutexLockGuard lock(mutex_);
+  servers_.erase(std::remove(servers_.begin(), servers_.end(), server), servers_.end());
+}
+
+string ConnectionInspector::servers(HttpRequest::Method, const Inspector::ArgList&)
+{
+  string result = "CONNS   ACCEPTED    BACKLOG     RECEIVED         SENT    MSGS_IN   MSGS_OUT NAME\n";
+  MutexLockGuard lock(mutex_);
+  for (TcpServer* server : servers_)
+  {
+    TcpServer::Stats stats = server->stats();
+    stringPrintf(&result, "%5d %10" PRId64 " %10zu %12" PRId64 " %12" PRId64 " %10" PRId64 " %10" PRId64 " %s %s\n",
+                 stats.connections, stats.accepted, stats.outputBacklog,
+                 stats.traffic.bytesReceived, stats.traffic.bytesSent,
+                 stats.traffic.messagesReceived, stats.traffic.messagesSent,
+                 server->name().c_str(), server->ipPort().c_str());
+  }
+  return result;
+}
+
+string ConnectionInspector::loops(HttpRequest::Method, const Inspector::ArgList&)
+{
+  // also counts connections not of these servers, eg. of TcpClients
+  string result = "CONNS    BACKLOG     RECEIVED         SENT  BUSY LOOP\n";
+  MutexLockGuard lock(mutex_);
+  for (TcpServer* server : servers_)
+  {
+    const std::vector<EventLoop*>& loops = server->ioLoops();
+    for (size_t i = 0; i < loops.size(); ++i)
+    {
+      const EventLoop* loop = loops[i];
+      stringPrintf(&result, "%5d %10" PRId64 " %12" PRId64 " %12" PRId64 " %4.0f%% %s#%zu\n",
+                   loop->numConnections(), loop->pendingOutputBytes(),
+                   loop->bytesReceived(), loop->bytesSent(),
+                   loop->busyRatio() * 100, server->name().c_str(), i);
+    }
+  }
+  return result;
+}
+
+string ConnectionInspector::top(HttpRequest::Method, const Inspector::ArgList& args)
+{
+  bool (*order)(const ConnectionRow&, const ConnectionRow&) = moreBacklog;
+  if (args.size() > 0 && args[0] == "bytes")
+  {
+    order = moreBytes;
+  }
+  else if (args.size() > 0 && args[0] != "backlog")
+  {
+    return "usage: /conn/top/[backlog|bytes]/[N]\n";
+  }
+  size_t n = kDefaultTop;
+  if (args.size() > 1 && atoi(args[1].c_str()) > 0)
+  {
+    n = static_cast<size_t>(atoi(args[1].c_str()));
+  }
+
+  std::vector<ConnectionRow> rows;
+  MutexLockGuard lock(mutex_);
+  for (TcpServer* server : servers_)
+  {
+    // one loop at a time, so rows needs no lock
+    server->forEachConnection([&rows](const TcpConnectionPtr& conn) {
+      ConnectionRow row;
+      row.conn = conn;
+      row.backlog = conn->outputBacklog();
+      row.traffic = conn->traffic();
+      row.creationTime = conn->creationTime();
+      row.lastActive = std::max(conn->creationTime(),
+                                std::max(conn->lastReceiveTime(), conn->lastSendTime()));
+      rows.push_back(row);
+    });
+  }
+  n = std::min(n, rows.size());
+  std::partial_sort(rows.begin(), rows.begin() + n, rows.end(), order);
+
+  Timestamp now(Timestamp::now());
+  string result;
+  stringPrintf(&result, "%zd connections, top %zd by %s\n", rows.size(), n,
+               order == moreBytes ? "bytes" : "backlog");
+  result += "   BACKLOG     RECEIVED         SENT    MSGS_IN   MSGS_OUT      AGE     IDLE PEER                  NAME\n";
+  for (size_t i = 0; i < n; ++i)
+  {
+    const ConnectionRow& row = rows[i];
+    stringPrintf(&result, "%10zu %12" PRId64 " %12" PRId64 " %10" PRId64 " %10" PRId64 " %8.1f %8.1f %-21s %s\n",
+                 row.backlog, row.traffic.bytesReceived, row.traffic.bytesSent,
+                 row.traffic.messagesReceived, row.traffic.messagesSent,
+                 timeDifference(now, row.creationTime), timeDifference(now, row.lastActive),
+                 row.conn->peerAddress().toIpPort().c_str(), row.conn->name().c_str());
+  }
+  return result;
+}
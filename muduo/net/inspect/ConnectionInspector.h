@@ -0,0 +1,63 @@
+// Use of this source code is governed by a BSD-style license
+// that can be found in the License file.
+//
+// This is a public header file, it must only include public header files.
+
+#ifndef MUDUO_NET_INSPECT_CONNECTIONINSPECTOR_H
+#define MUDUO_NET_INSPECT_CONNECTIONINSPECTOR_H
+
+#include "muduo/base/Mutex.h"
+#include "muduo/net/inspect/Inspector.h"
+
+#include <vector>
+
+namespace muduo
+{
+namespace net
+{
+
+class TcpServer;
+
+///
+/// Module "conn" of Inspector, traffic of TcpServers, their loops, and
+/// top connections, eg. to find slow consumers with big output backlog.
+///
+/// @code
+/// /conn/servers
+/// /conn/loops
+/// /conn/top/backlog/20
+/// /conn/top/bytes
+/// @endcode
+///
+/// Pages are made in loop threads of the servers, and wait for them.
+///
+class ConnectionInspector : noncopyable
+{
+ public:
+  static const int kDefaultTop = 20;
+
+  /// Adds commands to @c ins, which must outlive this.
+  explicit ConnectionInspector(Inspector* ins);
+  ~ConnectionInspector();
+
+  /// Thread safe. @c server must be started, and removed while its loops
+  /// are running, not in them, before it's gone.
+  void addServer(TcpServer* server);
+  void removeServer(TcpServer* server);
+
+  string servers(HttpRequest::Method, const Inspector::ArgList&);
+  string loops(HttpRequest::Method, const Inspector::ArgList&);
+  /// args: [backlog|bytes] [N]
+  string top(HttpRequest::Method, const Inspector::ArgList&);
+
+ private:
+  Inspector* inspector_;
+  // held while making a page, so that servers stay
+  MutexLock mutex_;
+  std::vector<TcpServer*> servers_ GUARDED_BY(mutex_);
+};
+
+}  // namespace net
+}  // namespace muduo
+
+#endif  // MUDUO_NET_INSPECT_CONNECTIONINSPECTOR_H
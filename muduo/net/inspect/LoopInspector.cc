@@ -0,0 +1,108 @@
+// Use of this source code is governed by a BSD-style license
+// that can be found in the License file.
+
+#include "muduo/net/inspect/LoopInspector.h"
+
+#include "muduo/net/EventLoop.h"
+
+#include <inttypes.h>
+#include <stdlib.h>
+
+using namespace muduo;
+using namespace muduo::net;
+
+namespace muduo
+{
+namespace inspect
+{
+int stringPrintf(string* out, const char* fmt, ...) __attribute__ ((format (printf, 2, 3)));
+}
+}
+
+using namespace muduo::inspect;
+
+namespace
+{
+
+void printHistogram(string* out, const char* name, const Histogram& h)
+{
+  stringPrintf(out, "%-20s %12" PRId64 " %10.1f %8" PRId64 " %8" PRId64 " %8" PRId64 " %10" PRId64 "\n",
+               name, h.count(), h.average(),
+               h.percentile(0.5), h.percentile(0.99), h.percentile(0.999), h.max());
+}
+
+}  // namespace
+
+LoopInspector::LoopInspector(Inspector* ins)
+  : inspector_(ins)
+{
+  ins->add("loop", "profile",
+           std::bind(&LoopInspector::profile, this, _1, _2),
+           "print profiles of loop iterations");
+  ins->add("loop", "profiling",
+           std::bind(&LoopInspector::profiling, this, _1, _2),
+           "profile loops, /loop/profiling/[on|off]/[slow callback ms]");
+}
+
+LoopInspector::~LoopInspector()
+{
+  inspector_->remove("loop", "profile");
+  inspector_->remove("loop", "profiling");
+}
+
+void LoopInspector::addLoop(const string& name, EventLoop* loop)
+{
+  MutexLockGuard lock(mutex_);
+  loops_.push_back(NamedLoop(name, loop));
+}
+
+void LoopInspector::addLoops(const string& name, const std::vector<EventLoop*>& loops)
+{
+  MutexLockGuard lock(mutex_);
+  for (size_t i = 0; i < loops.size(); ++i)
+  {
+    loops_.push_back(NamedLoop(name + "#" + std::to_string(i), loops[i]));
+  }
+}
+
+string LoopInspector::profile(HttpRequest::Method, const Inspector::ArgList&)
+{
+  string result;
+  MutexLockGuard lock(mutex_);
+  for (const NamedLoop& named : loops_)
+  {
+    const EventLoop* loop = named.second;
+    const EventLoop::Profile& p = loop->profile();
+    stringPrintf(&result, "%s: %s, %" PRId64 " iterations, %" PRId64 " slow callbacks, busy %.0f%%\n",
+                 named.first.c_str(), loop->profiling() ? "profiling" : "not profiling",
+                 loop->iteration(), p.slowCallbacks.load(std::memory_order_relaxed),
+                 loop->busyRatio() * 100);
+    result += "                            COUNT        AVG      P50      P99     P999        MAX\n";
+    printHistogram(&result, "poll_wait_us", p.pollWait);
+    printHistogram(&result, "active_channels", p.activeChannels);
+    printHistogram(&result, "event_handling_us", p.eventHandling);
+    printHistogram(&result, "pending_functors_us", p.pendingFunctors);
+    printHistogram(&result, "timer_callback_us", p.timerCallbacks);
+    result += "\n";
+  }
+  return result;
+}
+
+string LoopInspector::profiling(HttpRequest::Method, const Inspector::ArgList& args)
+{
+  if (args.empty() || (args[0] != "on" && args[0] != "off"))
+  {
+    return "usage: /loop/profiling/[on|off]/[slow callback ms]\n";
+  }
+  const bool on = args[0] == "on";
+  const double slowSeconds = args.size() > 1 ? atof(args[1].c_str()) / 1000 : 0.0;
+  MutexLockGuard lock(mutex_);
+  for (const NamedLoop& named : loops_)
+  {
+    EventLoop* loop = named.second;
+    loop->runInLoop([loop, on, slowSeconds] { loop->setProfiling(on, slowSeconds); });
+  }
+  string result;
+  stringPrintf(&result, "profiling %s for %zd loops\n", on ? "on" : "off", loops_.size());
+  return result;
+}
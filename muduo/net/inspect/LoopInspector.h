@@ -0,0 +1,57 @@
+// Use of this source code is governed by a BSD-style license
+// that can be found in the License file.
+//
+// This is a public header file, it must only include public header files.
+
+#ifndef MUDUO_NET_INSPECT_LOOPINSPECTOR_H
+#define MUDUO_NET_INSPECT_LOOPINSPECTOR_H
+
+#include "muduo/base/Mutex.h"
+#include "muduo/net/inspect/Inspector.h"
+
+#include <utility>
+#include <vector>
+
+namespace muduo
+{
+namespace net
+{
+
+///
+/// Module "loop" of Inspector, profiles of EventLoop iterations,
+/// see EventLoop::setProfiling().
+///
+/// @code
+/// /loop/profile
+/// /loop/profiling/on/100    logs callbacks of 100ms or longer
+/// /loop/profiling/off
+/// @endcode
+///
+class LoopInspector : noncopyable
+{
+ public:
+  /// Adds commands to @c ins, which must outlive this.
+  explicit LoopInspector(Inspector* ins);
+  ~LoopInspector();
+
+  /// Thread safe. @c loop must outlive this.
+  void addLoop(const string& name, EventLoop* loop);
+  /// Adds loops as name#0, name#1 ..., eg. TcpServer::ioLoops().
+  void addLoops(const string& name, const std::vector<EventLoop*>& loops);
+
+  string profile(HttpRequest::Method, const Inspector::ArgList&);
+  /// args: on|off [slow callback milliseconds]
+  string profiling(HttpRequest::Method, const Inspector::ArgList&);
+
+ private:
+  typedef std::pair<string, EventLoop*> NamedLoop;
+
+  Inspector* inspector_;
+  MutexLock mutex_;
+  std::vector<NamedLoop> loops_ GUARDED_BY(mutex_);
+};
+
+}  // namespace net
+}  // namespace muduo
+
+#endif  // MUDUO_NET_INSPECT_LOOPINSPECTOR_H
@@ -10,6 +10,10 @@
 #include "muduo/net/inspect/ProcessInspector.h"
 #include "muduo/base/FileUtil.h"
 #include "muduo/base/ProcessInfo.h"
+
+#include <algorithm>
+#include <map>
+
 #include <limits.h>
 #include <stdio.h>
 #include <stdarg.h>
@@ -114,6 +118,34 @@ int stringPrintf(string* out, const char* fmt, ...)
   return ret;
 }
 
+// eg. "0-3,8"
+string cpuListString(const std::vector<int>& cpus)
+{
+  string result;
+  for (size_t i = 0; i < cpus.size(); )
+  {
+    size_t j = i;
+    while (j + 1 < cpus.size() && cpus[j + 1] == cpus[j] + 1)
+    {
+      ++j;
+    }
+    if (!result.empty())
+    {
+      result += ',';
+    }
+    if (j == i)
+    {
+      stringPrintf(&result, "%d", cpus[i]);
+    }
+    else
+    {
+      stringPrintf(&result, "%d-%d", cpus[i], cpus[j]);
+    }
+    i = j + 1;
+  }
+  return result;
+}
+
 }  // namespace inspect
 }  // namespace muduo
 
@@ -128,6 +160,7 @@ void ProcessInspector::registerCommands(Inspector* ins)
   ins->add("proc", "status", ProcessInspector::procStatus, "print /proc/self/status");
   // ins->add("proc", "opened_files", ProcessInspector::openedFiles, "count /proc/self/fd");
   ins->add("proc", "threads", ProcessInspector::threads, "list /proc/self/task");
+  ins->add("proc", "affinity", ProcessInspector::affinity, "list CPUs and NUMA nodes of threads");
 }
 
 string ProcessInspector::overview(HttpRequest::Method, const Inspector::ArgList&)
@@ -237,3 +270,45 @@ string ProcessInspector::threads(HttpRequest::Method, const Inspector::ArgList&)
   return result;
 }
 
+string ProcessInspector::affinity(HttpRequest::Method, const Inspector::ArgList&)
+{
+  std::vector<pid_t> threads = ProcessInfo::threads();
+  string result = "  TID NAME             NODES    CPUS\n";
+  result.reserve(threads.size() * 64);
+  string comm;
+  std::map<int, int> nodeOfCpu;  // scanning /sys is slow
+  for (pid_t tid : threads)
+  {
+    char buf[256];
+    snprintf(buf, sizeof buf, "/proc/%d/task/%d/comm", ProcessInfo::pid(), tid);
+    if (FileUtil::readFile(buf, 64, &comm) != 0)
+    {
+      continue;
+    }
+    if (!comm.empty() && comm.back() == '\n')
+    {
+      comm.pop_back();
+    }
+    std::vector<int> cpus = ProcessInfo::cpuAffinity(tid);
+    std::vector<int> nodes;
+    for (int cpu : cpus)
+    {
+      std::map<int, int>::iterator it = nodeOfCpu.find(cpu);
+      if (it == nodeOfCpu.end())
+      {
+        it = nodeOfCpu.insert(std::make_pair(cpu, ProcessInfo::numaNodeOfCpu(cpu))).first;
+      }
+      int node = it->second;
+      if (node >= 0 && std::find(nodes.begin(), nodes.end(), node) == nodes.end())
+      {
+        nodes.push_back(node);
+      }
+    }
+    std::sort(nodes.begin(), nodes.end());
+    snprintf(buf, sizeof buf, "%5d %-16s %-8s %s\n",
+             tid, comm.c_str(), cpuListString(nodes).c_str(), cpuListString(cpus).c_str());
+    result += buf;
+  }
+  return result;
+}
+
@@ -1,6 +1,9 @@
+#include "muduo/net/inspect/ConnectionInspector.h"
 #include "muduo/net/inspect/Inspector.h"
+#include "muduo/net/inspect/LoopInspector.h"
 #include "muduo/net/EventLoop.h"
 #include "muduo/net/EventLoopThread.h"
+#include "muduo/net/TcpServer.h"
 
 using namespace muduo;
 using namespace muduo::net;
@@ -10,6 +13,19 @@ int main()
   EventLoop loop;
   EventLoopThread t;
   Inspector ins(t.startLoop(), InetAddress(12345), "test");
+
+  // echo server on port 12346, see /conn/top
+  TcpServer server(&loop, InetAddress(12346), "echo");
+  server.setThreadNum(2);
+  server.setMessageCallback([](const TcpConnectionPtr& conn, Buffer* buf, Timestamp) {
+    conn->send(buf);
+  });
+  server.start();
+  ConnectionInspector conns(&ins);
+  conns.addServer(&server);
+  // see /loop/profile after /loop/profiling/on
+  LoopInspector loops(&ins);
+  loops.addLoop("base", &loop);
+  loops.addLoops("echo", server.ioLoops());
   loop.loop();
 }
-
@@ -7,8 +7,10 @@
 // Author: Shuo Chen (chenshuo at chenshuo dot com)
 
 #include "muduo/net/Poller.h"
+#include "muduo/base/Logging.h"
 #include "muduo/net/poller/PollPoller.h"
 #include "muduo/net/poller/EPollPoller.h"
+#include "muduo/net/poller/IoUringPoller.h"
 
 #include <stdlib.h>
 
@@ -20,6 +22,16 @@ Poller* Poller::newDefaultPoller(EventLoop* loop)
   {
     return new PollPoller(loop);
   }
+  else if (::getenv("MUDUO_USE_IO_URING"))
+  {
+    static const bool supported = IoUringPoller::isSupported();
+    if (supported)
+    {
+      return new IoUringPoller(loop);
+    }
+    LOG_WARN << "io_uring is not supported, use epoll";
+    return new EPollPoller(loop);
+  }
   else
   {
     return new EPollPoller(loop);
@@ -11,6 +11,8 @@
 #include "muduo/base/Logging.h"
 #include "muduo/net/Channel.h"
 
+#include <algorithm>
+
 #include <assert.h>
 #include <errno.h>
 #include <poll.h>
@@ -31,9 +33,26 @@ static_assert(EPOLLHUP == POLLHUP,      "epoll uses same flag values as poll");
 
 namespace
 {
+// not known to the poller
 const int kNew = -1;
+// registered with epoll_ctl
 const int kAdded = 1;
+// known to the poller, but not registered
 const int kDeleted = 2;
+
+uint32_t epollEvents(const Channel* channel)
+{
+  if (channel->isNoneEvent())
+  {
+    return 0;
+  }
+  uint32_t events = static_cast<uint32_t>(channel->events());
+  if (channel->isEdgeTriggered())
+  {
+    events |= EPOLLET;
+  }
+  return events;
+}
 }
 
 EPollPoller::EPollPoller(EventLoop* loop)
@@ -55,6 +74,7 @@ EPollPoller::~EPollPoller()
 Timestamp EPollPoller::poll(int timeoutMs, ChannelList* activeChannels)
 {
   LOG_TRACE << "fd total count " << channels_.size();
+  applyUpdates();
   int numEvents = ::epoll_wait(epollfd_,
                                &*events_.begin(),
                                static_cast<int>(events_.size()),
@@ -110,41 +130,27 @@ void EPollPoller::updateChannel(Channel* channel)
   const int index = channel->index();
   LOG_TRACE << "fd = " << channel->fd()
     << " events = " << channel->events() << " index = " << index;
-  if (index == kNew || index == kDeleted)
+  int fd = channel->fd();
+  (void)fd;
+  if (index == kNew)
   {
-    // a new one, add with EPOLL_CTL_ADD
-    int fd = channel->fd();
-    if (index == kNew)
-    {
-      assert(channels_.find(fd) == channels_.end());
-      channels_[fd] = channel;
-    }
-    else // index == kDeleted
-    {
-      assert(channels_.find(fd) != channels_.end());
-      assert(channels_[fd] == channel);
-    }
-
-    channel->set_index(kAdded);
-    update(EPOLL_CTL_ADD, channel);
+    assert(channels_.find(fd) == channels_.end());
+    channels_[fd] = channel;
+    channel->set_index(kDeleted);
+    channel->set_registeredEvents(0);
   }
   else
   {
-    // update existing one with EPOLL_CTL_MOD/DEL
-    int fd = channel->fd();
-    (void)fd;
     assert(channels_.find(fd) != channels_.end());
     assert(channels_[fd] == channel);
-    assert(index == kAdded);
-    if (channel->isNoneEvent())
-    {
-      update(EPOLL_CTL_DEL, channel);
-      channel->set_index(kDeleted);
-    }
-    else
-    {
-      update(EPOLL_CTL_MOD, channel);
-    }
+    assert(index == kAdded || index == kDeleted);
+  }
+
+  // applied by applyUpdates() before next epoll_wait
+  if (!channel->isDirty())
+  {
+    channel->set_dirty(true);
+    dirtyChannels_.push_back(channel);
   }
 }
 
@@ -162,6 +168,13 @@ void EPollPoller::removeChannel(Channel* channel)
   (void)n;
   assert(n == 1);
 
+  if (channel->isDirty())
+  {
+    // the Channel may be gone before next poll()
+    dirtyChannels_.erase(std::find(dirtyChannels_.begin(), dirtyChannels_.end(), channel));
+    channel->set_dirty(false);
+  }
+  // before the fd is closed
   if (index == kAdded)
   {
     update(EPOLL_CTL_DEL, channel);
@@ -169,11 +182,41 @@ void EPollPoller::removeChannel(Channel* channel)
   channel->set_index(kNew);
 }
 
+void EPollPoller::applyUpdates()
+{
+  for (Channel* channel : dirtyChannels_)
+  {
+    assert(channel->isDirty());
+    channel->set_dirty(false);
+    const uint32_t events = epollEvents(channel);
+    if (channel->index() == kAdded)
+    {
+      if (events == 0)
+      {
+        update(EPOLL_CTL_DEL, channel);
+        channel->set_index(kDeleted);
+      }
+      else if (events != static_cast<uint32_t>(channel->registeredEvents()))
+      {
+        update(EPOLL_CTL_MOD, channel);
+      }
+    }
+    else if (events != 0)
+    {
+      assert(channel->index() == kDeleted);
+      update(EPOLL_CTL_ADD, channel);
+      channel->set_index(kAdded);
+    }
+    channel->set_registeredEvents(static_cast<int>(events));
+  }
+  dirtyChannels_.clear();
+}
+
 void EPollPoller::update(int operation, Channel* channel)
 {
   struct epoll_event event;
   memZero(&event, sizeof event);
-  event.events = channel->events();
+  event.events = epollEvents(channel);
   event.data.ptr = channel;
   int fd = channel->fd();
   LOG_TRACE << "epoll_ctl op = " << operationToString(operation)
@@ -0,0 +1,886 @@
+// Use of this source code is governed by a BSD-style license
+// that can be found in the License file.
+
+#include "muduo/net/poller/IoUringPoller.h"
+
+#include "muduo/base/Logging.h"
+#include "muduo/net/Buffer.h"
+#include "muduo/net/BufferChain.h"
+#include "muduo/net/Channel.h"
+
+#include <algorithm>
+#include <deque>
+
+#include <assert.h>
+#include <errno.h>
+#include <linux/io_uring.h>
+#include <poll.h>
+#include <signal.h>
+#include <stdlib.h>
+#include <sys/mman.h>
+#include <sys/socket.h>
+#include <sys/syscall.h>
+#include <sys/uio.h>
+#include <unistd.h>
+
+using namespace muduo;
+using namespace muduo::net;
+
+// FIXME: poll32_events needs swapping on big endian.
+static_assert(__BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__, "poll32_events is little endian");
+
+namespace
+{
+const int kNew = -1;
+const int kAdded = 1;
+const int kDeleted = 2;
+
+// user_data of requests whose completion is ignored
+const uint64_t kIgnored = 0;
+// user_data of poll requests, others point to a Request
+const uint64_t kPollTag = 1ULL << 63;
+const uint32_t kMaxGeneration = 1U << 31;
+
+// provided buffer group of multishot recv
+const uint16_t kBufferGroup = 0;
+
+int io_uring_setup(unsigned entries, struct io_uring_params* params)
+{
+  return static_cast<int>(::syscall(__NR_io_uring_setup, entries, params));
+}
+
+int io_uring_enter(int fd, unsigned toSubmit, unsigned minComplete,
+                   unsigned flags, const void* arg, size_t argSize)
+{
+  return static_cast<int>(::syscall(__NR_io_uring_enter, fd, toSubmit, minComplete,
+                                    flags, arg, argSize));
+}
+
+int io_uring_register(int fd, unsigned opcode, void* arg, unsigned nrArgs)
+{
+  return static_cast<int>(::syscall(__NR_io_uring_register, fd, opcode, arg, nrArgs));
+}
+
+uint64_t makeUserData(int fd, uint32_t generation)
+{
+  assert(generation < kMaxGeneration);
+  return kPollTag | (static_cast<uint64_t>(generation) << 32) | static_cast<uint32_t>(fd);
+}
+
+void* mapRing(int ringFd, size_t size, off_t offset)
+{
+  void* p = ::mmap(NULL, size, PROT_READ | PROT_WRITE,
+                   MAP_SHARED | MAP_POPULATE, ringFd, offset);
+  if (p == MAP_FAILED)
+  {
+    LOG_SYSFATAL << "IoUringPoller mmap";
+  }
+  return p;
+}
+
+// multishot recv came in 6.0, along with IORING_OP_SEND_ZC
+bool supportsMultishotRecv(int ringFd)
+{
+  const size_t size = sizeof(struct io_uring_probe) + 256 * sizeof(struct io_uring_probe_op);
+  std::vector<char> buf(size);
+  struct io_uring_probe* probe = reinterpret_cast<struct io_uring_probe*>(buf.data());
+  if (io_uring_register(ringFd, IORING_REGISTER_PROBE, probe, 256) < 0)
+  {
+    return false;
+  }
+  return probe->last_op >= IORING_OP_SEND_ZC
+      && (probe->ops[IORING_OP_SEND_ZC].flags & IO_URING_OP_SUPPORTED);
+}
+
+}  // namespace
+
+const int IoUringPoller::kNumRecvBuffers;
+const size_t IoUringPoller::kRecvBufferSize;
+const unsigned IoUringPoller::kRingEntries;
+
+struct IoUringPoller::Request
+{
+  enum Kind { kRecv, kAccept, kWrite };
+
+  Request(Kind k, int f, uint32_t e)
+    : kind(k), fd(f), epoch(e), inFlight(false)
+  {
+  }
+
+  const Kind kind;
+  const int fd;
+  const uint32_t epoch;  // of the fd when created
+  bool inFlight;
+  std::shared_ptr<void> owner;  // of the memory being written
+  struct msghdr msg;
+  struct iovec vec[BufferChain::kMaxIovecs];
+};
+
+// completion based I/O of one fd
+struct IoUringPoller::IoState
+{
+  explicit IoState(Request::Kind k)
+    : kind(k),
+      buffer(NULL),
+      request(NULL),
+      stopped(false),
+      received(0),
+      eof(false),
+      error(0),
+      writeRequest(NULL),
+      written(false),
+      writeResult(0)
+  {
+  }
+
+  const Request::Kind kind;  // kRecv or kAccept
+  Buffer* buffer;  // for kRecv
+  Request* request;  // multishot recv or accept, NULL if not armed
+  bool stopped;  // by EOF or error
+  size_t received;
+  bool eof;
+  int error;
+  std::deque<int> accepted;
+  Request* writeRequest;  // reused
+  bool written;
+  ssize_t writeResult;  // or -errno
+};
+
+bool IoUringPoller::isSupported()
+{
+  struct io_uring_params params;
+  memZero(&params, sizeof params);
+  int fd = io_uring_setup(1, &params);
+  if (fd < 0)
+  {
+    return false;
+  }
+  ::close(fd);
+  // IORING_FEAT_RSRC_TAGS came in 5.13 with multishot poll
+  return (params.features & IORING_FEAT_EXT_ARG)
+      && (params.features & IORING_FEAT_RSRC_TAGS);
+}
+
+IoUringPoller::IoUringPoller(EventLoop* loop)
+  : Poller(loop),
+    ringFd_(-1),
+    sqRing_(NULL),
+    sqRingSize_(0),
+    cqRing_(NULL),
+    cqRingSize_(0),
+    sqes_(NULL),
+    sqesSize_(0),
+    localSqTail_(0),
+    nextGeneration_(1),
+    bufferRing_(NULL),
+    recvBuffers_(NULL)
+{
+  struct io_uring_params params;
+  memZero(&params, sizeof params);
+  ringFd_ = io_uring_setup(kRingEntries, &params);
+  if (ringFd_ < 0)
+  {
+    LOG_SYSFATAL << "IoUringPoller::IoUringPoller";
+  }
+
+  sqRingSize_ = params.sq_off.array + params.sq_entries * sizeof(unsigned);
+  cqRingSize_ = params.cq_off.cqes + params.cq_entries * sizeof(struct io_uring_cqe);
+  const bool singleMmap = params.features & IORING_FEAT_SINGLE_MMAP;
+  if (singleMmap)
+  {
+    sqRingSize_ = cqRingSize_ = std::max(sqRingSize_, cqRingSize_);
+  }
+  sqRing_ = mapRing(ringFd_, sqRingSize_, IORING_OFF_SQ_RING);
+  cqRing_ = singleMmap ? sqRing_ : mapRing(ringFd_, cqRingSize_, IORING_OFF_CQ_RING);
+  sqesSize_ = params.sq_entries * sizeof(struct io_uring_sqe);
+  sqes_ = static_cast<struct io_uring_sqe*>(mapRing(ringFd_, sqesSize_, IORING_OFF_SQES));
+
+  char* sq = static_cast<char*>(sqRing_);
+  sqHead_ = reinterpret_cast<unsigned*>(sq + params.sq_off.head);
+  sqTail_ = reinterpret_cast<unsigned*>(sq + params.sq_off.tail);
+  sqArray_ = reinterpret_cast<unsigned*>(sq + params.sq_off.array);
+  sqMask_ = *reinterpret_cast<unsigned*>(sq + params.sq_off.ring_mask);
+  sqEntries_ = params.sq_entries;
+  char* cq = static_cast<char*>(cqRing_);
+  cqHead_ = reinterpret_cast<unsigned*>(cq + params.cq_off.head);
+  cqTail_ = reinterpret_cast<unsigned*>(cq + params.cq_off.tail);
+  cqMask_ = *reinterpret_cast<unsigned*>(cq + params.cq_off.ring_mask);
+  cqes_ = reinterpret_cast<struct io_uring_cqe*>(cq + params.cq_off.cqes);
+  localSqTail_ = *sqTail_;
+
+  if (::getenv("MUDUO_IO_URING_COMPLETION"))
+  {
+    setupBufferRing();
+  }
+}
+
+IoUringPoller::~IoUringPoller()
+{
+  for (Request* request : requests_)
+  {
+    delete request;
+  }
+  for (PollState& state : states_)
+  {
+    delete state.io;
+  }
+  ::close(ringFd_);
+  if (bufferRing_)
+  {
+    ::munmap(recvBuffers_, kNumRecvBuffers * kRecvBufferSize);
+    ::munmap(bufferRing_, kNumRecvBuffers * sizeof(struct io_uring_buf));
+  }
+  ::munmap(sqes_, sqesSize_);
+  if (cqRing_ != sqRing_)
+  {
+    ::munmap(cqRing_, cqRingSize_);
+  }
+  ::munmap(sqRing_, sqRingSize_);
+}
+
+void IoUringPoller::setupBufferRing()
+{
+  static_assert((kNumRecvBuffers & (kNumRecvBuffers - 1)) == 0, "ring size must be power of 2");
+  if (!supportsMultishotRecv(ringFd_))
+  {
+    LOG_WARN << "io_uring multishot recv is not supported, poll only";
+    return;
+  }
+  const size_t ringBytes = kNumRecvBuffers * sizeof(struct io_uring_buf);
+  void* ring = ::mmap(NULL, ringBytes, PROT_READ | PROT_WRITE,
+                      MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+  if (ring == MAP_FAILED)
+  {
+    LOG_SYSERR << "IoUringPoller::setupBufferRing";
+    return;
+  }
+  struct io_uring_buf_reg reg;
+  memZero(&reg, sizeof reg);
+  reg.ring_addr = reinterpret_cast<uint64_t>(ring);
+  reg.ring_entries = kNumRecvBuffers;
+  reg.bgid = kBufferGroup;
+  if (io_uring_register(ringFd_, IORING_REGISTER_PBUF_RING, &reg, 1) < 0)
+  {
+    LOG_SYSERR << "IoUringPoller::setupBufferRing";
+    ::munmap(ring, ringBytes);
+    return;
+  }
+  // pages are touched when used
+  void* buffers = ::mmap(NULL, kNumRecvBuffers * kRecvBufferSize, PROT_READ | PROT_WRITE,
+                         MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+  if (buffers == MAP_FAILED)
+  {
+    LOG_SYSFATAL << "IoUringPoller::setupBufferRing";
+  }
+  bufferRing_ = static_cast<struct io_uring_buf*>(ring);
+  recvBuffers_ = static_cast<char*>(buffers);
+  for (int bid = 0; bid < kNumRecvBuffers; ++bid)
+  {
+    recycleBuffer(bid);
+  }
+}
+
+void IoUringPoller::recycleBuffer(int bid)
+{
+  // struct io_uring_buf_ring has an empty struct member, which is not
+  // empty in C++, so the tail is taken as it is laid out in C.
+  uint16_t* tailp = &bufferRing_[0].resv;
+  const uint16_t tail = *tailp;  // only we write it
+  struct io_uring_buf* buf = &bufferRing_[tail & (kNumRecvBuffers - 1)];
+  buf->addr = reinterpret_cast<uint64_t>(recvBuffers_ + static_cast<size_t>(bid) * kRecvBufferSize);
+  buf->len = static_cast<uint32_t>(kRecvBufferSize);
+  buf->bid = static_cast<uint16_t>(bid);
+  __atomic_store_n(tailp, static_cast<uint16_t>(tail + 1), __ATOMIC_RELEASE);
+}
+
+Timestamp IoUringPoller::poll(int timeoutMs, ChannelList* activeChannels)
+{
+  LOG_TRACE << "fd total count " << channels_.size();
+  // oneshot polls fired last time, unless updated since
+  for (int fd : rearms_)
+  {
+    PollState& state = stateOf(fd);
+    if (state.channel && state.channel->index() == kAdded)
+    {
+      if (!state.armed)
+      {
+        arm(state.channel);
+      }
+      updateIo(fd);
+    }
+  }
+  rearms_.clear();
+
+  // don't wait if some results are left from last time
+  int n = submit(firedFds_.empty() ? 1 : 0, timeoutMs);
+  int savedErrno = errno;
+  Timestamp now(Timestamp::now());
+  fillActiveChannels(activeChannels);
+  if (!activeChannels->empty())
+  {
+    LOG_TRACE << activeChannels->size() << " events happened";
+  }
+  else if (n >= 0 || savedErrno == ETIME)
+  {
+    LOG_TRACE << "nothing happened";
+  }
+  else if (savedErrno != EINTR)
+  {
+    // error happens, log uncommon ones
+    errno = savedErrno;
+    LOG_SYSERR << "IoUringPoller::poll()";
+  }
+  return now;
+}
+
+void IoUringPoller::fillActiveChannels(ChannelList* activeChannels)
+{
+  unsigned head = *cqHead_;
+  const unsigned tail = __atomic_load_n(cqTail_, __ATOMIC_ACQUIRE);
+  for (; head != tail; ++head)
+  {
+    const struct io_uring_cqe* cqe = &cqes_[head & cqMask_];
+    if (cqe->user_data == kIgnored)
+    {
+      continue;
+    }
+    if (!(cqe->user_data & kPollTag))
+    {
+      handleCompletion(reinterpret_cast<Request*>(cqe->user_data), cqe->res, cqe->flags);
+      continue;
+    }
+    const int fd = static_cast<int>(cqe->user_data & 0xFFFFFFFF);
+    const uint32_t generation = static_cast<uint32_t>(cqe->user_data >> 32) & (kMaxGeneration - 1);
+    PollState& state = stateOf(fd);
+    if (state.generation != generation || !state.armed)
+    {
+      // the poll was removed or replaced after this completion
+      continue;
+    }
+    if (cqe->res < 0)
+    {
+      errno = -cqe->res;
+      LOG_SYSERR << "IoUringPoller poll fd = " << fd;
+      state.armed = false;
+      continue;
+    }
+    if (!(cqe->flags & IORING_CQE_F_MORE))
+    {
+      state.armed = false;
+      rearms_.push_back(fd);
+    }
+    if (cqe->res != 0)
+    {
+      activate(fd, cqe->res);
+    }
+  }
+  __atomic_store_n(cqHead_, head, __ATOMIC_RELEASE);
+
+  // one entry per channel, even with many completions
+  for (int fd : firedFds_)
+  {
+    PollState& state = stateOf(fd);
+    if (state.channel && state.revents != 0)
+    {
+      state.channel->set_revents(state.revents);
+      state.revents = 0;
+      activeChannels->push_back(state.channel);
+    }
+  }
+  firedFds_.clear();
+  // may destroy connections already removed
+  finishedOwners_.clear();
+}
+
+void IoUringPoller::activate(int fd, int revents)
+{
+  PollState& state = stateOf(fd);
+  if (state.revents == 0)
+  {
+    firedFds_.push_back(fd);
+  }
+  state.revents |= revents;
+}
+
+void IoUringPoller::handleCompletion(Request* request, int res, uint32_t flags)
+{
+  const int fd = request->fd;
+  PollState& state = stateOf(fd);
+  // NULL if the channel was removed
+  IoState* io = state.epoch == request->epoch ? state.io : NULL;
+  // results of a canceled request on the way are kept, and made active
+  // by updateIo() when reading again
+  const bool reading = io && state.channel && state.channel->isReading();
+  switch (request->kind)
+  {
+    case Request::kRecv:
+      if (flags & IORING_CQE_F_BUFFER)
+      {
+        const int bid = static_cast<int>(flags >> IORING_CQE_BUFFER_SHIFT);
+        if (io && res > 0)
+        {
+          io->buffer->append(recvBuffers_ + static_cast<size_t>(bid) * kRecvBufferSize,
+                             static_cast<size_t>(res));
+          io->received += static_cast<size_t>(res);
+          if (reading)
+          {
+            activate(fd, POLLIN);
+          }
+        }
+        recycleBuffer(bid);
+      }
+      else if (io && res == 0)
+      {
+        io->eof = true;
+        if (reading)
+        {
+          activate(fd, POLLIN);
+        }
+      }
+      else if (io && res < 0 && res != -ECANCELED && res != -ENOBUFS)
+      {
+        io->error = -res;
+        if (reading)
+        {
+          activate(fd, POLLIN);
+        }
+      }
+      break;
+    case Request::kAccept:
+      if (res >= 0 && io)
+      {
+        io->accepted.push_back(res);
+        if (reading)
+        {
+          activate(fd, POLLIN);
+        }
+      }
+      else if (res >= 0)
+      {
+        ::close(res);
+      }
+      else if (io && res != -ECANCELED)
+      {
+        io->error = -res;
+        if (reading)
+        {
+          activate(fd, POLLIN);
+        }
+      }
+      break;
+    case Request::kWrite:
+      request->inFlight = false;
+      finishedOwners_.push_back(std::move(request->owner));
+      if (io)
+      {
+        io->written = true;
+        io->writeResult = res;
+        activate(fd, POLLOUT);
+      }
+      else
+      {
+        requests_.erase(request);
+        delete request;
+      }
+      return;
+  }
+
+  if (!(flags & IORING_CQE_F_MORE))
+  {
+    if (io && io->request == request)
+    {
+      // a multishot request ends on errors, or when out of buffers
+      io->request = NULL;
+      if (res == 0 || res == -ECANCELED
+          || (request->kind == Request::kRecv && res < 0 && res != -ENOBUFS))
+      {
+        io->stopped = true;
+      }
+      else
+      {
+        rearms_.push_back(fd);
+      }
+    }
+    requests_.erase(request);
+    delete request;
+  }
+}
+
+void IoUringPoller::updateChannel(Channel* channel)
+{
+  Poller::assertInLoopThread();
+  const int index = channel->index();
+  const int fd = channel->fd();
+  LOG_TRACE << "fd = " << fd
+    << " events = " << channel->events() << " index = " << index;
+  if (index == kNew || index == kDeleted)
+  {
+    if (index == kNew)
+    {
+      assert(channels_.find(fd) == channels_.end());
+      channels_[fd] = channel;
+      stateOf(fd).channel = channel;
+    }
+    else // index == kDeleted
+    {
+      assert(channels_.find(fd) != channels_.end());
+      assert(channels_[fd] == channel);
+    }
+    if (channel->isNoneEvent())
+    {
+      channel->set_index(kDeleted);
+    }
+    else
+    {
+      channel->set_index(kAdded);
+      arm(channel);
+    }
+  }
+  else
+  {
+    assert(channels_.find(fd) != channels_.end());
+    assert(channels_[fd] == channel);
+    assert(index == kAdded);
+    disarm(fd);
+    if (channel->isNoneEvent())
+    {
+      channel->set_index(kDeleted);
+    }
+    else
+    {
+      arm(channel);
+    }
+  }
+  updateIo(fd);
+}
+
+void IoUringPoller::removeChannel(Channel* channel)
+{
+  Poller::assertInLoopThread();
+  int fd = channel->fd();
+  LOG_TRACE << "fd = " << fd;
+  assert(channels_.find(fd) != channels_.end());
+  assert(channels_[fd] == channel);
+  assert(channel->isNoneEvent());
+  int index = channel->index();
+  assert(index == kAdded || index == kDeleted);
+  size_t n = channels_.erase(fd);
+  (void)n;
+  assert(n == 1);
+
+  if (index == kAdded)
+  {
+    disarm(fd);
+  }
+  PollState& state = stateOf(fd);
+  if (IoState* io = state.io)
+  {
+    // results not taken are dropped
+    if (io->request)
+    {
+      cancel(io->request);
+    }
+    for (int connfd : io->accepted)
+    {
+      ::close(connfd);
+    }
+    if (Request* request = io->writeRequest)
+    {
+      if (request->inFlight)
+      {
+        cancel(request);
+      }
+      else
+      {
+        requests_.erase(request);
+        delete request;
+      }
+    }
+    delete io;
+    state.io = NULL;
+  }
+  // requests in flight are outdated
+  ++state.epoch;
+  state.channel = NULL;
+  state.revents = 0;
+  channel->set_index(kNew);
+  if (pendingSqes() > 0)
+  {
+    // an armed request holds the file, which must go before the fd is closed
+    submit(0, 0);
+  }
+}
+
+IoUringPoller::PollState& IoUringPoller::stateOf(int fd)
+{
+  assert(fd >= 0);
+  const size_t index = static_cast<size_t>(fd);
+  if (index >= states_.size())
+  {
+    PollState empty = { NULL, 0, false, 0, 0, NULL };
+    states_.resize(std::max(index + 1, states_.size() * 2), empty);
+  }
+  return states_[index];
+}
+
+void IoUringPoller::arm(Channel* channel)
+{
+  const int fd = channel->fd();
+  PollState& state = stateOf(fd);
+  state.channel = channel;
+  int events = channel->events();
+  if (state.io)
+  {
+    // read by recv or accept
+    events &= ~(POLLIN | POLLPRI);
+  }
+  if (events == 0)
+  {
+    return;
+  }
+  struct io_uring_sqe* sqe = getSqe();
+  state.generation = nextGeneration_;
+  if (++nextGeneration_ == kMaxGeneration)
+  {
+    nextGeneration_ = 1;
+  }
+  state.armed = true;
+  sqe->opcode = IORING_OP_POLL_ADD;
+  sqe->fd = fd;
+  sqe->poll32_events = static_cast<uint32_t>(events);
+  if (channel->isEdgeTriggered())
+  {
+    // stays armed, and reports new events only
+    sqe->len = IORING_POLL_ADD_MULTI;
+  }
+  sqe->user_data = makeUserData(fd, state.generation);
+}
+
+void IoUringPoller::disarm(int fd)
+{
+  PollState& state = stateOf(fd);
+  if (state.armed)
+  {
+    struct io_uring_sqe* sqe = getSqe();
+    sqe->opcode = IORING_OP_POLL_REMOVE;
+    sqe->fd = -1;
+    sqe->addr = makeUserData(fd, state.generation);
+    sqe->user_data = kIgnored;
+    state.armed = false;
+  }
+}
+
+void IoUringPoller::updateIo(int fd)
+{
+  PollState& state = stateOf(fd);
+  IoState* io = state.io;
+  if (io == NULL)
+  {
+    return;
+  }
+  const bool reading = state.channel && state.channel->isReading();
+  if (reading && io->request == NULL && !io->stopped)
+  {
+    Request* request = new Request(io->kind, fd, state.epoch);
+    request->inFlight = true;
+    requests_.insert(request);
+    io->request = request;
+    struct io_uring_sqe* sqe = getSqe();
+    sqe->fd = fd;
+    if (io->kind == Request::kRecv)
+    {
+      sqe->opcode = IORING_OP_RECV;
+      sqe->ioprio = IORING_RECV_MULTISHOT;
+      sqe->flags = IOSQE_BUFFER_SELECT;
+      sqe->buf_group = kBufferGroup;
+    }
+    else
+    {
+      sqe->opcode = IORING_OP_ACCEPT;
+      sqe->ioprio = IORING_ACCEPT_MULTISHOT;
+      sqe->accept_flags = SOCK_NONBLOCK | SOCK_CLOEXEC;
+    }
+    sqe->user_data = reinterpret_cast<uint64_t>(request);
+  }
+  else if (!reading && io->request)
+  {
+    // results on the way are still taken
+    cancel(io->request);
+    io->request = NULL;
+  }
+
+  if (reading && (io->received > 0 || io->eof || io->error || !io->accepted.empty()))
+  {
+    // left when reading was stopped
+    activate(fd, POLLIN);
+  }
+}
+
+void IoUringPoller::cancel(Request* request)
+{
+  struct io_uring_sqe* sqe = getSqe();
+  sqe->opcode = IORING_OP_ASYNC_CANCEL;
+  sqe->fd = -1;
+  sqe->addr = reinterpret_cast<uint64_t>(request);
+  sqe->user_data = kIgnored;
+}
+
+void IoUringPoller::setReceiveBuffer(Channel* channel, Buffer* buf)
+{
+  Poller::assertInLoopThread();
+  assert(completionEnabled());
+  assert(channel->index() == kNew);
+  PollState& state = stateOf(channel->fd());
+  assert(state.io == NULL);
+  state.io = new IoState(Request::kRecv);
+  state.io->buffer = buf;
+}
+
+ssize_t IoUringPoller::takeReceived(Channel* channel, int* savedErrno)
+{
+  Poller::assertInLoopThread();
+  IoState* io = stateOf(channel->fd()).io;
+  assert(io && io->kind == Request::kRecv);
+  if (io->received > 0)
+  {
+    ssize_t n = implicit_cast<ssize_t>(io->received);
+    io->received = 0;
+    return n;
+  }
+  else if (io->error)
+  {
+    *savedErrno = io->error;
+    io->error = 0;
+    return -1;
+  }
+  else if (io->eof)
+  {
+    return 0;
+  }
+  *savedErrno = EAGAIN;
+  return -1;
+}
+
+void IoUringPoller::setAccepting(Channel* channel)
+{
+  Poller::assertInLoopThread();
+  assert(completionEnabled());
+  assert(channel->index() == kNew);
+  PollState& state = stateOf(channel->fd());
+  assert(state.io == NULL);
+  state.io = new IoState(Request::kAccept);
+}
+
+int IoUringPoller::takeAccepted(Channel* channel, int* savedErrno)
+{
+  Poller::assertInLoopThread();
+  IoState* io = stateOf(channel->fd()).io;
+  assert(io && io->kind == Request::kAccept);
+  if (!io->accepted.empty())
+  {
+    int connfd = io->accepted.front();
+    io->accepted.pop_front();
+    return connfd;
+  }
+  *savedErrno = io->error ? io->error : EAGAIN;
+  io->error = 0;
+  return -1;
+}
+
+void IoUringPoller::startWrite(Channel* channel, const struct iovec* vec, int iovcnt,
+                               const std::shared_ptr<void>& owner)
+{
+  Poller::assertInLoopThread();
+  assert(iovcnt > 0 && iovcnt <= BufferChain::kMaxIovecs);
+  const int fd = channel->fd();
+  PollState& state = stateOf(fd);
+  IoState* io = state.io;
+  assert(io && io->kind == Request::kRecv);
+  Request* request = io->writeRequest;
+  if (request == NULL)
+  {
+    request = new Request(Request::kWrite, fd, state.epoch);
+    requests_.insert(request);
+    io->writeRequest = request;
+  }
+  assert(!request->inFlight && !io->written);
+  std::copy(vec, vec + iovcnt, request->vec);
+  memZero(&request->msg, sizeof request->msg);
+  request->msg.msg_iov = request->vec;
+  request->msg.msg_iovlen = static_cast<size_t>(iovcnt);
+  request->owner = owner;
+  request->inFlight = true;
+
+  struct io_uring_sqe* sqe = getSqe();
+  sqe->opcode = IORING_OP_SENDMSG;
+  sqe->fd = fd;
+  sqe->addr = reinterpret_cast<uint64_t>(&request->msg);
+  sqe->len = 1;
+  sqe->msg_flags = MSG_NOSIGNAL;
+  sqe->user_data = reinterpret_cast<uint64_t>(request);
+}
+
+bool IoUringPoller::takeWritten(Channel* channel, ssize_t* n, int* savedErrno)
+{
+  Poller::assertInLoopThread();
+  IoState* io = stateOf(channel->fd()).io;
+  if (io == NULL || !io->written)
+  {
+    return false;
+  }
+  io->written = false;
+  if (io->writeResult < 0)
+  {
+    *n = -1;
+    *savedErrno = static_cast<int>(-io->writeResult);
+  }
+  else
+  {
+    *n = io->writeResult;
+  }
+  return true;
+}
+
+unsigned IoUringPoller::pendingSqes() const
+{
+  return localSqTail_ - __atomic_load_n(sqHead_, __ATOMIC_ACQUIRE);
+}
+
+struct io_uring_sqe* IoUringPoller::getSqe()
+{
+  if (pendingSqes() >= sqEntries_)
+  {
+    if (submit(0, 0) < 0)
+    {
+      LOG_SYSFATAL << "IoUringPoller::getSqe";
+    }
+  }
+  const unsigned index = localSqTail_ & sqMask_;
+  struct io_uring_sqe* sqe = &sqes_[index];
+  memZero(sqe, sizeof *sqe);
+  sqArray_[index] = index;
+  ++localSqTail_;
+  return sqe;
+}
+
+int IoUringPoller::submit(unsigned waitNr, int timeoutMs)
+{
+  __atomic_store_n(sqTail_, localSqTail_, __ATOMIC_RELEASE);
+  unsigned flags = 0;
+  struct __kernel_timespec ts;
+  struct io_uring_getevents_arg arg;
+  memZero(&arg, sizeof arg);
+  if (waitNr > 0)
+  {
+    flags = IORING_ENTER_GETEVENTS | IORING_ENTER_EXT_ARG;
+    arg.sigmask_sz = _NSIG / 8;
+    if (timeoutMs >= 0)
+    {
+      ts.tv_sec = timeoutMs / 1000;
+      ts.tv_nsec = (timeoutMs % 1000) * 1000 * 1000;
+      arg.ts = reinterpret_cast<uint64_t>(&ts);
+    }
+  }
+  return io_uring_enter(ringFd_, pendingSqes(), waitNr, flags,
+                        waitNr > 0 ? &arg : NULL, waitNr > 0 ? sizeof arg : 0);
+}
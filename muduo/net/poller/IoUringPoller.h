@@ -0,0 +1,151 @@
+// Use of this source code is governed by a BSD-style license
+// that can be found in the License file.
+//
+// This is an internal header file, you should not include this.
+
+#ifndef MUDUO_NET_POLLER_IOURINGPOLLER_H
+#define MUDUO_NET_POLLER_IOURINGPOLLER_H
+
+#include "muduo/net/Poller.h"
+
+#include <memory>
+#include <set>
+#include <vector>
+
+struct io_uring_sqe;
+struct io_uring_cqe;
+struct io_uring_buf;
+struct iovec;
+
+namespace muduo
+{
+namespace net
+{
+
+class Buffer;
+
+///
+/// IO Multiplexing with IORING_OP_POLL_ADD of io_uring(7).
+///
+/// Registration changes are queued in the submission ring and submitted
+/// with the next wait, so Channel::update() costs no syscall.
+///
+/// A poll request is oneshot and re-armed after each event, which keeps
+/// poll(2) level-triggered semantics. Edge triggered channels use a
+/// multishot request instead, which stays armed.
+///
+/// With MUDUO_IO_URING_COMPLETION set, TcpConnection and Acceptor do
+/// completion based I/O as well, see EventLoop::ioUring(). A reading
+/// channel then has a multishot recv or accept instead of a poll for
+/// POLLIN, writes are submitted with IORING_OP_SENDMSG. Results are
+/// kept here, and the channel is made active with POLLIN or POLLOUT,
+/// so its handlers take them and run the usual callbacks.
+///
+class IoUringPoller : public Poller
+{
+ public:
+  /// Provided buffers for multishot recv, copied to Buffer on completion.
+  static const int kNumRecvBuffers = 256;
+  static const size_t kRecvBufferSize = 16*1024;
+
+  IoUringPoller(EventLoop* loop);
+  ~IoUringPoller() override;
+
+  /// Whether the kernel supports what we need, Linux 5.11+.
+  static bool isSupported();
+
+  Timestamp poll(int timeoutMs, ChannelList* activeChannels) override;
+  void updateChannel(Channel* channel) override;
+  void removeChannel(Channel* channel) override;
+
+  /// Completion based I/O is asked for and supported, Linux 6.0+.
+  bool completionEnabled() const { return bufferRing_ != NULL; }
+
+  /// Receives into @c buf while @c channel is reading,
+  /// until the channel is removed.
+  /// Call it before enableReading().
+  void setReceiveBuffer(Channel* channel, Buffer* buf);
+  /// Like read(2) on data received into the Buffer since last call,
+  /// -1 with EAGAIN if nothing new.
+  ssize_t takeReceived(Channel* channel, int* savedErrno);
+
+  /// Accepts connections while @c channel is reading.
+  /// Call it before enableReading().
+  void setAccepting(Channel* channel);
+  /// Returns an accepted non-blocking socket, or -1,
+  /// with EAGAIN if nothing new.
+  int takeAccepted(Channel* channel, int* savedErrno);
+
+  /// Sends @c vec with IORING_OP_SENDMSG, @c owner keeps the memory alive
+  /// until completion, which makes @c channel active with POLLOUT.
+  /// One write at a time, needs setReceiveBuffer().
+  void startWrite(Channel* channel, const struct iovec* vec, int iovcnt,
+                  const std::shared_ptr<void>& owner);
+  /// Result of the finished write, like writev(2),
+  /// returns false if it is not finished.
+  bool takeWritten(Channel* channel, ssize_t* n, int* savedErrno);
+
+ private:
+  static const unsigned kRingEntries = 1024;
+
+  struct Request;
+  struct IoState;
+
+  struct PollState
+  {
+    Channel* channel;
+    uint32_t generation;  // of the current poll request
+    bool armed;
+    int revents;  // collected in one poll()
+    uint32_t epoch;  // bumped on removal, outdates requests
+    IoState* io;  // NULL without completion based I/O
+  };
+
+  PollState& stateOf(int fd);
+  void arm(Channel* channel);
+  void disarm(int fd);
+  void updateIo(int fd);
+  void cancel(Request* request);
+  void activate(int fd, int revents);
+  void handleCompletion(Request* request, int res, uint32_t flags);
+  void setupBufferRing();
+  void recycleBuffer(int bid);
+  struct io_uring_sqe* getSqe();
+  unsigned pendingSqes() const;
+  int submit(unsigned waitNr, int timeoutMs);
+  void fillActiveChannels(ChannelList* activeChannels);
+
+  int ringFd_;
+  void* sqRing_;
+  size_t sqRingSize_;
+  void* cqRing_;
+  size_t cqRingSize_;
+  struct io_uring_sqe* sqes_;
+  size_t sqesSize_;
+
+  unsigned* sqHead_;
+  unsigned* sqTail_;
+  unsigned* sqArray_;
+  unsigned sqMask_;
+  unsigned sqEntries_;
+  unsigned* cqHead_;
+  unsigned* cqTail_;
+  unsigned cqMask_;
+  struct io_uring_cqe* cqes_;
+
+  unsigned localSqTail_;  // published to the kernel by submit()
+  uint32_t nextGeneration_;
+  std::vector<PollState> states_;  // indexed by fd
+  std::vector<int> rearms_;  // fds of fired oneshot polls
+  std::vector<int> firedFds_;  // active before next poll()
+
+  // for completion based I/O
+  struct io_uring_buf* bufferRing_;  // provided buffers
+  char* recvBuffers_;
+  std::set<Request*> requests_;  // in flight, or kept for writing
+  std::vector<std::shared_ptr<void>> finishedOwners_;  // scratch
+};
+
+}  // namespace net
+}  // namespace muduo
+#endif  // MUDUO_NET_POLLER_IOURINGPOLLER_H
@@ -0,0 +1,289 @@
+#include "muduo/net/BufferChain.h"
+#include "muduo/net/SocketsOps.h"
+
+//#define BOOST_TEST_MODULE BufferChainTest
+#define BOOST_TEST_MAIN
+#define BOOST_TEST_DYN_LINK
+#include <boost/test/unit_test.hpp>
+
+#include <netinet/in.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+using muduo::string;
+using muduo::net::Buffer;
+using muduo::net::BufferChain;
+
+BOOST_AUTO_TEST_CASE(testBufferChainAppendRetrieve)
+{
+  BufferChain chain;
+  BOOST_CHECK(chain.empty());
+  BOOST_CHECK_EQUAL(chain.numSegments(), 0);
+
+  chain.append(string(200, 'x'));
+  chain.append(string(300, 'y'));
+  BOOST_CHECK_EQUAL(chain.readableBytes(), 500);
+  BOOST_CHECK_EQUAL(chain.numSegments(), 1);
+
+  chain.retrieve(250);
+  BOOST_CHECK_EQUAL(chain.readableBytes(), 250);
+  chain.retrieveAll();
+  BOOST_CHECK(chain.empty());
+  BOOST_CHECK_EQUAL(chain.numSegments(), 1);
+}
+
+BOOST_AUTO_TEST_CASE(testBufferChainNewSegment)
+{
+  BufferChain chain;
+  chain.append(string(BufferChain::kSegmentSize - 10, 'x'));
+  BOOST_CHECK_EQUAL(chain.numSegments(), 1);
+  chain.append(string(100, 'y'));
+  BOOST_CHECK_EQUAL(chain.numSegments(), 2);
+  BOOST_CHECK_EQUAL(chain.readableBytes(), BufferChain::kSegmentSize + 90);
+
+  chain.retrieve(BufferChain::kSegmentSize - 10);
+  BOOST_CHECK_EQUAL(chain.numSegments(), 1);
+  BOOST_CHECK_EQUAL(chain.readableBytes(), 100);
+}
+
+BOOST_AUTO_TEST_CASE(testBufferChainSplice)
+{
+  BufferChain chain;
+  chain.append(string(100, 'x'));
+
+  Buffer small;
+  small.append(string(100, 'y'));
+  chain.append(&small);
+  BOOST_CHECK_EQUAL(small.readableBytes(), 0);
+  BOOST_CHECK_EQUAL(chain.numSegments(), 1);
+
+  Buffer big;
+  big.append(string(BufferChain::kSpliceThreshold, 'z'));
+  chain.append(&big);
+  BOOST_CHECK_EQUAL(big.readableBytes(), 0);
+  BOOST_CHECK_EQUAL(chain.numSegments(), 2);
+  BOOST_CHECK_EQUAL(chain.readableBytes(), 200 + BufferChain::kSpliceThreshold);
+
+  chain.retrieve(200);
+  BOOST_CHECK_EQUAL(chain.numSegments(), 1);
+  BOOST_CHECK_EQUAL(chain.readableBytes(), BufferChain::kSpliceThreshold);
+}
+
+BOOST_AUTO_TEST_CASE(testBufferChainWriteFd)
+{
+  int fds[2];
+  BOOST_REQUIRE_EQUAL(::socketpair(AF_UNIX, SOCK_STREAM, 0, fds), 0);
+
+  BufferChain chain;
+  chain.append(string(100, 'a'));
+  Buffer big;
+  big.append(string(BufferChain::kSpliceThreshold, 'b'));
+  chain.append(&big);
+  chain.append(string(100, 'c'));
+  BOOST_CHECK_EQUAL(chain.numSegments(), 2);
+
+  int savedErrno = 0;
+  ssize_t n = chain.writeFd(fds[0], &savedErrno);
+  BOOST_CHECK_EQUAL(n, 200 + BufferChain::kSpliceThreshold);
+  BOOST_CHECK(chain.empty());
+
+  char buf[8192];
+  ssize_t nr = ::read(fds[1], buf, sizeof buf);
+  BOOST_REQUIRE_EQUAL(nr, n);
+  string expected = string(100, 'a') + string(BufferChain::kSpliceThreshold, 'b') + string(100, 'c');
+  BOOST_CHECK(string(buf, nr) == expected);
+
+  ::close(fds[0]);
+  ::close(fds[1]);
+}
+
+BOOST_AUTO_TEST_CASE(testBufferChainSendFile)
+{
+  char path[] = "/tmp/bufferchain_unittest_XXXXXX";
+  int fileFd = ::mkstemp(path);
+  BOOST_REQUIRE(fileFd >= 0);
+  ::unlink(path);
+  const string content(1000, 'f');
+  BOOST_REQUIRE_EQUAL(::write(fileFd, content.data(), content.size()), 1000);
+
+  int fds[2];
+  BOOST_REQUIRE_EQUAL(::socketpair(AF_UNIX, SOCK_STREAM, 0, fds), 0);
+
+  BufferChain chain;
+  chain.append(string(100, 'a'));
+  chain.appendFile(fileFd, 100, 800);
+  chain.append(string(100, 'c'));
+  BOOST_CHECK_EQUAL(chain.numSegments(), 3);
+  BOOST_CHECK_EQUAL(chain.readableBytes(), 1000);
+
+  int savedErrno = 0;
+  BOOST_CHECK_EQUAL(chain.writeFd(fds[0], &savedErrno), 100);
+  BOOST_CHECK_EQUAL(chain.writeFd(fds[0], &savedErrno), 800);
+  BOOST_CHECK_EQUAL(chain.writeFd(fds[0], &savedErrno), 100);
+  BOOST_CHECK(chain.empty());
+
+  char buf[2048];
+  ssize_t nr = ::read(fds[1], buf, sizeof buf);
+  BOOST_REQUIRE_EQUAL(nr, 1000);
+  string expected = string(100, 'a') + string(800, 'f') + string(100, 'c');
+  BOOST_CHECK(string(buf, nr) == expected);
+
+  ::close(fds[0]);
+  ::close(fds[1]);
+}
+
+BOOST_AUTO_TEST_CASE(testBufferChainRelease)
+{
+  BufferChain chain;
+  chain.append(string(BufferChain::kSegmentSize, 'x'));
+  chain.append(string(100, 'y'));
+  BOOST_CHECK_EQUAL(chain.numSegments(), 2);
+  chain.retrieveAll();
+  BOOST_CHECK_EQUAL(chain.numSegments(), 1);
+  chain.release();
+  BOOST_CHECK_EQUAL(chain.numSegments(), 0);
+  BOOST_CHECK_EQUAL(chain.internalCapacity(), 0);
+
+  chain.append(string(100, 'z'));
+  BOOST_CHECK_EQUAL(chain.numSegments(), 1);
+  BOOST_CHECK_EQUAL(chain.readableBytes(), 100);
+}
+
+namespace
+{
+
+// MSG_ZEROCOPY needs TCP, AF_UNIX does not support it
+void tcpPair(int* sender, int* receiver)
+{
+  int listenfd = ::socket(AF_INET, SOCK_STREAM, 0);
+  struct sockaddr_in addr = sockaddr_in();
+  addr.sin_family = AF_INET;
+  addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+  socklen_t addrlen = static_cast<socklen_t>(sizeof addr);
+  BOOST_REQUIRE_EQUAL(::bind(listenfd, muduo::net::sockets::sockaddr_cast(&addr), addrlen), 0);
+  BOOST_REQUIRE_EQUAL(::listen(listenfd, 1), 0);
+  // with the port picked
+  muduo::net::sockets::getLocalAddr(listenfd, static_cast<struct sockaddr*>(static_cast<void*>(&addr)), addrlen);
+  *sender = ::socket(AF_INET, SOCK_STREAM, 0);
+  BOOST_REQUIRE_EQUAL(::connect(*sender, muduo::net::sockets::sockaddr_cast(&addr), addrlen), 0);
+  *receiver = ::accept(listenfd, NULL, NULL);
+  BOOST_REQUIRE(*receiver >= 0);
+  ::close(listenfd);
+}
+
+}  // namespace
+
+BOOST_AUTO_TEST_CASE(testBufferChainTakePinned)
+{
+#ifdef SO_ZEROCOPY
+  int sender = -1;
+  int receiver = -1;
+  tcpPair(&sender, &receiver);
+  int on = 1;
+  if (::setsockopt(sender, SOL_SOCKET, SO_ZEROCOPY, &on, static_cast<socklen_t>(sizeof on)) < 0)
+  {
+    BOOST_TEST_MESSAGE("SO_ZEROCOPY is not supported");
+    ::close(sender);
+    ::close(receiver);
+    return;
+  }
+
+  BufferChain chain;
+  Buffer big;
+  big.append(string(BufferChain::kSegmentSize, 'z'));
+  chain.append(&big);
+  chain.append(string(100, 'a'));
+  int savedErrno = 0;
+  ssize_t n = chain.writeFd(sender, &savedErrno, 1);
+  BOOST_REQUIRE(n > 0);
+  BOOST_CHECK(chain.zeroCopyInflight());
+
+  // the connection is gone, but the kernel may still read them
+  BufferChain pinned;
+  pinned.takePinned(&chain);
+  BOOST_CHECK(chain.empty());
+  BOOST_CHECK_EQUAL(chain.numSegments(), 0);
+  BOOST_CHECK(!chain.zeroCopyInflight());
+  BOOST_CHECK(pinned.zeroCopyInflight());
+  BOOST_CHECK(pinned.empty());
+
+  // completed once the receiver has it
+  char buf[8192];
+  ssize_t total = 0;
+  while (total < n)
+  {
+    ssize_t nr = ::read(receiver, buf, sizeof buf);
+    BOOST_REQUIRE(nr > 0);
+    total += nr;
+  }
+  for (int i = 0; i < 1000 && pinned.zeroCopyInflight(); ++i)
+  {
+    uint32_t lo = 0;
+    uint32_t hi = 0;
+    bool copied = false;
+    while (muduo::net::sockets::readZeroCopyCompletion(sender, &lo, &hi, &copied))
+    {
+      pinned.releaseZeroCopy(lo, hi);
+    }
+    ::usleep(1000);
+  }
+  BOOST_CHECK(!pinned.zeroCopyInflight());
+  BOOST_CHECK_EQUAL(pinned.pinnedBytes(), 0u);
+
+  ::close(sender);
+  ::close(receiver);
+#endif
+}
+
+BOOST_AUTO_TEST_CASE(testBufferChainZeroCopyIdsWrap)
+{
+#ifdef MSG_ZEROCOPY
+  // without SO_ZEROCOPY the kernel ignores MSG_ZEROCOPY, and completes
+  // nothing, so the completions below are made up
+  int sender = -1;
+  int receiver = -1;
+  tcpPair(&sender, &receiver);
+
+  BufferChain chain;
+  chain.setNextZeroCopyId(UINT32_MAX - 1);
+  for (int i = 0; i < 4; ++i)
+  {
+    Buffer buf;
+    buf.append(string(8*1024, static_cast<char>('a' + i)));
+    chain.append(&buf);
+  }
+  BOOST_CHECK_EQUAL(chain.numSegments(), 4u);
+  // one send per segment, ids UINT32_MAX - 1, UINT32_MAX, 0 and 1
+  for (int i = 0; i < 4; ++i)
+  {
+    int savedErrno = 0;
+    BOOST_REQUIRE_EQUAL(chain.writeFd(sender, &savedErrno, 1), 8*1024);
+  }
+  BOOST_CHECK(chain.empty());
+  BOOST_CHECK(chain.zeroCopyInflight());
+  const size_t pinnedBytes = chain.pinnedBytes();
+  BOOST_CHECK_GE(pinnedBytes, 4*8*1024u);
+
+  // a range across the wrap, behind the first one
+  chain.releaseZeroCopy(UINT32_MAX, 0);
+  BOOST_CHECK(chain.zeroCopyInflight());
+  BOOST_CHECK_EQUAL(chain.pinnedBytes(), pinnedBytes);
+
+  // frees the first three, not the last one with the smallest id
+  chain.releaseZeroCopy(UINT32_MAX - 1, UINT32_MAX - 1);
+  BOOST_CHECK(chain.zeroCopyInflight());
+  BOOST_CHECK_GT(chain.pinnedBytes(), 0u);
+  BOOST_CHECK_LT(chain.pinnedBytes(), pinnedBytes / 2);
+
+  // not sent yet, ignored
+  chain.releaseZeroCopy(2, 2);
+  BOOST_CHECK(chain.zeroCopyInflight());
+
+  chain.releaseZeroCopy(1, 1);
+  BOOST_CHECK(!chain.zeroCopyInflight());
+  BOOST_CHECK_EQUAL(chain.pinnedBytes(), 0u);
+
+  ::close(sender);
+  ::close(receiver);
+#endif
+}
@@ -0,0 +1,138 @@
+#include "muduo/net/BufferPool.h"
+
+#include "muduo/base/Thread.h"
+#include "muduo/net/Buffer.h"
+
+//#define BOOST_TEST_MODULE BufferPoolTest
+#define BOOST_TEST_MAIN
+#define BOOST_TEST_DYN_LINK
+#include <boost/test/unit_test.hpp>
+
+using muduo::string;
+using muduo::Thread;
+using muduo::net::Buffer;
+using muduo::net::BufferPool;
+
+BOOST_AUTO_TEST_CASE(testBufferPoolGoodSize)
+{
+  BOOST_CHECK_EQUAL(BufferPool::goodSize(1), BufferPool::kMinBlockSize);
+  BOOST_CHECK_EQUAL(BufferPool::goodSize(1032), 1032);
+  BOOST_CHECK_EQUAL(BufferPool::goodSize(1033), 2064);
+  BOOST_CHECK_EQUAL(BufferPool::goodSize(66048), 66048);
+  BOOST_CHECK_EQUAL(BufferPool::goodSize(66049), 66049);
+}
+
+BOOST_AUTO_TEST_CASE(testBufferPoolAllocate)
+{
+  BufferPool pool;
+  void* p1 = pool.allocate(500);
+  void* p2 = pool.allocate(2000);
+  BufferPool::Stats stats = pool.stats();
+  BOOST_CHECK_EQUAL(stats.numSlabs, 2);
+  BOOST_CHECK_EQUAL(stats.bytesInUse, 1032 + 2064);
+  BOOST_CHECK_EQUAL(stats.allocations, 2);
+
+  // the only slab of a size class is kept
+  pool.deallocate(p1, 500);
+  void* p3 = pool.allocate(1000);
+  BOOST_CHECK_EQUAL(p3, p1);
+  pool.deallocate(p3, 1000);
+  pool.deallocate(p2, 2000);
+  stats = pool.stats();
+  BOOST_CHECK_EQUAL(stats.numSlabs, 2);
+  BOOST_CHECK_EQUAL(stats.bytesInUse, 0);
+
+  void* big = pool.allocate(1024*1024);
+  void* small = pool.allocate(100);
+  BOOST_CHECK_EQUAL(pool.stats().fallbacks, 2);
+  BOOST_CHECK_EQUAL(pool.stats().bytesInUse, 0);
+  pool.deallocate(big, 1024*1024);
+  pool.deallocate(small, 100);
+}
+
+BOOST_AUTO_TEST_CASE(testBufferPoolReleaseSlab)
+{
+  BufferPool pool;
+  std::vector<void*> blocks;
+  while (pool.stats().numSlabs < 2)
+  {
+    blocks.push_back(pool.allocate(1000));
+  }
+  for (void* p : blocks)
+  {
+    pool.deallocate(p, 1000);
+  }
+  // one spare slab is kept
+  BOOST_CHECK_EQUAL(pool.stats().numSlabs, 1);
+  BOOST_CHECK_EQUAL(pool.stats().bytesInUse, 0);
+}
+
+BOOST_AUTO_TEST_CASE(testBufferPoolOtherThread)
+{
+  BufferPool pool;
+  void* mine = pool.allocate(1000);
+  void* theirs = NULL;
+  Thread thr([&pool, &mine, &theirs] {
+    theirs = pool.allocate(1000);
+    pool.deallocate(mine, 1000);
+  });
+  thr.start();
+  thr.join();
+  BOOST_CHECK_EQUAL(pool.stats().fallbacks, 1);
+  // freed by the other thread, returned on next allocation
+  BOOST_CHECK_EQUAL(pool.stats().bytesInUse, 1032);
+  void* p = pool.allocate(1000);
+  BOOST_CHECK_EQUAL(p, mine);
+  BOOST_CHECK_EQUAL(pool.stats().bytesInUse, 1032);
+  pool.deallocate(p, 1000);
+  pool.deallocate(theirs, 1000);
+  BOOST_CHECK_EQUAL(pool.stats().bytesInUse, 0);
+}
+
+BOOST_AUTO_TEST_CASE(testBufferWithPool)
+{
+  std::shared_ptr<BufferPool> pool(new BufferPool);
+  // empty buffers don't take a block
+  Buffer buf(0, Buffer::Allocator(pool));
+  BOOST_CHECK_EQUAL(pool->stats().bytesInUse, 0);
+
+  buf.append(string(2000, 'x'));
+  BOOST_CHECK_EQUAL(buf.internalCapacity(), 2064);
+  BOOST_CHECK_EQUAL(pool->stats().bytesInUse, 2064);
+
+  // copies don't use the pool
+  Buffer copy(buf);
+  BOOST_CHECK(copy.allocator().pool() == NULL);
+  BOOST_CHECK_EQUAL(pool->stats().bytesInUse, 2064);
+
+  // memory is freed to its own pool after swapping
+  Buffer other;
+  other.swap(buf);
+  BOOST_CHECK(other.allocator().pool() == pool);
+  BOOST_CHECK_EQUAL(other.readableBytes(), 2000);
+  buf.append(string(5000, 'y'));
+  BOOST_CHECK(buf.allocator().pool() == NULL);
+  {
+    Buffer gone;
+    gone.swap(other);
+  }
+  BOOST_CHECK_EQUAL(pool->stats().bytesInUse, 0);
+}
+
+BOOST_AUTO_TEST_CASE(testBufferRelease)
+{
+  std::shared_ptr<BufferPool> pool(new BufferPool);
+  Buffer buf(0, Buffer::Allocator(pool));
+  buf.append(string(100, 'x'));
+  BOOST_CHECK_EQUAL(buf.internalCapacity(), 1032);
+  BOOST_CHECK_EQUAL(pool->stats().bytesInUse, 1032);
+
+  buf.retrieveAll();
+  buf.release();
+  BOOST_CHECK_EQUAL(buf.internalCapacity(), Buffer::kCheapPrepend);
+  BOOST_CHECK_EQUAL(pool->stats().bytesInUse, 0);
+  BOOST_CHECK(buf.allocator().pool() == pool);
+
+  buf.append(string(100, 'y'));
+  BOOST_CHECK_EQUAL(buf.retrieveAllAsString(), string(100, 'y'));
+}
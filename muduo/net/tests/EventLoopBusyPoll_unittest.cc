@@ -0,0 +1,113 @@
+#include "muduo/net/EventLoop.h"
+
+#include "muduo/base/Thread.h"
+#include "muduo/net/Channel.h"
+
+#include <atomic>
+#include <memory>
+
+#include <sys/socket.h>
+#include <unistd.h>
+
+//#define BOOST_TEST_MODULE EventLoopBusyPollTest
+#define BOOST_TEST_MAIN
+#define BOOST_TEST_DYN_LINK
+#include <boost/test/unit_test.hpp>
+
+using namespace muduo;
+using namespace muduo::net;
+
+namespace
+{
+
+// echoes every byte from sockfd back, in the loop
+class Echo
+{
+ public:
+  Echo(EventLoop* loop, int sockfd)
+    : channel_(loop, sockfd)
+  {
+    channel_.setReadCallback([this](Timestamp) {
+      char buf[64];
+      ssize_t n = ::read(channel_.fd(), buf, sizeof buf);
+      if (n > 0)
+      {
+        BOOST_REQUIRE_EQUAL(::write(channel_.fd(), buf, static_cast<size_t>(n)), n);
+      }
+    });
+    channel_.enableReading();
+  }
+
+  ~Echo()
+  {
+    channel_.disableAll();
+    channel_.remove();
+  }
+
+ private:
+  Channel channel_;
+};
+
+// rounds of ping-pong with the loop over a blocking sockfd,
+// queueing a functor to the loop after each, then quits the loop,
+// not checked here as Boost.Test is not thread safe
+void pingPong(EventLoop* loop, int sockfd, int rounds, std::atomic<int>* functors)
+{
+  for (int i = 0; i < rounds; ++i)
+  {
+    char c = 'x';
+    if (::write(sockfd, &c, 1) != 1 || ::read(sockfd, &c, 1) != 1)
+    {
+      break;  // seen as missing functors
+    }
+    loop->queueInLoop([functors] { ++*functors; });
+  }
+  loop->queueInLoop([loop] { loop->quit(); });
+}
+
+void runPingPong(EventLoop* loop, int sockfd, int rounds, std::atomic<int>* functors)
+{
+  Thread thread(std::bind(&pingPong, loop, sockfd, rounds, functors), "PingPong");
+  thread.start();
+  loop->loop();
+  thread.join();
+}
+
+}  // namespace
+
+BOOST_AUTO_TEST_CASE(testBusyPoll)
+{
+  const int kRounds = 1000;
+  int fds[2];
+  BOOST_REQUIRE_EQUAL(::socketpair(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0, fds), 0);
+  EventLoop loop;
+  std::unique_ptr<Echo> echo(new Echo(&loop, fds[0]));
+  std::atomic<int> functors(0);
+
+  // each ping comes in while spinning after the last one
+  loop.setBusyPoll(1000);
+  runPingPong(&loop, fds[1], kRounds, &functors);
+  EventLoop::BusyPollStats stats = loop.busyPollStats();
+  BOOST_CHECK_GT(stats.polls, 0);
+  BOOST_CHECK_GT(stats.hits, 0);
+  // queued without wakeup while spinning, still run
+  BOOST_CHECK_EQUAL(functors, kRounds);
+
+  // blocks again, no more spins
+  loop.setBusyPoll(0);
+  runPingPong(&loop, fds[1], kRounds, &functors);
+  BOOST_CHECK_EQUAL(functors, 2 * kRounds);
+  EventLoop::BusyPollStats after = loop.busyPollStats();
+  BOOST_CHECK_EQUAL(after.polls, stats.polls);
+  BOOST_CHECK_EQUAL(after.hits, stats.hits);
+
+  // and sleeps when idle
+  const int64_t iteration = loop.iteration();
+  loop.runAfter(0.2, [&loop] { loop.quit(); });
+  loop.loop();
+  BOOST_CHECK_LE(loop.iteration() - iteration, 2);
+
+  echo.reset();
+  ::close(fds[0]);
+  ::close(fds[1]);
+}
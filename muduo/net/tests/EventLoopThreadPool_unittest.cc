@@ -63,6 +63,29 @@ int main()
     assert(nextLoop == model.getNextLoop());
   }
 
+  {
+    printf("Least connections:\n");
+    EventLoopThreadPool model(&loop, "least");
+    model.setThreadNum(3);
+    model.setPlacement(EventLoopThreadPool::kLeastConnections);
+    model.start(init);
+    std::vector<EventLoop*> loops = model.getAllLoops();
+    loops[0]->addConnections(2);
+    loops[2]->addConnections(1);
+    assert(model.getNextLoop() == loops[1]);
+    loops[1]->addConnections(3);
+    assert(model.getNextLoop() == loops[2]);
+    loops[2]->addConnections(1);
+    // ties are broken round-robin
+    EventLoop* tied = model.getNextLoop();
+    assert(tied == loops[0] || tied == loops[2]);
+    for (EventLoop* l : loops)
+    {
+      l->addConnections(-l->numConnections());
+    }
+    (void)tied;
+  }
+
   loop.loop();
 }
 
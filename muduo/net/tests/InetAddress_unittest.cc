@@ -56,6 +56,28 @@ BOOST_AUTO_TEST_CASE(testInet6Address)
   BOOST_CHECK_EQUAL(addr3.port(), 8888);
 }
 
+BOOST_AUTO_TEST_CASE(testUnixAddress)
+{
+  InetAddress addr0(InetAddress::unixDomain("/tmp/muduo.sock"));
+  BOOST_CHECK_EQUAL(addr0.family(), AF_UNIX);
+  BOOST_CHECK_EQUAL(addr0.unixPath(), string("/tmp/muduo.sock"));
+  BOOST_CHECK_EQUAL(addr0.toIpPort(), string("unix:/tmp/muduo.sock"));
+  BOOST_CHECK_EQUAL(addr0.port(), 0);
+
+  InetAddress addr1(InetAddress::unixDomain("@muduo"));
+  BOOST_CHECK_EQUAL(addr1.family(), AF_UNIX);
+  BOOST_CHECK_EQUAL(addr1.unixPath(), string("@muduo"));
+  BOOST_CHECK_EQUAL(addr1.toIp(), string("unix:@muduo"));
+  BOOST_CHECK_EQUAL(addr1.getSockAddr()->sa_data[0], '\0');
+
+  struct sockaddr_un unnamed;
+  memset(&unnamed, 0, sizeof unnamed);
+  unnamed.sun_family = AF_UNIX;
+  InetAddress addr2(unnamed);
+  BOOST_CHECK_EQUAL(addr2.unixPath(), string());
+  BOOST_CHECK_EQUAL(addr2.toIpPort(), string("unix:"));
+}
+
 BOOST_AUTO_TEST_CASE(testInetAddressResolve)
 {
   InetAddress addr(80);
@@ -0,0 +1,186 @@
+#include "muduo/net/poller/IoUringPoller.h"
+
+#include "muduo/net/Channel.h"
+#include "muduo/net/EventLoop.h"
+
+#include <errno.h>
+#include <fcntl.h>
+#include <stdlib.h>
+#include <unistd.h>
+
+//#define BOOST_TEST_MODULE IoUringPollerTest
+#define BOOST_TEST_MAIN
+#define BOOST_TEST_DYN_LINK
+#include <boost/test/unit_test.hpp>
+
+using namespace muduo;
+using namespace muduo::net;
+
+namespace
+{
+
+// the loop polls with io_uring, false if the kernel can't
+bool useIoUring()
+{
+  if (!IoUringPoller::isSupported())
+  {
+    BOOST_TEST_MESSAGE("io_uring is not supported, skipped");
+    return false;
+  }
+  ::setenv("MUDUO_USE_IO_URING", "1", 1);
+  return true;
+}
+
+void runFor(EventLoop* loop, double seconds)
+{
+  loop->runAfter(seconds, [loop] { loop->quit(); });
+  loop->loop();
+}
+
+struct Pipe
+{
+  Pipe()
+  {
+    BOOST_REQUIRE_EQUAL(::pipe2(fds, O_NONBLOCK | O_CLOEXEC), 0);
+  }
+
+  ~Pipe()
+  {
+    close();
+  }
+
+  void close()
+  {
+    for (int& fd : fds)
+    {
+      if (fd >= 0)
+      {
+        ::close(fd);
+        fd = -1;
+      }
+    }
+  }
+
+  void write()
+  {
+    BOOST_REQUIRE_EQUAL(::write(fds[1], "x", 1), 1);
+  }
+
+  void drain()
+  {
+    char buf[64];
+    while (::read(fds[0], buf, sizeof buf) > 0)
+    {
+    }
+  }
+
+  int fds[2];
+};
+
+}  // namespace
+
+BOOST_AUTO_TEST_CASE(testLevelTriggered)
+{
+  if (!useIoUring())
+  {
+    return;
+  }
+  EventLoop loop;
+  Pipe pipe;
+  Channel channel(&loop, pipe.fds[0]);
+  int reads = 0;
+  // a oneshot poll is re-armed, and fires again while data is left
+  channel.setReadCallback([&](Timestamp) {
+    if (++reads == 3)
+    {
+      pipe.drain();
+    }
+  });
+  channel.enableReading();
+  pipe.write();
+  runFor(&loop, 0.1);
+  BOOST_CHECK_EQUAL(reads, 3);
+
+  // and again for new data
+  pipe.write();
+  runFor(&loop, 0.1);
+  BOOST_CHECK_GE(reads, 4);
+
+  channel.disableAll();
+  channel.remove();
+}
+
+BOOST_AUTO_TEST_CASE(testRemoveAndAddAgain)
+{
+  if (!useIoUring())
+  {
+    return;
+  }
+  EventLoop loop;
+  Pipe trigger;
+  Channel triggerChannel(&loop, trigger.fds[0]);
+  std::unique_ptr<Pipe> first(new Pipe);
+  Channel firstChannel(&loop, first->fds[0]);
+  std::unique_ptr<Pipe> second;
+  std::unique_ptr<Channel> secondChannel;
+  int firstReads = 0;
+  int secondReads = 0;
+  firstChannel.setReadCallback([&](Timestamp) { ++firstReads; });
+  firstChannel.enableReading();
+  triggerChannel.setReadCallback([&](Timestamp) {
+    trigger.drain();
+    // its poll completes now, and is reaped after it is removed
+    first->write();
+    firstChannel.disableAll();
+    firstChannel.remove();
+    // on the same fd, that completion must not show up here
+    const int fd = first->fds[0];
+    first->close();
+    second.reset(new Pipe);
+    BOOST_REQUIRE_EQUAL(second->fds[0], fd);
+    secondChannel.reset(new Channel(&loop, second->fds[0]));
+    secondChannel->setReadCallback([&](Timestamp) {
+      ++secondReads;
+      second->drain();
+    });
+    secondChannel->enableReading();
+  });
+  triggerChannel.enableReading();
+  runFor(&loop, 0.05);
+  trigger.write();
+  runFor(&loop, 0.1);
+  BOOST_CHECK_EQUAL(firstReads, 0);
+  BOOST_REQUIRE(secondChannel);
+  BOOST_CHECK_EQUAL(secondReads, 0);
+
+  second->write();
+  runFor(&loop, 0.1);
+  BOOST_CHECK_EQUAL(secondReads, 1);
+
+  secondChannel->disableAll();
+  secondChannel->remove();
+  triggerChannel.disableAll();
+  triggerChannel.remove();
+}
+
+BOOST_AUTO_TEST_CASE(testRemoveReleasesFile)
+{
+  if (!useIoUring())
+  {
+    return;
+  }
+  EventLoop loop;
+  Pipe pipe;
+  Channel channel(&loop, pipe.fds[0]);
+  channel.enableReading();
+  runFor(&loop, 0.05);
+
+  // the armed poll is removed at once, not with the next poll(), or it
+  // would keep the read end open after close()
+  channel.disableAll();
+  channel.remove();
+  ::close(pipe.fds[0]);
+  pipe.fds[0] = -1;
+  BOOST_CHECK_EQUAL(::write(pipe.fds[1], "x", 1), -1);
+  BOOST_CHECK_EQUAL(errno, EPIPE);
+}
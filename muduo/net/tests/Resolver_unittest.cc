@@ -0,0 +1,318 @@
+#include "muduo/net/Resolver.h"
+
+#include "muduo/net/EventLoop.h"
+#include "muduo/net/TcpClient.h"
+#include "muduo/net/TcpServer.h"
+#include "muduo/net/UdpServer.h"
+#include "muduo/net/UdpSocket.h"
+
+#include <map>
+
+#include <arpa/inet.h>
+#include <stdio.h>
+#include <unistd.h>
+
+//#define BOOST_TEST_MODULE ResolverTest
+#define BOOST_TEST_MAIN
+#define BOOST_TEST_DYN_LINK
+#include <boost/test/unit_test.hpp>
+
+using namespace muduo;
+using namespace muduo::net;
+
+namespace
+{
+
+struct Record
+{
+  std::vector<string> a;
+  std::vector<string> aaaa;
+  uint32_t ttl;
+};
+
+void appendUint16(string* out, uint16_t x)
+{
+  out->push_back(static_cast<char>(x >> 8));
+  out->push_back(static_cast<char>(x & 0xFF));
+}
+
+uint16_t readUint16(const char* p)
+{
+  return static_cast<uint16_t>((static_cast<uint8_t>(p[0]) << 8) | static_cast<uint8_t>(p[1]));
+}
+
+// A name server on 127.0.0.1, answers with records_, NXDOMAIN for others,
+// or not at all if silent.
+class StubDns
+{
+ public:
+  explicit StubDns(EventLoop* loop, bool silent = false)
+    : server_(loop, InetAddress(0, true), "StubDns"),
+      silent_(silent),
+      queries_(0)
+  {
+    server_.setMessageCallback(
+        std::bind(&StubDns::onQuery, this, _1, _2, _3));
+    server_.start();
+  }
+
+  InetAddress address() const { return server_.listenAddress(); }
+  int queries() const { return queries_; }
+  void add(const string& name, const Record& record) { records_[name] = record; }
+
+ private:
+  void onQuery(const UdpSocketPtr& socket, const InetAddress& peer, StringPiece query)
+  {
+    ++queries_;
+    if (silent_ || query.size() < 12)
+    {
+      return;
+    }
+    // question
+    string name;
+    size_t offset = 12;
+    while (offset < static_cast<size_t>(query.size()) && query.data()[offset] != 0)
+    {
+      size_t len = static_cast<uint8_t>(query.data()[offset]);
+      if (!name.empty())
+      {
+        name += '.';
+      }
+      name.append(query.data() + offset + 1, len);
+      offset += 1 + len;
+    }
+    const uint16_t type = readUint16(query.data() + offset + 1);
+    const string question(query.data() + 12, offset + 5 - 12);
+
+    auto it = records_.find(name);
+    const std::vector<string>* ips = NULL;
+    if (it != records_.end())
+    {
+      ips = type == 1 ? &it->second.a : &it->second.aaaa;
+    }
+    string response(query.data(), 2);
+    appendUint16(&response, static_cast<uint16_t>(0x8180 | (it == records_.end() ? 3 : 0)));
+    appendUint16(&response, 1);
+    appendUint16(&response, static_cast<uint16_t>(ips ? ips->size() : 0));
+    appendUint16(&response, 0);
+    appendUint16(&response, 0);
+    response += question;
+    for (size_t i = 0; ips && i < ips->size(); ++i)
+    {
+      appendUint16(&response, 0xC00C);  // the name in question
+      appendUint16(&response, type);
+      appendUint16(&response, 1);
+      appendUint16(&response, static_cast<uint16_t>(it->second.ttl >> 16));
+      appendUint16(&response, static_cast<uint16_t>(it->second.ttl & 0xFFFF));
+      char addr[16];
+      int len = type == 1 ? 4 : 16;
+      ::inet_pton(type == 1 ? AF_INET : AF_INET6, (*ips)[i].c_str(), addr);
+      appendUint16(&response, static_cast<uint16_t>(len));
+      response.append(addr, len);
+    }
+    socket->send(peer, response);
+  }
+
+  UdpServer server_;
+  bool silent_;
+  int queries_;
+  std::map<string, Record> records_;
+};
+
+Resolver::Options stubOptions(const InetAddress& server)
+{
+  Resolver::Options options;
+  options.nameservers.push_back(server);
+  options.hostsFile.clear();
+  options.timeout = 0.2;
+  options.attempts = 1;
+  return options;
+}
+
+string toIps(const Resolver::AddressList& addresses)
+{
+  string result;
+  for (const InetAddress& addr : addresses)
+  {
+    result += addr.toIp() + " ";
+  }
+  return result;
+}
+
+// resolves in loop, returns the ips
+string resolveSync(EventLoop* loop, Resolver* resolver, const string& name)
+{
+  string result = "unresolved";
+  resolver->resolve(name, [&](const Resolver::AddressList& addresses) {
+    result = toIps(addresses);
+    loop->quit();
+  });
+  if (result == "unresolved")
+  {
+    TimerId timer = loop->runAfter(5.0, [loop] { loop->quit(); });
+    loop->loop();
+    loop->cancel(timer);
+  }
+  return result;
+}
+
+}  // namespace
+
+BOOST_AUTO_TEST_CASE(testResolveAndCache)
+{
+  EventLoop loop;
+  StubDns dns(&loop);
+  Record record;
+  record.a.push_back("10.0.0.1");
+  record.a.push_back("10.0.0.2");
+  record.aaaa.push_back("fd00::1");
+  record.ttl = 300;
+  dns.add("www.example.test", record);
+  Resolver resolver(&loop, stubOptions(dns.address()));
+
+  BOOST_CHECK_EQUAL(resolveSync(&loop, &resolver, "www.example.test"), "10.0.0.1 10.0.0.2 fd00::1 ");
+  BOOST_CHECK_EQUAL(dns.queries(), 2);
+  // cached, case insensitive, absolute
+  BOOST_CHECK_EQUAL(resolveSync(&loop, &resolver, "WWW.Example.Test."), "10.0.0.1 10.0.0.2 fd00::1 ");
+  BOOST_CHECK_EQUAL(dns.queries(), 2);
+  BOOST_CHECK_EQUAL(resolver.cacheHits(), 1);
+
+  resolver.clearCache();
+  BOOST_CHECK_EQUAL(resolveSync(&loop, &resolver, "www.example.test"), "10.0.0.1 10.0.0.2 fd00::1 ");
+  BOOST_CHECK_EQUAL(dns.queries(), 4);
+}
+
+BOOST_AUTO_TEST_CASE(testCoalescing)
+{
+  EventLoop loop;
+  StubDns dns(&loop);
+  Record record;
+  record.a.push_back("10.0.0.3");
+  record.ttl = 300;
+  dns.add("db.example.test", record);
+  Resolver::Options options(stubOptions(dns.address()));
+  options.ipv6 = false;
+  Resolver resolver(&loop, options);
+
+  int answers = 0;
+  for (int i = 0; i < 10; ++i)
+  {
+    resolver.resolve("db.example.test", [&](const Resolver::AddressList& addresses) {
+      BOOST_CHECK_EQUAL(toIps(addresses), "10.0.0.3 ");
+      if (++answers == 10)
+      {
+        loop.quit();
+      }
+    });
+  }
+  loop.runAfter(5.0, [&loop] { loop.quit(); });
+  loop.loop();
+  BOOST_CHECK_EQUAL(answers, 10);
+  BOOST_CHECK_EQUAL(dns.queries(), 1);
+  BOOST_CHECK_EQUAL(resolver.queriesSent(), 1);
+}
+
+BOOST_AUTO_TEST_CASE(testNegativeAndTtl)
+{
+  EventLoop loop;
+  StubDns dns(&loop);
+  Record record;
+  record.a.push_back("10.0.0.4");
+  record.ttl = 1;
+  dns.add("short.example.test", record);
+  Resolver resolver(&loop, stubOptions(dns.address()));
+
+  BOOST_CHECK_EQUAL(resolveSync(&loop, &resolver, "missing.example.test"), "");
+  BOOST_CHECK_EQUAL(resolveSync(&loop, &resolver, "missing.example.test"), "");
+  BOOST_CHECK_EQUAL(dns.queries(), 2);
+
+  BOOST_CHECK_EQUAL(resolveSync(&loop, &resolver, "short.example.test"), "10.0.0.4 ");
+  BOOST_CHECK_EQUAL(dns.queries(), 4);
+  ::usleep(1100*1000);
+  BOOST_CHECK_EQUAL(resolveSync(&loop, &resolver, "short.example.test"), "10.0.0.4 ");
+  BOOST_CHECK_EQUAL(dns.queries(), 6);
+}
+
+BOOST_AUTO_TEST_CASE(testTimeoutAndNextServer)
+{
+  EventLoop loop;
+  StubDns silent(&loop, true);
+  StubDns dns(&loop);
+  Record record;
+  record.a.push_back("10.0.0.5");
+  record.ttl = 300;
+  dns.add("api.example.test", record);
+  Resolver::Options options(stubOptions(silent.address()));
+  options.nameservers.push_back(dns.address());
+  Resolver resolver(&loop, options);
+
+  BOOST_CHECK_EQUAL(resolveSync(&loop, &resolver, "api.example.test"), "10.0.0.5 ");
+  BOOST_CHECK_EQUAL(silent.queries(), 2);
+  BOOST_CHECK_EQUAL(resolver.timeouts(), 1);
+
+  // silent, then NXDOMAIN
+  BOOST_CHECK_EQUAL(resolveSync(&loop, &resolver, "nowhere.example.test"), "");
+}
+
+BOOST_AUTO_TEST_CASE(testHostsAndLiterals)
+{
+  char path[] = "/tmp/resolver_unittestXXXXXX";
+  int fd = ::mkstemp(path);
+  BOOST_REQUIRE(fd >= 0);
+  const char hosts[] =
+      "# comment\n"
+      "127.0.0.1 localhost\n"
+      "::1 localhost ip6-localhost\n"
+      "10.1.2.3  cache.local cache  # sidecar\n";
+  BOOST_REQUIRE_EQUAL(::write(fd, hosts, sizeof hosts - 1), static_cast<ssize_t>(sizeof hosts - 1));
+  ::close(fd);
+
+  EventLoop loop;
+  Resolver::Options options;
+  options.hostsFile = path;
+  options.resolvConf = "/nonexistent";
+  Resolver resolver(&loop, options);
+  ::unlink(path);
+
+  BOOST_CHECK(resolver.nameservers().empty());
+  BOOST_CHECK_EQUAL(resolveSync(&loop, &resolver, "localhost"), "127.0.0.1 ::1 ");
+  BOOST_CHECK_EQUAL(resolveSync(&loop, &resolver, "cache"), "10.1.2.3 ");
+  BOOST_CHECK_EQUAL(resolveSync(&loop, &resolver, "192.168.1.1"), "192.168.1.1 ");
+  BOOST_CHECK_EQUAL(resolveSync(&loop, &resolver, "2001:db8::1"), "2001:db8::1 ");
+  BOOST_CHECK_EQUAL(resolveSync(&loop, &resolver, "example.test"), "");
+  BOOST_CHECK_EQUAL(resolver.queriesSent(), 0);
+}
+
+BOOST_AUTO_TEST_CASE(testTcpClientByHostname)
+{
+  EventLoop loop;
+  StubDns dns(&loop);
+  Record record;
+  record.a.push_back("127.0.0.1");
+  record.ttl = 300;
+  dns.add("svc.example.test", record);
+  Resolver resolver(&loop, stubOptions(dns.address()));
+
+  InetAddress serverAddr("127.0.0.1", 29983);
+  TcpServer server(&loop, serverAddr, "Server");
+  server.start();
+  TcpClient client(&loop, &resolver, "svc.example.test", serverAddr.port(), "Client");
+  bool connected = false;
+  client.setConnectionCallback([&](const TcpConnectionPtr& conn) {
+    if (conn->connected())
+    {
+      connected = true;
+      BOOST_CHECK_EQUAL(conn->peerAddress().toIpPort(), serverAddr.toIpPort());
+    }
+    loop.quit();
+  });
+  client.connect();
+  TimerId timer = loop.runAfter(5.0, [&loop] { loop.quit(); });
+  loop.loop();
+  BOOST_REQUIRE(connected);
+
+  // closes while the loop runs, or the close is left in its queue
+  client.disconnect();
+  loop.loop();
+  loop.cancel(timer);
+}
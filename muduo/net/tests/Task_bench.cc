@@ -0,0 +1,154 @@
+// Counts heap allocations and time per posted task, for a typical
+// std::bind of a member function, a shared_ptr and two ints, posted
+// as muduo::Task directly, or wrapped in a std::function as before.
+//
+// usage: task_bench [tasks]
+
+#include "muduo/base/Atomic.h"
+#include "muduo/base/CountDownLatch.h"
+#include "muduo/base/Task.h"
+#include "muduo/base/ThreadPool.h"
+#include "muduo/base/Timestamp.h"
+#include "muduo/net/EventLoop.h"
+#include "muduo/net/EventLoopThread.h"
+
+#include <atomic>
+#include <functional>
+#include <memory>
+#include <new>
+
+#include <inttypes.h>
+#include <sched.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+using namespace muduo;
+using namespace muduo::net;
+
+std::atomic<int64_t> g_allocations(0);
+
+void* operator new(size_t size)
+{
+  g_allocations.fetch_add(1, std::memory_order_relaxed);
+  void* p = ::malloc(size ? size : 1);
+  if (p == NULL)
+  {
+    throw std::bad_alloc();
+  }
+  return p;
+}
+
+void operator delete(void* p) noexcept
+{
+  ::free(p);
+}
+
+void operator delete(void* p, size_t) noexcept
+{
+  ::free(p);
+}
+
+class Counter
+{
+ public:
+  void add(int x, int y)
+  {
+    sum_ += x + y;
+    latch_->countDown();
+  }
+
+  void reset(CountDownLatch* latch) { latch_ = latch; }
+  int64_t sum() const { return sum_; }
+
+ private:
+  int64_t sum_ = 0;
+  CountDownLatch* latch_ = NULL;
+};
+
+void report(const char* what, int n, int64_t allocations, Timestamp start)
+{
+  double us = timeDifference(Timestamp::now(), start) * 1e6;
+  printf("%-36s %6.2f allocations %8.1f ns per task\n", what,
+         static_cast<double>(allocations) / n, us * 1000 / n);
+}
+
+// f makes a task of i, post posts it
+template<typename MakeTask, typename Post>
+void bench(const char* what, int n, const std::shared_ptr<Counter>& counter,
+           MakeTask f, Post post)
+{
+  CountDownLatch latch(n);
+  counter->reset(&latch);
+  Timestamp start(Timestamp::now());
+  int64_t before = g_allocations.load();
+  for (int i = 0; i < n; ++i)
+  {
+    post(f(i));
+  }
+  // only the posting thread allocates
+  int64_t allocations = g_allocations.load() - before;
+  latch.wait();
+  report(what, n, allocations, start);
+}
+
+int main(int argc, char* argv[])
+{
+  const int n = argc > 1 ? atoi(argv[1]) : 1000000;
+  auto counter = std::make_shared<Counter>();
+  auto makeBind = [&counter](int i) {
+    return std::bind(&Counter::add, counter, i, i);
+  };
+  auto makeFunction = [&counter](int i) {
+    return std::function<void()>(std::bind(&Counter::add, counter, i, i));
+  };
+  printf("sizeof(Task) = %zd, sizeof(std::function) = %zd, sizeof(bind) = %zd\n",
+         sizeof(Task), sizeof(std::function<void()>), sizeof(makeBind(0)));
+
+  {
+    CountDownLatch latch(2*n);
+    counter->reset(&latch);
+    Timestamp start(Timestamp::now());
+    int64_t before = g_allocations.load();
+    for (int i = 0; i < n; ++i)
+    {
+      Task t(makeBind(i));
+      t();
+    }
+    report("make Task", n, g_allocations.load() - before, start);
+    start = Timestamp::now();
+    before = g_allocations.load();
+    for (int i = 0; i < n; ++i)
+    {
+      std::function<void()> f(makeBind(i));
+      f();
+    }
+    report("make std::function", n, g_allocations.load() - before, start);
+  }
+
+  {
+    EventLoopThread thread;
+    EventLoop* loop = thread.startLoop();
+    auto post = [loop](Task&& t) { loop->queueInLoop(std::move(t)); };
+    bench("EventLoop::queueInLoop Task", n, counter, makeBind, post);
+    bench("EventLoop::queueInLoop std::function", n, counter, makeFunction, post);
+    // steady state, the loop keeps up and its queue reuses nodes
+    auto paced = [loop](Task&& t) {
+      while (loop->queueSize() > 256)
+      {
+        ::sched_yield();
+      }
+      loop->queueInLoop(std::move(t));
+    };
+    bench("EventLoop::queueInLoop Task, paced", n, counter, makeBind, paced);
+  }
+
+  {
+    ThreadPool pool("TaskBench");
+    pool.start(1);
+    auto post = [&pool](Task&& t) { pool.run(std::move(t)); };
+    bench("ThreadPool::run Task", n, counter, makeBind, post);
+    bench("ThreadPool::run std::function", n, counter, makeFunction, post);
+    pool.stop();
+  }
+  printf("sum = %" PRId64 "\n", counter->sum());
+}
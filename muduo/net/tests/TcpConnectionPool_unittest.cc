@@ -0,0 +1,250 @@
+#include "muduo/net/TcpConnectionPool.h"
+
+#include "muduo/net/EventLoop.h"
+#include "muduo/net/EventLoopThreadPool.h"
+#include "muduo/net/TcpServer.h"
+
+#include <atomic>
+#include <set>
+
+//#define BOOST_TEST_MODULE TcpConnectionPoolTest
+#define BOOST_TEST_MAIN
+#define BOOST_TEST_DYN_LINK
+#include <boost/test/unit_test.hpp>
+
+using namespace muduo;
+using namespace muduo::net;
+
+namespace
+{
+
+void onEcho(const TcpConnectionPtr& conn, Buffer* buf, Timestamp)
+{
+  conn->send(buf);
+}
+
+// runs loop till pred() or timeout, returns pred()
+bool waitFor(EventLoop* loop, const std::function<bool ()>& pred, double seconds = 5.0)
+{
+  if (pred())
+  {
+    return true;
+  }
+  Timestamp deadline = addTime(Timestamp::now(), seconds);
+  TimerId timer = loop->runEvery(0.01, [&] {
+    if (pred() || Timestamp::now() > deadline)
+    {
+      loop->quit();
+    }
+  });
+  loop->loop();
+  loop->cancel(timer);
+  return pred();
+}
+
+// an echo server, and a pool of three connections to it over two loops
+struct Fixture
+{
+  explicit Fixture(uint16_t port,
+                   const TcpConnectionPool::Options& options = TcpConnectionPool::Options())
+    : serverAddr("127.0.0.1", port),
+      server(&loop, serverAddr, "EchoServer"),
+      threadPool(new EventLoopThreadPool(&loop, "PoolLoops")),
+      pool(new TcpConnectionPool(&loop, "Pool", options))
+  {
+    server.setMessageCallback(onEcho);
+    server.start();
+    threadPool->setThreadNum(2);
+    threadPool->start();
+    pool->setThreadPool(threadPool);
+    pool->addEndpoint(serverAddr, 3);
+  }
+
+  ~Fixture()
+  {
+    // closes connections in their loops, which must run till they are done
+    pool.reset();
+    waitFor(&loop, [this] { return server.stats().connections == 0; });
+  }
+
+  void start()
+  {
+    pool->start();
+    BOOST_REQUIRE(waitFor(&loop, [this] { return pool->stats().idle == 3; }));
+  }
+
+  EventLoop loop;
+  InetAddress serverAddr;
+  TcpServer server;
+  std::shared_ptr<EventLoopThreadPool> threadPool;
+  std::unique_ptr<TcpConnectionPool> pool;
+};
+
+}  // namespace
+
+BOOST_AUTO_TEST_CASE(testLeaseAndRelease)
+{
+  Fixture f(29991);
+  std::atomic<int> echoed(0);
+  std::set<EventLoop*> loops;
+  f.pool->setConnectionCallback([&](const TcpConnectionPtr& conn) {
+    if (conn->connected())
+    {
+      conn->setContext(string("ready"));
+    }
+  });
+  f.pool->setMessageCallback([&](const TcpConnectionPtr& conn, Buffer* buf, Timestamp) {
+    echoed += static_cast<int>(buf->readableBytes());
+    buf->retrieveAll();
+    (void)conn;
+  });
+  f.start();
+
+  std::vector<TcpConnectionPtr> leased;
+  for (int i = 0; i < 3; ++i)
+  {
+    TcpConnectionPtr conn = f.pool->tryAcquire(f.serverAddr);
+    BOOST_REQUIRE(conn);
+    BOOST_CHECK(conn->connected());
+    BOOST_CHECK_EQUAL(boost::any_cast<string>(conn->getContext()), "ready");
+    loops.insert(conn->getLoop());
+    conn->send("hello");
+    leased.push_back(conn);
+  }
+  BOOST_CHECK_EQUAL(loops.size(), 2u);
+  BOOST_CHECK(!f.pool->tryAcquire(f.serverAddr));
+  BOOST_CHECK(!f.pool->tryAcquire(InetAddress("127.0.0.1", 1)));
+
+  TcpConnectionPool::Stats stats = f.pool->stats(f.serverAddr);
+  BOOST_CHECK_EQUAL(stats.connections, 3);
+  BOOST_CHECK_EQUAL(stats.connected, 3);
+  BOOST_CHECK_EQUAL(stats.leased, 3);
+  BOOST_CHECK_EQUAL(stats.idle, 0);
+  BOOST_CHECK_EQUAL(stats.acquires, 3);
+  BOOST_CHECK_EQUAL(stats.failures, 1);
+
+  BOOST_CHECK(waitFor(&f.loop, [&] { return echoed == 15; }));
+
+  f.pool->release(leased[1]);
+  BOOST_CHECK_EQUAL(f.pool->stats().idle, 1);
+  BOOST_CHECK(f.pool->tryAcquire(f.serverAddr) == leased[1]);
+  for (const TcpConnectionPtr& conn : leased)
+  {
+    f.pool->release(conn);
+  }
+  BOOST_CHECK_EQUAL(f.pool->stats().idle, 3);
+}
+
+BOOST_AUTO_TEST_CASE(testAcquireWaits)
+{
+  TcpConnectionPool::Options options;
+  options.acquireTimeout = 0.2;
+  options.maxWaiters = 1;
+  Fixture f(29992, options);
+  f.start();
+
+  std::vector<TcpConnectionPtr> leased;
+  for (int i = 0; i < 3; ++i)
+  {
+    f.pool->acquire(f.serverAddr, [&](const TcpConnectionPtr& conn) { leased.push_back(conn); });
+  }
+  BOOST_REQUIRE_EQUAL(leased.size(), 3u);
+
+  // served by release
+  TcpConnectionPtr waited;
+  f.pool->acquire(f.serverAddr, [&](const TcpConnectionPtr& conn) { waited = conn; });
+  BOOST_CHECK(!waited);
+  BOOST_CHECK_EQUAL(f.pool->stats().waiters, 1);
+  // too many waiters
+  bool rejected = false;
+  f.pool->acquire(f.serverAddr, [&](const TcpConnectionPtr& conn) { rejected = !conn; });
+  BOOST_CHECK(rejected);
+  f.pool->release(leased[0]);
+  BOOST_CHECK(waited == leased[0]);
+  BOOST_CHECK_EQUAL(f.pool->stats().waiters, 0);
+
+  // timed out
+  bool called = false;
+  f.pool->acquire(f.serverAddr, [&](const TcpConnectionPtr& conn) {
+    called = true;
+    BOOST_CHECK(!conn);
+  });
+  BOOST_CHECK(waitFor(&f.loop, [&] { return called; }));
+
+  TcpConnectionPool::Stats stats = f.pool->stats();
+  BOOST_CHECK_EQUAL(stats.acquires, 4);
+  BOOST_CHECK_EQUAL(stats.waits, 3);
+  BOOST_CHECK_EQUAL(stats.failures, 2);
+  BOOST_CHECK_EQUAL(stats.leased, 3);
+}
+
+BOOST_AUTO_TEST_CASE(testReplaceClosed)
+{
+  Fixture f(29993);
+  f.start();
+
+  // closed by peer
+  TcpConnectionPtr conn = f.pool->tryAcquire(f.serverAddr);
+  BOOST_REQUIRE(conn);
+  conn->shutdown();
+  BOOST_CHECK(waitFor(&f.loop, [&] { return conn->disconnected(); }));
+  f.pool->release(conn);  // no effect
+  BOOST_CHECK(waitFor(&f.loop, [&] { return f.pool->stats().idle == 3; }));
+
+  // closed by us
+  conn = f.pool->tryAcquire(f.serverAddr);
+  BOOST_REQUIRE(conn);
+  f.pool->release(conn, false);
+  BOOST_CHECK(waitFor(&f.loop, [&] { return conn->disconnected(); }));
+  BOOST_CHECK(waitFor(&f.loop, [&] { return f.pool->stats().idle == 3; }));
+  BOOST_CHECK_EQUAL(f.pool->stats().reconnects, 2);
+}
+
+BOOST_AUTO_TEST_CASE(testHealthCheck)
+{
+  TcpConnectionPool::Options options;
+  options.healthCheckInterval = 0.05;
+  Fixture f(29994, options);
+  std::atomic<int> checks(0);
+  f.pool->setHealthCheck([&](const TcpConnectionPtr& conn) {
+    BOOST_CHECK(conn->getLoop()->isInLoopThread());
+    // fails the first one
+    return ++checks != 1;
+  });
+  f.start();
+
+  BOOST_CHECK(waitFor(&f.loop, [&] {
+    TcpConnectionPool::Stats stats = f.pool->stats();
+    return stats.reconnects == 1 && stats.idle == 3 && checks > 6;
+  }));
+  BOOST_CHECK_EQUAL(f.pool->stats().healthCheckFailures, 1);
+
+  // leased ones are not checked
+  std::vector<TcpConnectionPtr> leased;
+  for (int i = 0; i < 3; ++i)
+  {
+    leased.push_back(f.pool->tryAcquire(f.serverAddr));
+  }
+  int before = checks;
+  waitFor(&f.loop, [] { return false; }, 0.2);
+  BOOST_CHECK_EQUAL(checks, before);
+}
+
+BOOST_AUTO_TEST_CASE(testReconnectBackoff)
+{
+  Fixture f(29995);
+  // a server which closes each connection at once
+  f.server.setConnectionCallback([](const TcpConnectionPtr& conn) {
+    if (conn->connected())
+    {
+      conn->forceClose();
+    }
+  });
+  f.pool->start();
+
+  // 0.1, 0.2, 0.4 and 0.8 seconds apart, instead of every 0.1 second
+  waitFor(&f.loop, [] { return false; }, 1.0);
+  TcpConnectionPool::Stats stats = f.pool->stats();
+  BOOST_CHECK_GE(stats.reconnects, 6);
+  BOOST_CHECK_LE(stats.reconnects, 12);
+}
@@ -0,0 +1,377 @@
+#include "muduo/net/TcpConnection.h"
+
+#include "muduo/base/Thread.h"
+#include "muduo/net/EventLoop.h"
+#include "muduo/net/TcpClient.h"
+#include "muduo/net/TcpServer.h"
+
+#include <netinet/in.h>
+#include <stdio.h>
+#include <string.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+//#define BOOST_TEST_MODULE TcpConnectionTest
+#define BOOST_TEST_MAIN
+#define BOOST_TEST_DYN_LINK
+#include <boost/test/unit_test.hpp>
+
+using namespace muduo;
+using namespace muduo::net;
+
+namespace
+{
+
+const int kMessages = 600;
+
+string message(int i)
+{
+  // every 4th is big, to be spliced
+  return string(i % 4 == 3 ? 8*1024 : 16, static_cast<char>('a' + i % 26));
+}
+
+// from another thread, by each kind of send, in order
+void sendAll(const TcpConnectionPtr& conn)
+{
+  char path[] = "/tmp/tcpconnection_unittestXXXXXX";
+  int fd = ::mkstemp(path);
+  BOOST_REQUIRE(fd >= 0);
+  ::unlink(path);
+
+  for (int i = 0; i < kMessages; ++i)
+  {
+    string msg = message(i);
+    switch (i % 6)
+    {
+      case 0:
+        conn->send(msg);
+        break;
+      case 1:
+        conn->send(std::move(msg));
+        break;
+      case 2:
+      {
+        Buffer buf;
+        buf.append(msg);
+        conn->send(std::move(buf));
+        break;
+      }
+      case 3:
+      {
+        Buffer buf;
+        buf.append(msg);
+        conn->send(&buf);
+        BOOST_CHECK_EQUAL(buf.readableBytes(), 0u);
+        break;
+      }
+      case 4:
+      {
+        std::unique_ptr<char[]> data(new char[msg.size()]);
+        memcpy(data.get(), msg.data(), msg.size());
+        conn->send(std::move(data), msg.size());
+        break;
+      }
+      case 5:
+      {
+        off_t offset = ::lseek(fd, 0, SEEK_END);
+        BOOST_REQUIRE_EQUAL(::write(fd, msg.data(), msg.size()),
+                            static_cast<ssize_t>(msg.size()));
+        conn->sendFile(fd, offset, msg.size());
+        break;
+      }
+    }
+  }
+  ::close(fd);
+}
+
+// Closes the connection while the loop runs, or its close is left in the
+// queue, and destroyed with the loop. The connection callback quits.
+void disconnect(EventLoop* loop, TcpClient* client)
+{
+  TimerId timer = loop->runAfter(5.0, [loop] { loop->quit(); });
+  client->disconnect();
+  loop->loop();
+  loop->cancel(timer);
+}
+
+}  // namespace
+
+BOOST_AUTO_TEST_CASE(testSendFromOtherThread)
+{
+  string expected;
+  for (int i = 0; i < kMessages; ++i)
+  {
+    expected += message(i);
+  }
+
+  EventLoop loop;
+  InetAddress serverAddr("127.0.0.1", 29981);
+  TcpServer server(&loop, serverAddr, "SendServer");
+  std::unique_ptr<Thread> sender;
+  server.setConnectionCallback(
+      [&sender](const TcpConnectionPtr& conn) {
+        if (conn->connected())
+        {
+          sender.reset(new Thread(std::bind(sendAll, conn), "sender"));
+          sender->start();
+        }
+      });
+  server.start();
+
+  TcpClient client(&loop, serverAddr, "SendClient");
+  client.setConnectionCallback(
+      [&loop](const TcpConnectionPtr& conn) {
+        if (!conn->connected())
+        {
+          loop.quit();
+        }
+      });
+  string received;
+  client.setMessageCallback(
+      [&](const TcpConnectionPtr&, Buffer* buf, Timestamp) {
+        received += buf->retrieveAllAsString();
+        if (received.size() >= expected.size())
+        {
+          loop.quit();
+        }
+      });
+  client.connect();
+  loop.runAfter(5.0, [&loop] { loop.quit(); });
+  loop.loop();
+
+  BOOST_REQUIRE(sender);
+  sender->join();
+  sender.reset();  // which holds the server side connection
+  BOOST_CHECK_EQUAL(received.size(), expected.size());
+  BOOST_CHECK(received == expected);
+  disconnect(&loop, &client);
+}
+
+BOOST_AUTO_TEST_CASE(testUnixDomain)
+{
+  char path[64];
+  snprintf(path, sizeof path, "/tmp/tcpconnection_unittest.%d.sock", ::getpid());
+  char abstract[64];
+  snprintf(abstract, sizeof abstract, "@tcpconnection_unittest.%d", ::getpid());
+  const char* names[] = { path, abstract };
+  for (const char* name : names)
+  {
+    EventLoop loop;
+    InetAddress serverAddr(InetAddress::unixDomain(name));
+    TcpServer server(&loop, serverAddr, "UnixServer");
+    struct ucred cred;
+    bool credOk = false;
+    server.setConnectionCallback(
+        [&](const TcpConnectionPtr& conn) {
+          if (conn->connected())
+          {
+            credOk = conn->getPeerCredentials(&cred);
+            BOOST_CHECK_EQUAL(conn->localAddress().unixPath(), string(name));
+          }
+        });
+    server.setMessageCallback(
+        [](const TcpConnectionPtr& conn, Buffer* buf, Timestamp) {
+          conn->send(buf);
+        });
+    server.start();
+
+    TcpClient client(&loop, serverAddr, "UnixClient");
+    string received;
+    client.setConnectionCallback(
+        [&loop](const TcpConnectionPtr& conn) {
+          if (conn->connected())
+          {
+            BOOST_CHECK_EQUAL(conn->peerAddress().toIpPort(), "unix:" + conn->peerAddress().unixPath());
+            conn->send(message(3));
+          }
+          else
+          {
+            loop.quit();
+          }
+        });
+    client.setMessageCallback(
+        [&](const TcpConnectionPtr&, Buffer* buf, Timestamp) {
+          received += buf->retrieveAllAsString();
+          if (received.size() >= message(3).size())
+          {
+            loop.quit();
+          }
+        });
+    client.connect();
+    loop.runAfter(5.0, [&loop] { loop.quit(); });
+    loop.loop();
+
+    BOOST_CHECK(received == message(3));
+    BOOST_REQUIRE(credOk);
+    BOOST_CHECK_EQUAL(cred.pid, ::getpid());
+    BOOST_CHECK_EQUAL(cred.uid, ::getuid());
+    disconnect(&loop, &client);
+  }
+  // removed with the acceptor
+  BOOST_CHECK_NE(::access(path, F_OK), 0);
+}
+
+BOOST_AUTO_TEST_CASE(testZeroCopyOffOnLoopback)
+{
+  EventLoop loop;
+  InetAddress serverAddr("127.0.0.1", 29982);
+  TcpServer server(&loop, serverAddr, "ZeroCopyServer");
+  size_t received = 0;
+  server.setMessageCallback(
+      [&received](const TcpConnectionPtr&, Buffer* buf, Timestamp) {
+        received += buf->readableBytes();
+        buf->retrieveAll();
+      });
+  server.start();
+
+  const size_t kBytes = 64 * message(3).size();
+  TcpClient client(&loop, serverAddr, "ZeroCopyClient");
+  bool zeroCopy = false;
+  client.setConnectionCallback(
+      [&](const TcpConnectionPtr& conn) {
+        if (conn->connected())
+        {
+          conn->setZeroCopy(true, 1);
+          zeroCopy = conn->zeroCopy();
+          for (size_t sent = 0; sent < kBytes; sent += message(3).size())
+          {
+            Buffer buf;
+            buf.append(message(3));
+            conn->send(&buf);
+          }
+        }
+        else
+        {
+          loop.quit();
+        }
+      });
+  client.connect();
+  // till all arrived, and the kernel told it copied them
+  TimerId timer = loop.runEvery(0.01, [&] {
+    TcpConnectionPtr conn = client.connection();
+    if (received >= kBytes && !(conn && conn->zeroCopy()))
+    {
+      loop.quit();
+    }
+  });
+  loop.runAfter(5.0, [&loop] { loop.quit(); });
+  loop.loop();
+  loop.cancel(timer);
+
+  BOOST_CHECK_EQUAL(received, kBytes);
+  if (zeroCopy)
+  {
+    // SO_ZEROCOPY is supported, but loopback always copies
+    BOOST_CHECK(!client.connection()->zeroCopy());
+  }
+  disconnect(&loop, &client);
+}
+
+BOOST_AUTO_TEST_CASE(testEdgeTriggered)
+{
+  // far more than kMaxIoPerEvent reads of up to 64k each, so both sides
+  // drain till EAGAIN, and yield to other channels on the way
+  const size_t kBytes = 8 * 1024 * 1024;
+  string data(kBytes, '\0');
+  for (size_t i = 0; i < kBytes; ++i)
+  {
+    data[i] = static_cast<char>(i % 251);
+  }
+
+  EventLoop loop;
+  InetAddress serverAddr("127.0.0.1", 29984);
+  TcpServer server(&loop, serverAddr, "EdgeServer");
+  server.setEdgeTriggered(true);
+  size_t serverReceived = 0;
+  server.setMessageCallback(
+      [&serverReceived](const TcpConnectionPtr& conn, Buffer* buf, Timestamp) {
+        serverReceived += buf->readableBytes();
+        conn->send(buf);
+      });
+  server.start();
+
+  TcpClient client(&loop, serverAddr, "EdgeClient");
+  client.setEdgeTriggered(true);
+  client.setConnectionCallback(
+      [&](const TcpConnectionPtr& conn) {
+        if (conn->connected())
+        {
+          conn->send(data);
+        }
+        else
+        {
+          loop.quit();
+        }
+      });
+  string received;
+  client.setMessageCallback(
+      [&](const TcpConnectionPtr&, Buffer* buf, Timestamp) {
+        received += buf->retrieveAllAsString();
+        if (received.size() >= kBytes)
+        {
+          loop.quit();
+        }
+      });
+  client.connect();
+  loop.runAfter(10.0, [&loop] { loop.quit(); });
+  loop.loop();
+
+  BOOST_CHECK_EQUAL(serverReceived, kBytes);
+  BOOST_CHECK_EQUAL(received.size(), kBytes);
+  BOOST_CHECK(received == data);
+  disconnect(&loop, &client);
+}
+
+BOOST_AUTO_TEST_CASE(testStopRead)
+{
+  const string chunk(64 * 1024, 'x');
+  EventLoop loop;
+  InetAddress serverAddr("127.0.0.1", 29986);
+  TcpServer server(&loop, serverAddr, "StopReadServer");
+  // blocking, so that it writes at once, unlike a TcpConnection with io_uring
+  int client = ::socket(AF_INET, SOCK_STREAM, 0);
+  BOOST_REQUIRE(client >= 0);
+  size_t received = 0;
+  bool stopped = false;
+  bool restarted = false;
+  int messagesWhileStopped = 0;
+  server.setMessageCallback(
+      [&](const TcpConnectionPtr& conn, Buffer* buf, Timestamp) {
+        received += buf->readableBytes();
+        buf->retrieveAll();
+        if (stopped)
+        {
+          ++messagesWhileStopped;
+        }
+        else if (!restarted)
+        {
+          stopped = true;
+          conn->stopRead();
+          // arrives at once on loopback, eg. into a recv not yet canceled
+          BOOST_CHECK_EQUAL(::write(client, chunk.data(), chunk.size()),
+                            static_cast<ssize_t>(chunk.size()));
+          loop.runAfter(0.2, [&stopped, &restarted, conn] {
+            stopped = false;
+            restarted = true;
+            conn->startRead();
+          });
+        }
+        if (received >= 2 * chunk.size())
+        {
+          loop.quit();
+        }
+      });
+  server.start();
+
+  BOOST_REQUIRE_EQUAL(::connect(client, serverAddr.getSockAddr(),
+                                static_cast<socklen_t>(sizeof(struct sockaddr_in))), 0);
+  BOOST_REQUIRE_EQUAL(::write(client, chunk.data(), chunk.size()),
+                      static_cast<ssize_t>(chunk.size()));
+  loop.runAfter(5.0, [&loop] { loop.quit(); });
+  loop.loop();
+
+  BOOST_CHECK(restarted);
+  BOOST_CHECK_EQUAL(messagesWhileStopped, 0);
+  BOOST_CHECK_EQUAL(received, 2 * chunk.size());
+  ::close(client);
+}
@@ -0,0 +1,146 @@
+#include "muduo/net/TcpServer.h"
+
+#include "muduo/net/EventLoop.h"
+
+#include <atomic>
+#include <map>
+#include <set>
+#include <vector>
+
+#include <netinet/in.h>
+#include <stdio.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+//#define BOOST_TEST_MODULE TcpServerTest
+#define BOOST_TEST_MAIN
+#define BOOST_TEST_DYN_LINK
+#include <boost/test/unit_test.hpp>
+
+using namespace muduo;
+using namespace muduo::net;
+
+namespace
+{
+
+// runs loop till pred() or timeout, returns pred()
+bool waitFor(EventLoop* loop, const std::function<bool ()>& pred, double seconds = 5.0)
+{
+  if (pred())
+  {
+    return true;
+  }
+  Timestamp deadline = addTime(Timestamp::now(), seconds);
+  TimerId timer = loop->runEvery(0.01, [&] {
+    if (pred() || Timestamp::now() > deadline)
+    {
+      loop->quit();
+    }
+  });
+  loop->loop();
+  loop->cancel(timer);
+  return pred();
+}
+
+// a blocking client socket
+int connectTo(const InetAddress& addr)
+{
+  int sockfd = ::socket(addr.family(), SOCK_STREAM, 0);
+  BOOST_REQUIRE(sockfd >= 0);
+  const size_t addrlen = addr.family() == AF_UNIX ? sizeof(struct sockaddr_un)
+                                                  : sizeof(struct sockaddr_in);
+  BOOST_REQUIRE_EQUAL(::connect(sockfd, addr.getSockAddr(),
+                                static_cast<socklen_t>(addrlen)), 0);
+  return sockfd;
+}
+
+}  // namespace
+
+BOOST_AUTO_TEST_CASE(testShards)
+{
+  const int kLoops = 3;
+  const int kClients = 6;
+  EventLoop loop;
+  InetAddress serverAddr("127.0.0.1", 29985);
+  std::unique_ptr<TcpServer> server(new TcpServer(&loop, serverAddr, "ShardServer"));
+  server->setThreadNum(kLoops);
+  std::atomic<int> up(0);
+  std::atomic<int> down(0);
+  server->setConnectionCallback([&](const TcpConnectionPtr& conn) {
+    ++(conn->connected() ? up : down);
+  });
+  server->start();
+
+  std::vector<int> clients;
+  for (int i = 0; i < kClients; ++i)
+  {
+    clients.push_back(connectTo(serverAddr));
+  }
+  BOOST_REQUIRE(waitFor(&loop, [&] { return server->stats().connections == kClients; }));
+  BOOST_CHECK_EQUAL(up, kClients);
+
+  // each one once, from its own loop, spread over all loops
+  std::map<uint64_t, int> visits;
+  std::map<EventLoop*, int> perLoop;
+  std::vector<std::weak_ptr<TcpConnection>> conns;
+  server->forEachConnection([&](const TcpConnectionPtr& conn) {
+    BOOST_CHECK(conn->getLoop()->isInLoopThread());
+    ++visits[conn->id()];
+    ++perLoop[conn->getLoop()];
+    conns.push_back(conn);
+  });
+  BOOST_CHECK_EQUAL(visits.size(), static_cast<size_t>(kClients));
+  for (const auto& item : visits)
+  {
+    BOOST_CHECK_EQUAL(item.second, 1);
+  }
+  BOOST_CHECK_EQUAL(perLoop.size(), static_cast<size_t>(kLoops));
+  for (const auto& item : perLoop)
+  {
+    BOOST_CHECK_EQUAL(item.second, kClients / kLoops);
+  }
+
+  // closed by peers, removed from their shards
+  ::close(clients[0]);
+  ::close(clients[1]);
+  BOOST_CHECK(waitFor(&loop, [&] { return server->stats().connections == kClients - 2; }));
+  BOOST_CHECK_EQUAL(down, 2);
+  TcpServer::Stats stats = server->stats();
+  BOOST_CHECK_EQUAL(stats.accepted, kClients);
+  int visited = 0;
+  server->forEachConnection([&visited](const TcpConnectionPtr&) { ++visited; });
+  BOOST_CHECK_EQUAL(visited, kClients - 2);
+
+  // the rest are destroyed with the server, in their loops
+  server.reset();
+  BOOST_CHECK_EQUAL(down, kClients);
+  for (const auto& conn : conns)
+  {
+    BOOST_CHECK(conn.expired());
+  }
+  for (size_t i = 2; i < clients.size(); ++i)
+  {
+    ::close(clients[i]);
+  }
+}
+
+BOOST_AUTO_TEST_CASE(testUnixDomainReusePort)
+{
+  char path[64];
+  snprintf(path, sizeof path, "/tmp/tcpserver_unittest.%d.sock", ::getpid());
+  EventLoop loop;
+  InetAddress serverAddr(InetAddress::unixDomain(path));
+  {
+    // one acceptor for the path, instead of one per loop
+    TcpServer server(&loop, serverAddr, "UnixServer", TcpServer::kReusePortPerLoop);
+    server.setThreadNum(2);
+    server.start();
+
+    int client = connectTo(serverAddr);
+    BOOST_CHECK(waitFor(&loop, [&] { return server.stats().connections == 1; }));
+    ::close(client);
+    BOOST_CHECK(waitFor(&loop, [&] { return server.stats().connections == 0; }));
+  }
+  BOOST_CHECK_NE(::access(path, F_OK), 0);
+}
@@ -0,0 +1,78 @@
+// Compares timer containers of EventLoop with many timers.
+
+#include "muduo/net/EventLoop.h"
+#include "muduo/base/Timestamp.h"
+
+#include <random>
+#include <vector>
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+
+using namespace muduo;
+using namespace muduo::net;
+
+int g_fired = 0;
+
+void printRate(const char* what, Timestamp start, int n)
+{
+  double us = timeDifference(Timestamp::now(), start) * 1e6;
+  printf("  %-24s %8.1f ns/op\n", what, us * 1000 / n);
+}
+
+void bench(EventLoop::TimerOption option, int numTimers)
+{
+  printf("%s, %d timers\n", option == EventLoop::kTimingWheel ? "timing wheel" : "timer set", numTimers);
+  EventLoop loop(option);
+  std::mt19937 gen(42);
+  std::uniform_real_distribution<double> longDelay(1.0, 60.0);
+  std::vector<TimerId> timers(numTimers);
+
+  Timestamp start(Timestamp::now());
+  for (int i = 0; i < numTimers; ++i)
+  {
+    timers[i] = loop.runAfter(longDelay(gen), [] { ++g_fired; });
+  }
+  printRate("runAfter", start, numTimers);
+
+  // idle timeouts of connections, restarted on every message
+  start = Timestamp::now();
+  for (int i = 0; i < numTimers; ++i)
+  {
+    loop.cancel(timers[i]);
+    timers[i] = loop.runAfter(longDelay(gen), [] { ++g_fired; });
+  }
+  printRate("cancel + runAfter", start, numTimers);
+
+  start = Timestamp::now();
+  for (int i = 0; i < numTimers; ++i)
+  {
+    loop.cancel(timers[i]);
+  }
+  printRate("cancel", start, numTimers);
+
+  // all expire in one handleRead(), as they are due before loop()
+  std::uniform_real_distribution<double> shortDelay(0.0, 0.1);
+  g_fired = 0;
+  for (int i = 0; i < numTimers; ++i)
+  {
+    loop.runAfter(shortDelay(gen), [&loop, numTimers] {
+      if (++g_fired == numTimers)
+      {
+        loop.quit();
+      }
+    });
+  }
+  usleep(200*1000);
+  start = Timestamp::now();
+  loop.loop();
+  printRate("expire", start, numTimers);
+}
+
+int main(int argc, char* argv[])
+{
+  int numTimers = argc > 1 ? atoi(argv[1]) : 1000*1000;
+  bench(EventLoop::kTimerSet, numTimers);
+  bench(EventLoop::kTimingWheel, numTimers);
+}
@@ -2,6 +2,8 @@
 #include "muduo/net/EventLoopThread.h"
 #include "muduo/base/Thread.h"
 
+#include <vector>
+
 #include <stdio.h>
 #include <unistd.h>
 
@@ -32,8 +34,84 @@ void cancel(TimerId timer)
   printf("cancelled at %s\n", Timestamp::now().toString().c_str());
 }
 
+int g_failures = 0;
+
+void check(bool ok, const char* what)
+{
+  if (!ok)
+  {
+    printf("FAILED %s\n", what);
+    ++g_failures;
+  }
+}
+
+// checks itself, for each kind of TimerQueue
+void testTimerQueue(EventLoop::TimerOption option, const char* name)
+{
+  printf("testTimerQueue %s\n", name);
+  EventLoop loop(option);
+  const Timestamp start(Timestamp::now());
+
+  // fire order, across slots of the first two levels of the wheel
+  const double delays[] = { 0.05, 0.01, 0.2, 0.03, 0.07, 0.1 };
+  const std::vector<int> expected = { 1, 3, 0, 4, 5, 2 };
+  std::vector<int> fired;
+  for (int i = 0; i < 6; ++i)
+  {
+    loop.runAfter(delays[i], [&fired, i] { fired.push_back(i); });
+  }
+
+  // beyond 4096 ticks of the second level, cascaded down from the third
+  Timestamp late1, late2;
+  loop.runAfter(4.3, [&late2] { late2 = Timestamp::now(); });
+  loop.runAfter(4.2, [&late1] { late1 = Timestamp::now(); });
+
+  int every = 0;
+  TimerId everyTimer = loop.runEvery(0.1, [&every] { ++every; });
+  loop.runAfter(1.05, [&loop, everyTimer] { loop.cancel(everyTimer); });
+
+  // cancels itself from its callback
+  int selfCanceled = 0;
+  TimerId self;
+  self = loop.runEvery(0.02, [&] {
+    if (++selfCanceled == 3)
+    {
+      loop.cancel(self);
+    }
+  });
+
+  // canceled from another callback
+  bool canceledFired = false;
+  TimerId canceled = loop.runAfter(0.5, [&canceledFired] { canceledFired = true; });
+  loop.runAfter(0.3, [&loop, canceled] { loop.cancel(canceled); });
+
+  // canceled after it expired, which does nothing
+  bool expiredFired = false;
+  TimerId expired = loop.runAfter(0.01, [&expiredFired] { expiredFired = true; });
+  loop.runAfter(0.1, [&loop, expired] {
+    loop.cancel(expired);
+    loop.cancel(expired);
+  });
+
+  loop.runAfter(4.5, [&loop] { loop.quit(); });
+  loop.loop();
+
+  check(fired == expected, "fire order");
+  check(late1.valid() && timeDifference(late1, start) >= 4.2, "4.2s not early");
+  check(late1.valid() && timeDifference(late1, start) < 4.3, "4.2s on time");
+  check(late2.valid() && timeDifference(late2, start) >= 4.3, "4.3s not early");
+  check(late2.valid() && timeDifference(late2, start) < 4.4, "4.3s on time");
+  check(every == 10, "runEvery");
+  check(selfCanceled == 3, "cancel from its callback");
+  check(!canceledFired, "cancel from another callback");
+  check(expiredFired, "cancel after expired");
+}
+
 int main()
 {
+  testTimerQueue(EventLoop::kTimerSet, "kTimerSet");
+  testTimerQueue(EventLoop::kTimingWheel, "kTimingWheel");
+
   printTid();
   sleep(1);
   {
@@ -63,4 +141,5 @@ int main()
     sleep(3);
     print("thread loop exits");
   }
+  return g_failures == 0 ? 0 : 1;
 }
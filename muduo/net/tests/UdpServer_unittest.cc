@@ -0,0 +1,139 @@
+#include "muduo/net/UdpServer.h"
+
+#include "muduo/base/Atomic.h"
+#include "muduo/net/EventLoop.h"
+#include "muduo/net/UdpClient.h"
+
+#include <set>
+
+//#define BOOST_TEST_MODULE UdpServerTest
+#define BOOST_TEST_MAIN
+#define BOOST_TEST_DYN_LINK
+#include <boost/test/unit_test.hpp>
+
+using namespace muduo;
+using namespace muduo::net;
+
+namespace
+{
+
+void echo(const UdpSocketPtr& sock, const InetAddress& peer, StringPiece datagram, Timestamp)
+{
+  sock->send(peer, datagram);
+}
+
+}  // namespace
+
+BOOST_AUTO_TEST_CASE(testUdpEcho)
+{
+  const int kDatagrams = 1000;
+  // or the socket buffers overflow
+  const int kWindow = 64;
+  EventLoop loop;
+  UdpServer server(&loop, InetAddress(0, true), "UdpEcho");
+  server.setMessageCallback(echo);
+  server.start();
+
+  UdpClient client(&loop, InetAddress("127.0.0.1", server.listenAddress().port()), "UdpEchoClient");
+  std::set<string> received;
+  int sent = 0;
+  client.setMessageCallback(
+      [&](const UdpSocketPtr& sock, const InetAddress& peer, StringPiece datagram, Timestamp) {
+        BOOST_CHECK_EQUAL(peer.port(), server.listenAddress().port());
+        received.insert(datagram.as_string());
+        if (received.size() == kDatagrams)
+        {
+          loop.quit();
+        }
+        else if (sent < kDatagrams)
+        {
+          sock->send(std::to_string(sent++));
+        }
+      });
+  BOOST_REQUIRE(client.connect());
+  while (sent < kWindow)
+  {
+    client.send(std::to_string(sent++));
+  }
+  loop.runAfter(5.0, [&loop] { loop.quit(); });
+  loop.loop();
+
+  BOOST_CHECK_EQUAL(received.size(), kDatagrams);
+  BOOST_CHECK_EQUAL(server.sockets().front()->datagramsReceived(), kDatagrams);
+  BOOST_CHECK_EQUAL(server.sockets().front()->datagramsSent(), kDatagrams);
+  BOOST_CHECK_EQUAL(client.socket()->datagramsDropped(), 0);
+}
+
+BOOST_AUTO_TEST_CASE(testUdpReusePort)
+{
+  const int kClients = 64;
+  EventLoop loop;
+  UdpServer server(&loop, InetAddress(0, true), "UdpReusePort", UdpServer::kReusePort);
+  server.setThreadNum(4);
+  AtomicInt32 received;
+  server.setMessageCallback(
+      [&received](const UdpSocketPtr& sock, const InetAddress& peer, StringPiece datagram, Timestamp) {
+        received.increment();
+        sock->send(peer, datagram);
+      });
+  server.start();
+  BOOST_CHECK_EQUAL(server.sockets().size(), 4u);
+
+  // peers are spread by hash of their ports
+  std::vector<std::unique_ptr<UdpClient>> clients;
+  int replies = 0;
+  for (int i = 0; i < kClients; ++i)
+  {
+    clients.emplace_back(new UdpClient(&loop, server.listenAddress(), "UdpClient"));
+    clients.back()->setMessageCallback(
+        [&](const UdpSocketPtr&, const InetAddress&, StringPiece, Timestamp) {
+          if (++replies == kClients)
+          {
+            loop.quit();
+          }
+        });
+    BOOST_REQUIRE(clients.back()->connect());
+    clients.back()->send("hello");
+  }
+  loop.runAfter(5.0, [&loop] { loop.quit(); });
+  loop.loop();
+
+  BOOST_CHECK_EQUAL(replies, kClients);
+  BOOST_CHECK_EQUAL(received.get(), kClients);
+  clients.clear();
+}
+
+BOOST_AUTO_TEST_CASE(testUdpSegments)
+{
+  EventLoop loop;
+  UdpServer server(&loop, InetAddress(0, true), "UdpGro");
+  std::vector<string> received;
+  server.setMessageCallback(
+      [&](const UdpSocketPtr&, const InetAddress&, StringPiece datagram, Timestamp) {
+        received.push_back(datagram.as_string());
+        if (received.size() == 10)
+        {
+          loop.quit();
+        }
+      });
+  // datagrams from GSO may come coalesced, and are split by their size
+  server.setGro(true);
+  server.start();
+
+  UdpClient client(&loop, server.listenAddress(), "UdpGsoClient");
+  BOOST_REQUIRE(client.connect());
+  string data;
+  for (int i = 0; i < 10; ++i)
+  {
+    data += string(i < 9 ? 1000 : 500, static_cast<char>('a' + i));
+  }
+  client.socket()->sendSegments(server.listenAddress(), data, 1000);
+  loop.runAfter(5.0, [&loop] { loop.quit(); });
+  loop.loop();
+
+  BOOST_REQUIRE_EQUAL(received.size(), 10u);
+  for (int i = 0; i < 10; ++i)
+  {
+    BOOST_CHECK_EQUAL(received[i], string(i < 9 ? 1000 : 500, static_cast<char>('a' + i)));
+  }
+}
@@ -0,0 +1,171 @@
+// Compares copying send(Buffer*) with MSG_ZEROCOPY for various message sizes.
+//
+// usage: zerocopy_bench [host port]
+// Without arguments, sends to an in-process discard server over loopback,
+// where the kernel always copies, so it only measures the overhead.
+// Run a discard server on another host for the real numbers.
+
+#include "muduo/base/Logging.h"
+#include "muduo/net/EventLoop.h"
+#include "muduo/net/EventLoopThread.h"
+#include "muduo/net/InetAddress.h"
+#include "muduo/net/TcpClient.h"
+#include "muduo/net/TcpServer.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+using namespace muduo;
+using namespace muduo::net;
+
+const uint16_t kPort = 2021;
+const int64_t kTotalBytes = 512*1024*1024;
+// keeps this many bytes queued in TcpConnection
+const size_t kQueuedBytes = 4*1024*1024;
+
+double threadCpuSeconds()
+{
+  struct timespec ts;
+  ::clock_gettime(CLOCK_THREAD_CPUTIME_ID, &ts);
+  return static_cast<double>(ts.tv_sec) + static_cast<double>(ts.tv_nsec) / 1e9;
+}
+
+class Sender : noncopyable
+{
+ public:
+  Sender(EventLoop* loop, const InetAddress& serverAddr, size_t messageSize, bool zeroCopy)
+    : loop_(loop),
+      client_(loop, serverAddr, "Sender"),
+      payload_(messageSize, 'Z'),
+      zeroCopy_(zeroCopy),
+      copied_(false),
+      bytesSent_(0),
+      seconds_(0),
+      cpuSeconds_(0),
+      cpuStart_(0)
+  {
+    client_.setConnectionCallback(
+        std::bind(&Sender::onConnection, this, _1));
+    client_.setWriteCompleteCallback(
+        std::bind(&Sender::onWriteComplete, this, _1));
+  }
+
+  void start()
+  {
+    client_.connect();
+  }
+
+  bool zeroCopy() const { return zeroCopy_; }
+  bool copied() const { return copied_; }
+  double seconds() const { return seconds_; }
+  double cpuSeconds() const { return cpuSeconds_; }
+
+ private:
+  void onConnection(const TcpConnectionPtr& conn)
+  {
+    if (conn->connected())
+    {
+      if (zeroCopy_)
+      {
+        conn->setZeroCopy(true, 1);
+        zeroCopy_ = conn->zeroCopy();
+      }
+      start_ = Timestamp::now();
+      cpuStart_ = threadCpuSeconds();
+      sendMore(conn);
+    }
+    else
+    {
+      loop_->quit();
+    }
+  }
+
+  void onWriteComplete(const TcpConnectionPtr& conn)
+  {
+    if (bytesSent_ < kTotalBytes)
+    {
+      sendMore(conn);
+    }
+    else if (seconds_ == 0)
+    {
+      seconds_ = timeDifference(Timestamp::now(), start_);
+      cpuSeconds_ = threadCpuSeconds() - cpuStart_;
+      // off if the kernel copied anyway, eg. on loopback
+      copied_ = zeroCopy_ && !conn->zeroCopy();
+      conn->shutdown();
+    }
+  }
+
+  void sendMore(const TcpConnectionPtr& conn)
+  {
+    while (bytesSent_ < kTotalBytes
+           && conn->outputBuffer()->readableBytes() < kQueuedBytes)
+    {
+      Buffer buf;
+      buf.append(payload_);
+      conn->send(&buf);
+      bytesSent_ += static_cast<int64_t>(payload_.size());
+    }
+  }
+
+  EventLoop* loop_;
+  TcpClient client_;
+  const string payload_;
+  bool zeroCopy_;
+  bool copied_;
+  int64_t bytesSent_;
+  Timestamp start_;
+  double seconds_;
+  double cpuSeconds_;
+  double cpuStart_;
+};
+
+void onDiscardMessage(const TcpConnectionPtr&, Buffer* buf, Timestamp)
+{
+  buf->retrieveAll();
+}
+
+int main(int argc, char* argv[])
+{
+  Logger::setLogLevel(Logger::WARN);
+
+  EventLoopThread discardThread;
+  EventLoop* discardLoop = NULL;
+  TcpServer* discardServer = NULL;
+  InetAddress serverAddr(kPort, true);
+  if (argc > 2)
+  {
+    serverAddr = InetAddress(argv[1], static_cast<uint16_t>(atoi(argv[2])));
+  }
+  else
+  {
+    discardLoop = discardThread.startLoop();
+    discardServer = new TcpServer(discardLoop, serverAddr, "Discard");
+    discardServer->setMessageCallback(onDiscardMessage);
+    discardLoop->runInLoop(std::bind(&TcpServer::start, discardServer));
+  }
+
+  printf("%10s %10s %10s %10s %10s\n", "size", "mode", "MiB/s", "cpu s", "MiB/cpu s");
+  const size_t sizes[] = { 4*1024, 16*1024, 64*1024, 256*1024, 1024*1024 };
+  for (size_t size : sizes)
+  {
+    for (int zeroCopy = 0; zeroCopy < 2; ++zeroCopy)
+    {
+      EventLoop loop;
+      Sender sender(&loop, serverAddr, size, zeroCopy != 0);
+      sender.start();
+      loop.loop();
+      double mib = static_cast<double>(kTotalBytes) / (1024*1024);
+      printf("%10zu %10s %10.1f %10.3f %10.1f\n", size,
+             sender.copied() ? "zc-copied" : (sender.zeroCopy() ? "zerocopy" : "copy"),
+             mib / sender.seconds(), sender.cpuSeconds(), mib / sender.cpuSeconds());
+    }
+  }
+
+  if (discardServer)
+  {
+    // TcpServer must be destroyed in its loop
+    discardLoop->runInLoop([discardServer] { delete discardServer; });
+  }
+}
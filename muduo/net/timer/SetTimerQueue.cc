@@ -0,0 +1,167 @@
+// Copyright 2010, Shuo Chen.  All rights reserved.
+// http://code.google.com/p/muduo/
+//
+// Use of this source code is governed by a BSD-style license
+// that can be found in the License file.
+
+// Author: Shuo Chen (chenshuo at chenshuo dot com)
+
+#ifndef __STDC_LIMIT_MACROS
+#define __STDC_LIMIT_MACROS
+#endif
+
+#include "muduo/net/timer/SetTimerQueue.h"
+
+#include "muduo/net/EventLoop.h"
+#include "muduo/net/Timer.h"
+#include "muduo/net/TimerId.h"
+
+#include <algorithm>
+#include <iterator>
+
+#include <assert.h>
+#include <stdint.h>
+
+using namespace muduo;
+using namespace muduo::net;
+
+SetTimerQueue::SetTimerQueue(EventLoop* loop)
+  : TimerQueue(loop),
+    timers_(),
+    callingExpiredTimers_(false)
+{
+}
+
+SetTimerQueue::~SetTimerQueue()
+{
+  for (const Entry& timer : timers_)
+  {
+    delete timer.second;
+  }
+}
+
+void SetTimerQueue::addTimerInLoop(Timer* timer)
+{
+  loop_->assertInLoopThread();
+  bool earliestChanged = insert(timer);
+
+  if (earliestChanged)
+  {
+    resetTimerfd(timer->expiration());
+  }
+}
+
+void SetTimerQueue::cancelInLoop(TimerId timerId)
+{
+  loop_->assertInLoopThread();
+  assert(timers_.size() == activeTimers_.size());
+  ActiveTimer timer(timerOf(timerId), sequenceOf(timerId));
+  ActiveTimerSet::iterator it = activeTimers_.find(timer);
+  if (it != activeTimers_.end())
+  {
+    size_t n = timers_.erase(Entry(it->first->expiration(), it->first));
+    assert(n == 1); (void)n;
+    delete it->first; // FIXME: no delete please
+    activeTimers_.erase(it);
+  }
+  else if (callingExpiredTimers_)
+  {
+    cancelingTimers_.insert(timer);
+  }
+  assert(timers_.size() == activeTimers_.size());
+}
+
+void SetTimerQueue::runExpired(Timestamp now)
+{
+  std::vector<Entry> expired = getExpired(now);
+
+  callingExpiredTimers_ = true;
+  cancelingTimers_.clear();
+  // safe to callback outside critical section
+  for (const Entry& it : expired)
+  {
+    runTimer(it.second);
+  }
+  callingExpiredTimers_ = false;
+
+  reset(expired, now);
+}
+
+std::vector<SetTimerQueue::Entry> SetTimerQueue::getExpired(Timestamp now)
+{
+  assert(timers_.size() == activeTimers_.size());
+  std::vector<Entry> expired;
+  Entry sentry(now, reinterpret_cast<Timer*>(UINTPTR_MAX));
+  TimerList::iterator end = timers_.lower_bound(sentry);
+  assert(end == timers_.end() || now < end->first);
+  std::copy(timers_.begin(), end, back_inserter(expired));
+  timers_.erase(timers_.begin(), end);
+
+  for (const Entry& it : expired)
+  {
+    ActiveTimer timer(it.second, it.second->sequence());
+    size_t n = activeTimers_.erase(timer);
+    assert(n == 1); (void)n;
+  }
+
+  assert(timers_.size() == activeTimers_.size());
+  return expired;
+}
+
+void SetTimerQueue::reset(const std::vector<Entry>& expired, Timestamp now)
+{
+  Timestamp nextExpire;
+
+  for (const Entry& it : expired)
+  {
+    ActiveTimer timer(it.second, it.second->sequence());
+    if (it.second->repeat()
+        && cancelingTimers_.find(timer) == cancelingTimers_.end())
+    {
+      it.second->restart(now);
+      insert(it.second);
+    }
+    else
+    {
+      // FIXME move to a free list
+      delete it.second; // FIXME: no delete please
+    }
+  }
+
+  if (!timers_.empty())
+  {
+    nextExpire = timers_.begin()->second->expiration();
+  }
+
+  if (nextExpire.valid())
+  {
+    resetTimerfd(nextExpire);
+  }
+}
+
+bool SetTimerQueue::insert(Timer* timer)
+{
+  loop_->assertInLoopThread();
+  assert(timers_.size() == activeTimers_.size());
+  bool earliestChanged = false;
+  Timestamp when = timer->expiration();
+  TimerList::iterator it = timers_.begin();
+  if (it == timers_.end() || when < it->first)
+  {
+    earliestChanged = true;
+  }
+  {
+    std::pair<TimerList::iterator, bool> result
+      = timers_.insert(Entry(when, timer));
+    assert(result.second); (void)result;
+  }
+  {
+    std::pair<ActiveTimerSet::iterator, bool> result
+      = activeTimers_.insert(ActiveTimer(timer, timer->sequence()));
+    assert(result.second); (void)result;
+  }
+
+  assert(timers_.size() == activeTimers_.size());
+  return earliestChanged;
+}
+
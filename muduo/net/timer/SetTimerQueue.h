@@ -0,0 +1,62 @@
+// Copyright 2010, Shuo Chen.  All rights reserved.
+// http://code.google.com/p/muduo/
+//
+// Use of this source code is governed by a BSD-style license
+// that can be found in the License file.
+
+// Author: Shuo Chen (chenshuo at chenshuo dot com)
+//
+// This is an internal header file, you should not include this.
+
+#ifndef MUDUO_NET_TIMER_SETTIMERQUEUE_H
+#define MUDUO_NET_TIMER_SETTIMERQUEUE_H
+
+#include "muduo/net/TimerQueue.h"
+
+#include <set>
+#include <vector>
+
+namespace muduo
+{
+namespace net
+{
+
+///
+/// Timers sorted by expiration in std::set.
+///
+class SetTimerQueue : public TimerQueue
+{
+ public:
+  explicit SetTimerQueue(EventLoop* loop);
+  ~SetTimerQueue() override;
+
+ private:
+  // FIXME: use unique_ptr<Timer> instead of raw pointers.
+  // This requires heterogeneous comparison lookup (N3465) from C++14
+  // so that we can find an T* in a set<unique_ptr<T>>.
+  typedef std::pair<Timestamp, Timer*> Entry;
+  typedef std::set<Entry> TimerList;
+  typedef std::pair<Timer*, int64_t> ActiveTimer;
+  typedef std::set<ActiveTimer> ActiveTimerSet;
+
+  void addTimerInLoop(Timer* timer) override;
+  void cancelInLoop(TimerId timerId) override;
+  void runExpired(Timestamp now) override;
+  // move out all expired timers
+  std::vector<Entry> getExpired(Timestamp now);
+  void reset(const std::vector<Entry>& expired, Timestamp now);
+
+  bool insert(Timer* timer);
+
+  // Timer list sorted by expiration
+  TimerList timers_;
+
+  // for cancel()
+  ActiveTimerSet activeTimers_;
+  bool callingExpiredTimers_; /* atomic */
+  ActiveTimerSet cancelingTimers_;
+};
+
+}  // namespace net
+}  // namespace muduo
+#endif  // MUDUO_NET_TIMER_SETTIMERQUEUE_H
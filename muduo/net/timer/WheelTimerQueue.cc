@@ -0,0 +1,274 @@
+// Use of this source code is governed by a BSD-style license
+// that can be found in the License file.
+
+#include "muduo/net/timer/WheelTimerQueue.h"
+
+#include "muduo/net/EventLoop.h"
+#include "muduo/net/Timer.h"
+#include "muduo/net/TimerId.h"
+
+#include <algorithm>
+
+#include <assert.h>
+
+using namespace muduo;
+using namespace muduo::net;
+
+const int64_t WheelTimerQueue::kTickMicroSeconds;
+const int WheelTimerQueue::kBitsPerLevel;
+const int WheelTimerQueue::kSlotsPerLevel;
+const int WheelTimerQueue::kNumLevels;
+
+namespace
+{
+
+static_assert(WheelTimerQueue::kSlotsPerLevel == 64, "a slot bitmap is uint64_t");
+const int64_t kSlotMask = WheelTimerQueue::kSlotsPerLevel - 1;
+
+// ticks covered by a slot of level
+int64_t ticksPerSlot(int level)
+{
+  return 1LL << (WheelTimerQueue::kBitsPerLevel * level);
+}
+
+int64_t tickOf(Timestamp when)
+{
+  return when.microSecondsSinceEpoch() / WheelTimerQueue::kTickMicroSeconds;
+}
+
+}  // namespace
+
+WheelTimerQueue::WheelTimerQueue(EventLoop* loop)
+  : TimerQueue(loop),
+    currentTick_(tickOf(Timestamp::now())),
+    wakeupTick_(-1),
+    callingExpiredTimers_(false)
+{
+  std::fill_n(&slots_[0][0], kNumLevels * kSlotsPerLevel, static_cast<Timer*>(NULL));
+  std::fill_n(occupied_, kNumLevels, 0);
+}
+
+WheelTimerQueue::~WheelTimerQueue()
+{
+  for (const auto& it : activeTimers_)
+  {
+    delete it.second;
+  }
+}
+
+void WheelTimerQueue::addTimerInLoop(Timer* timer)
+{
+  loop_->assertInLoopThread();
+  if (activeTimers_.empty())
+  {
+    // nothing to expire, catch up with the clock for free
+    currentTick_ = std::max(currentTick_, tickOf(EventLoop::cachedNow()));
+  }
+  insert(timer);
+  resetWakeup();
+}
+
+void WheelTimerQueue::cancelInLoop(TimerId timerId)
+{
+  loop_->assertInLoopThread();
+  const int64_t sequence = sequenceOf(timerId);
+  std::unordered_map<int64_t, Timer*>::iterator it = activeTimers_.find(sequence);
+  if (it != activeTimers_.end())
+  {
+    assert(it->second == timerOf(timerId));
+    unlink(it->second);
+    delete it->second; // FIXME: no delete please
+    activeTimers_.erase(it);
+  }
+  else if (callingExpiredTimers_)
+  {
+    cancelingTimers_.insert(sequence);
+  }
+}
+
+void WheelTimerQueue::runExpired(Timestamp now)
+{
+  wakeupTick_ = -1;  // it has fired
+  const int64_t nowTick = tickOf(now);
+  int64_t tick = nextTick();
+  while (tick >= 0 && tick <= nowTick)
+  {
+    currentTick_ = tick;
+    for (int level = kNumLevels - 1; level > 0; --level)
+    {
+      if ((tick & (ticksPerSlot(level) - 1)) == 0)
+      {
+        cascade(level);
+      }
+    }
+
+    // the whole slot expires
+    const int index = static_cast<int>(tick & kSlotMask);
+    Timer* timer = slots_[0][index];
+    slots_[0][index] = NULL;
+    occupied_[0] &= ~(1ULL << index);
+    while (timer)
+    {
+      Timer* next = timer->next_;
+      timer->slot_ = -1;
+      size_t n = activeTimers_.erase(timer->sequence());
+      assert(n == 1); (void)n;
+      expired_.push_back(timer);
+      timer = next;
+    }
+    tick = nextTick();
+  }
+  currentTick_ = std::max(currentTick_, nowTick);
+
+  callingExpiredTimers_ = true;
+  cancelingTimers_.clear();
+  for (Timer* timer : expired_)
+  {
+    runTimer(timer);
+  }
+  callingExpiredTimers_ = false;
+
+  for (Timer* timer : expired_)
+  {
+    if (timer->repeat()
+        && cancelingTimers_.find(timer->sequence()) == cancelingTimers_.end())
+    {
+      timer->restart(now);
+      insert(timer);
+    }
+    else
+    {
+      delete timer; // FIXME: no delete please
+    }
+  }
+  expired_.clear();
+  resetWakeup();
+}
+
+void WheelTimerQueue::insert(Timer* timer)
+{
+  link(timer, currentTick_ + 1);
+  std::pair<std::unordered_map<int64_t, Timer*>::iterator, bool> result
+    = activeTimers_.insert(std::make_pair(timer->sequence(), timer));
+  assert(result.second); (void)result;
+}
+
+void WheelTimerQueue::link(Timer* timer, int64_t minTick)
+{
+  // rounds up, never fires early
+  const int64_t when = timer->expiration().microSecondsSinceEpoch();
+  int64_t tick = std::max((when + kTickMicroSeconds - 1) / kTickMicroSeconds, minTick);
+  if (tick - currentTick_ >= ticksPerSlot(kNumLevels))
+  {
+    // cascaded again when the last level comes to it
+    tick = currentTick_ + ticksPerSlot(kNumLevels) - 1;
+  }
+  int level = 0;
+  while (tick - currentTick_ >= ticksPerSlot(level + 1))
+  {
+    ++level;
+  }
+  const int index = static_cast<int>((tick >> (kBitsPerLevel * level)) & kSlotMask);
+
+  // appends, head->prev_ is the tail
+  Timer*& head = slots_[level][index];
+  timer->next_ = NULL;
+  if (head)
+  {
+    timer->prev_ = head->prev_;
+    head->prev_->next_ = timer;
+    head->prev_ = timer;
+  }
+  else
+  {
+    timer->prev_ = timer;
+    head = timer;
+    occupied_[level] |= 1ULL << index;
+  }
+  timer->slot_ = level * kSlotsPerLevel + index;
+}
+
+void WheelTimerQueue::unlink(Timer* timer)
+{
+  assert(timer->slot_ >= 0);
+  const int level = timer->slot_ / kSlotsPerLevel;
+  const int index = timer->slot_ % kSlotsPerLevel;
+  Timer*& head = slots_[level][index];
+  if (timer == head)
+  {
+    head = timer->next_;
+    if (head)
+    {
+      head->prev_ = timer->prev_;
+    }
+    else
+    {
+      occupied_[level] &= ~(1ULL << index);
+    }
+  }
+  else
+  {
+    timer->prev_->next_ = timer->next_;
+    if (timer->next_)
+    {
+      timer->next_->prev_ = timer->prev_;
+    }
+    else
+    {
+      head->prev_ = timer->prev_;
+    }
+  }
+  timer->prev_ = timer->next_ = NULL;
+  timer->slot_ = -1;
+}
+
+void WheelTimerQueue::cascade(int level)
+{
+  const int index = static_cast<int>((currentTick_ >> (kBitsPerLevel * level)) & kSlotMask);
+  Timer* timer = slots_[level][index];
+  slots_[level][index] = NULL;
+  occupied_[level] &= ~(1ULL << index);
+  while (timer)
+  {
+    Timer* next = timer->next_;
+    link(timer, currentTick_);
+    timer = next;
+  }
+}
+
+int64_t WheelTimerQueue::nextTick() const
+{
+  int64_t next = -1;
+  if (occupied_[0])
+  {
+    // level 0 holds ticks after currentTick_, in order from its slot
+    const int start = static_cast<int>((currentTick_ + 1) & kSlotMask);
+    uint64_t bits = occupied_[0];
+    bits = start == 0 ? bits : (bits >> start) | (bits << (kSlotsPerLevel - start));
+    next = currentTick_ + 1 + __builtin_ctzll(bits);
+  }
+  for (int level = 1; level < kNumLevels; ++level)
+  {
+    if (occupied_[level])
+    {
+      // cascade, no later than timers of higher levels
+      const int64_t boundary = (currentTick_ / ticksPerSlot(level) + 1) * ticksPerSlot(level);
+      if (next < 0 || boundary < next)
+      {
+        next = boundary;
+      }
+      break;
+    }
+  }
+  return next;
+}
+
+void WheelTimerQueue::resetWakeup()
+{
+  const int64_t tick = nextTick();
+  if (tick >= 0 && (wakeupTick_ < 0 || tick < wakeupTick_))
+  {
+    wakeupTick_ = tick;
+    resetTimerfd(Timestamp(tick * kTickMicroSeconds));
+  }
+}
@@ -0,0 +1,70 @@
+// Use of this source code is governed by a BSD-style license
+// that can be found in the License file.
+//
+// This is an internal header file, you should not include this.
+
+#ifndef MUDUO_NET_TIMER_WHEELTIMERQUEUE_H
+#define MUDUO_NET_TIMER_WHEELTIMERQUEUE_H
+
+#include "muduo/net/TimerQueue.h"
+
+#include <set>
+#include <unordered_map>
+#include <vector>
+
+namespace muduo
+{
+namespace net
+{
+
+///
+/// Timers in a hierarchical timing wheel of 1 millisecond ticks.
+///
+/// Adding and canceling are O(1), timers of the same tick expire in one
+/// batch, and a timer may fire up to one tick late.
+///
+/// Level i has 64 slots of 64^i ticks. Timers of a slot are moved down
+/// to lower levels when the wheel reaches it, ones beyond the last level
+/// wait in its slots.
+///
+class WheelTimerQueue : public TimerQueue
+{
+ public:
+  static const int64_t kTickMicroSeconds = 1000;
+  static const int kBitsPerLevel = 6;
+  static const int kSlotsPerLevel = 1 << kBitsPerLevel;
+  static const int kNumLevels = 6;  // 64^6 ticks, about 2 years
+
+  explicit WheelTimerQueue(EventLoop* loop);
+  ~WheelTimerQueue() override;
+
+ private:
+  void addTimerInLoop(Timer* timer) override;
+  void cancelInLoop(TimerId timerId) override;
+  void runExpired(Timestamp now) override;
+
+  // into the slot of its expiration, no earlier than minTick
+  void link(Timer* timer, int64_t minTick);
+  void unlink(Timer* timer);
+  void insert(Timer* timer);
+  // moves timers of the slot at currentTick_ to lower levels
+  void cascade(int level);
+  // next tick to process, -1 if empty
+  int64_t nextTick() const;
+  void resetWakeup();
+
+  int64_t currentTick_;  // processed up to it
+  int64_t wakeupTick_;  // timerfd set to, -1 if not set
+  Timer* slots_[kNumLevels][kSlotsPerLevel];
+  uint64_t occupied_[kNumLevels];  // bitmap of non-empty slots
+
+  // for cancel(), by sequence
+  std::unordered_map<int64_t, Timer*> activeTimers_;
+  std::vector<Timer*> expired_;
+  bool callingExpiredTimers_; /* atomic */
+  std::set<int64_t> cancelingTimers_;
+};
+
+}  // namespace net
+}  // namespace muduo
+#endif  // MUDUO_NET_TIMER_WHEELTIMERQUEUE_H